@@ -0,0 +1,211 @@
+/*
+  CycleTrace.cpp	Scoped timers timed with the CPU cycle counter, dumped in the
+			Chrome Trace Event format.
+*/
+
+#include "CycleTrace.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined (ESP32)
+  #include <Arduino.h>
+  #include "esp_timer.h"
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#else
+  #include <chrono>
+  #include <functional>
+  #include <thread>
+#endif
+
+CycleTrace cycleTrace;
+
+#if defined (ESP32)
+static inline uint32_t cycles() {
+	uint32_t ccount;
+	__asm__ __volatile__("rsr %0, ccount" : "=a" (ccount));
+	return ccount;
+}
+
+static inline uint64_t timerTicks() {
+	return (uint64_t) esp_timer_get_time() * TRACE_TICKS_PER_US;
+}
+#else
+// On a PC a cycle is a nanosecond
+static inline uint32_t cycles() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline uint64_t timerTicks() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() * TRACE_TICKS_PER_US / 1000;
+}
+
+static std::atomic_flag hostLock = ATOMIC_FLAG_INIT;
+#endif
+
+// The rings are not initialized by the constructor : the scopes of the static constructors which run before it
+// find a disabled trace, the rings start at zero as all the global variables.
+CycleTrace::CycleTrace() : _cyclesPerTick(1), _enabled(false) {}
+
+void CycleTrace::begin() {
+#if defined (ESP32)
+	_cyclesPerTick = getCpuFrequencyMhz() / TRACE_TICKS_PER_US;
+#else
+	_cyclesPerTick = 1000 / TRACE_TICKS_PER_US;
+#endif
+	if (_cyclesPerTick == 0) {_cyclesPerTick = 1;}
+	enable(true);
+}
+
+uint64_t CycleTrace::now() const {
+	return timerTicks();
+}
+
+void CycleTrace::event(const char *name, char phase) {
+	if (!enabled()) {return;}
+#if defined (ESP32)
+	uint32_t task = (uint32_t) (uintptr_t) xTaskGetCurrentTaskHandle();
+	UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+	uint8_t core = xPortGetCoreID();
+	uint32_t tick = xTaskGetTickCount();
+	const uint32_t refPeriod = pdMS_TO_TICKS(TRACE_REF_PERIOD);
+#else
+	uint32_t task = std::hash<std::thread::id>()(std::this_thread::get_id());
+	while (hostLock.test_and_set(std::memory_order_acquire)) {}
+	uint8_t core = 0;
+	uint32_t tick = timerTicks() / (1000 * TRACE_TICKS_PER_US);
+	const uint32_t refPeriod = TRACE_REF_PERIOD;
+#endif
+	uint32_t cc = cycles();
+	Core &c = _cores[core];
+	if (c.refTicks == 0 || tick - c.refTick >= refPeriod) {
+		c.refCycles = cc;
+		c.refTicks = timerTicks();
+		c.refTick = tick;
+	}
+	uint64_t time = c.refTicks + (cc - c.refCycles) / _cyclesPerTick;
+
+	uint32_t index = c.head.load(std::memory_order_relaxed);
+	Slot &s = c.slots[index & (TRACE_EVENTS - 1)];
+	s.seq.store(2 * index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s.name.store(name, std::memory_order_relaxed);
+	s.timeLow.store((uint32_t) time, std::memory_order_relaxed);
+	s.timeHigh.store((uint32_t) (time >> 32), std::memory_order_relaxed);
+	s.task.store(task, std::memory_order_relaxed);
+	s.info.store((uint8_t) phase | (core << 8), std::memory_order_relaxed);
+	s.seq.store(2 * index + 2, std::memory_order_release);
+	c.head.store(index + 1, std::memory_order_release);
+#if defined (ESP32)
+	portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+#else
+	hostLock.clear(std::memory_order_release);
+#endif
+}
+
+void CycleTrace::startRead(TraceCursor &cursor) const {
+	memset(&cursor, 0, sizeof(cursor));
+	for (uint8_t core = 0; core < TRACE_CORES; core++) {
+		uint32_t head = _cores[core].head.load(std::memory_order_acquire);
+		cursor.next[core] = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+		cursor.end[core] = head;
+	}
+#if defined (ESP32) && (configUSE_TRACE_FACILITY == 1)
+	// names of the tasks running now, the events of the deleted tasks keep their number
+	UBaseType_t count = uxTaskGetNumberOfTasks() + 2;
+	TaskStatus_t *tasks = new TaskStatus_t[count];
+	count = uxTaskGetSystemState(tasks, count, NULL);
+	for (UBaseType_t i = 0; (i < count) && (cursor.taskNames < TRACE_TASK_NAMES); i++) {
+		cursor.tasks[cursor.taskNames].task = (uint32_t) (uintptr_t) tasks[i].xHandle;
+		strncpy(cursor.tasks[cursor.taskNames].name, tasks[i].pcTaskName, sizeof(cursor.tasks[0].name) - 1);
+		cursor.taskNames++;
+	}
+	delete[] tasks;
+#endif
+}
+
+// Copies the next event of a core without moving the cursor past it, skips the overwritten events
+bool CycleTrace::peek(TraceCursor &cursor, uint8_t core, TraceEvent &e) const {
+	const Core &c = _cores[core];
+	for (; cursor.next[core] != cursor.end[core]; cursor.next[core]++, cursor.lost++) {
+		uint32_t index = cursor.next[core];
+		const Slot &s = c.slots[index & (TRACE_EVENTS - 1)];
+		uint32_t seq = s.seq.load(std::memory_order_acquire);
+		e.name = s.name.load(std::memory_order_relaxed);
+		e.time = s.timeLow.load(std::memory_order_relaxed) | (uint64_t) s.timeHigh.load(std::memory_order_relaxed) << 32;
+		e.task = s.task.load(std::memory_order_relaxed);
+		uint32_t info = s.info.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seq == 2 * index + 2 && s.seq.load(std::memory_order_relaxed) == seq) {
+			e.phase = (char) (info & 0xFF);
+			e.core = info >> 8;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CycleTrace::read(TraceCursor &cursor, TraceEvent &e) const {
+	int oldest = -1;
+	TraceEvent candidate;
+	for (uint8_t core = 0; core < TRACE_CORES; core++) {
+		if (!peek(cursor, core, candidate)) {continue;}
+		if (oldest < 0 || candidate.time < e.time) {
+			e = candidate;
+			oldest = core;
+		}
+	}
+	if (oldest < 0) {return false;}
+	cursor.next[oldest]++;
+	return true;
+}
+
+// One line of JSON per event. The last line, the name of the process, closes the array. A line which does not
+// fit in a chunk is continued in the next one.
+size_t CycleTrace::fillJson(TraceCursor &cursor, uint8_t *buffer, size_t maxLen) const {
+	size_t n = 0;
+	while (n < maxLen) {
+		if (cursor.sent < cursor.length) {
+			size_t len = cursor.length - cursor.sent;
+			if (len > maxLen - n) {len = maxLen - n;}
+			memcpy(buffer + n, cursor.pending + cursor.sent, len);
+			cursor.sent += len;
+			n += len;
+			continue;
+		}
+		int len;
+		TraceEvent e;
+		if (cursor.line == 0) {
+			len = snprintf(cursor.pending, sizeof(cursor.pending), "{\"traceEvents\":[\n");
+			cursor.line++;
+		}
+		else if (cursor.line <= cursor.taskNames) {
+			len = snprintf(cursor.pending, sizeof(cursor.pending), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+			               (unsigned) cursor.tasks[cursor.line - 1].task, cursor.tasks[cursor.line - 1].name);
+			cursor.line++;
+		}
+		else if (cursor.line == TRACE_DUMP_END) {break;}
+		else if (read(cursor, e)) {
+			int t = 0;
+			while (t < cursor.taskNames && cursor.tasks[t].task != e.task) {t++;}
+			if (t < cursor.taskNames) {
+				if (e.phase == 'B') {cursor.tasks[t].depth++;}
+				else if (cursor.tasks[t].depth == 0) {continue;} // its begin event was overwritten
+				else {cursor.tasks[t].depth--;}
+			}
+			len = snprintf(cursor.pending, sizeof(cursor.pending), "{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%llu.%03u,\"args\":{\"core\":%u}},\n",
+			               e.name, e.phase, (unsigned) e.task, (unsigned long long) (e.time / TRACE_TICKS_PER_US),
+			               (unsigned) (e.time % TRACE_TICKS_PER_US * 1000 / TRACE_TICKS_PER_US), (unsigned) e.core);
+		}
+		else {
+			len = snprintf(cursor.pending, sizeof(cursor.pending), "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ESP32\"}}\n],\"otherData\":{\"lost\":%u}}\n",
+			               (unsigned) cursor.lost);
+			cursor.line = TRACE_DUMP_END;
+		}
+		if (len < 0) {len = 0;}
+		if (len >= (int) sizeof(cursor.pending)) {len = sizeof(cursor.pending) - 1;} // a very long name is cut
+		cursor.length = len;
+		cursor.sent = 0;
+	}
+	return n;
+}
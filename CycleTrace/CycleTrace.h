@@ -0,0 +1,125 @@
+/*
+  CycleTrace.h		Scoped timers timed with the CPU cycle counter, dumped in the
+			Chrome Trace Event format (chrome://tracing, ui.perfetto.dev).
+
+  A TraceScope writes a begin event when it is built and an end event when it
+  goes out of scope, with the task and the core which ran it. The events are
+  kept in a ring per core : the last TRACE_EVENTS events of each core, older
+  ones are overwritten. A write takes a few hundred cycles and no lock : the
+  interrupts of the writer's core are masked during the write, so that no other
+  task or interrupt handler writes in the ring of that core meanwhile, and the
+  other core never writes in it. A reader on any core checks the sequence number
+  of each slot and skips the events overwritten while it reads them.
+
+  The cycle counter of each core runs at the CPU frequency and wraps every few
+  seconds. The time of an event is the cycles since a reference taken on the
+  same core with esp_timer_get_time() (common to both cores), renewed every
+  TRACE_REF_PERIOD ms : the times of the two cores can be compared. It is kept
+  in ticks of 1 / TRACE_TICKS_PER_US us.
+
+  The name of an event must be a string which is never freed (a literal).
+  On a PC the events go in the ring of core 0 under a spin lock, for tests.
+*/
+#ifndef CYCLETRACE_H_
+#define CYCLETRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define TRACE_EVENTS 256            // ring of each core, a power of 2 (24 bytes per event)
+#define TRACE_CORES 2
+#define TRACE_TICKS_PER_US 8
+#define TRACE_REF_PERIOD 4000       // ms, less than half the wrap of the cycle counter at 240 MHz (17.9 s)
+#define TRACE_TASK_NAMES 24         // tasks named in a dump
+#define TRACE_DUMP_END 0xFFFF
+
+struct TraceEvent {
+	const char *name;
+	uint64_t time;      // ticks since the start
+	uint32_t task;      // FreeRTOS task handle (thread number on a PC)
+	char phase;         // 'B' begin, 'E' end
+	uint8_t core;
+};
+
+// Position of a reader in the rings : the events of both cores are read in time order. Plain data, it can be
+// copied in the state of a chunked response.
+struct TraceCursor {
+	uint32_t next[TRACE_CORES];     // index of the next event of each core
+	uint32_t end[TRACE_CORES];      // index of the first event written after the cursor was set
+	uint32_t lost;                  // events overwritten before they were read
+	uint16_t line;                  // header and task name lines of the JSON dump written, TRACE_DUMP_END at the end
+	char pending[192];              // line being written
+	uint8_t length, sent;           // its length and the bytes already in a chunk
+	uint8_t taskNames;              // tasks named in the dump
+	struct {
+		uint32_t task;
+		uint8_t depth;              // scopes begun and not ended, the end events of older scopes are dropped
+		char name[16];
+	} tasks[TRACE_TASK_NAMES];
+};
+
+class CycleTrace
+{
+  public:
+	CycleTrace();
+
+	// Starts tracing, after the CPU frequency is set
+	void begin();
+	void enable(bool on) {_enabled.store(on, std::memory_order_relaxed);}
+	bool enabled() const {return _enabled.load(std::memory_order_relaxed);}
+
+	// Any task on any core
+	void event(const char *name, char phase);
+
+	// Current time in ticks
+	uint64_t now() const;
+
+	// Sets a cursor on the events in the rings now : the events written afterwards are not read
+	void startRead(TraceCursor &cursor) const;
+	// Copies the next event in time order, false at the end
+	bool read(TraceCursor &cursor, TraceEvent &e) const;
+	// Writes the events as a Chrome trace JSON document in chunks of at most maxLen bytes, returns the length of
+	// the chunk, 0 at the end
+	size_t fillJson(TraceCursor &cursor, uint8_t *buffer, size_t maxLen) const;
+
+  private:
+	struct Slot {
+		std::atomic<uint32_t> seq;      // 2 x index + 1 during the write, 2 x index + 2 once written
+		std::atomic<const char *> name;
+		std::atomic<uint32_t> timeLow, timeHigh;
+		std::atomic<uint32_t> task;
+		std::atomic<uint32_t> info;     // phase | core << 8
+	};
+
+	struct Core {
+		std::atomic<uint32_t> head;     // index of the next event
+		uint32_t refCycles;             // cycle counter at the reference
+		uint64_t refTicks;              // and the time, 0 before the first event
+		uint32_t refTick;               // FreeRTOS tick of the reference
+		Slot slots[TRACE_EVENTS];
+	};
+
+	bool peek(TraceCursor &cursor, uint8_t core, TraceEvent &e) const;
+
+	Core _cores[TRACE_CORES];
+	uint32_t _cyclesPerTick;
+	std::atomic<bool> _enabled;
+};
+
+extern CycleTrace cycleTrace;
+
+// Traces the rest of the block under name
+class TraceScope
+{
+  public:
+	explicit TraceScope(const char *name) : _name(name) {cycleTrace.event(name, 'B');}
+	~TraceScope() {cycleTrace.event(_name, 'E');}
+
+  private:
+	const char *_name;
+};
+
+#define TRACE_SCOPE(name) TraceScope traceScope(name)
+
+#endif
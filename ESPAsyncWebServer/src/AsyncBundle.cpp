@@ -0,0 +1,233 @@
+/*
+  Asynchronous WebServer library for Espressif MCUs
+
+  Copyright (c) 2016 Hristo Gochkov. All rights reserved.
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "AsyncBundle.h"
+
+#ifdef ESP32
+#include "esp_partition.h"
+#endif
+
+/*
+ * Bundle
+ * */
+
+AsyncBundle::AsyncBundle()
+  : _image(NULL)
+  , _size(0)
+  , _count(0)
+#ifdef ESP32
+  , _mmapHandle(0)
+  , _mapped(false)
+#endif
+{}
+
+AsyncBundle::~AsyncBundle(){
+  end();
+}
+
+uint32_t AsyncBundle::crc32(const uint8_t *data, size_t len, uint32_t crc){
+  // same polynomial and conditioning as zlib.crc32()
+  crc = ~crc;
+  while(len--){
+    crc ^= *data++;
+    for(uint8_t bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+bool AsyncBundle::_validate(bool checkCrc){
+  AsyncBundleHeader header;
+  if(_size < sizeof(header))
+    return false;
+  memcpy(&header, _image, sizeof(header));
+  if(memcmp(header.magic, ASYNC_BUNDLE_MAGIC, sizeof(header.magic)) != 0 || header.version != ASYNC_BUNDLE_VERSION)
+    return false;
+  if(header.size > _size || sizeof(header) + header.count * sizeof(AsyncBundleEntry) > header.size)
+    return false;
+  if(checkCrc && crc32(_image + sizeof(header), header.size - sizeof(header)) != header.crc)
+    return false;
+
+  // every blob must lie inside the image, every string must be terminated
+  const AsyncBundleEntry *entries = (const AsyncBundleEntry *)(_image + sizeof(header));
+  for(uint16_t i = 0; i < header.count; i++){
+    const AsyncBundleEntry *e = &entries[i];
+    if(e->url[ASYNC_BUNDLE_URL_LENGTH - 1] || e->type[ASYNC_BUNDLE_TYPE_LENGTH - 1])
+      return false;
+    if(e->offset > header.size || e->length > header.size - e->offset)
+      return false;
+  }
+  _size = header.size;
+  _count = header.count;
+  return true;
+}
+
+bool AsyncBundle::begin(const uint8_t *image, size_t size, bool checkCrc){
+  end();
+  _image = image;
+  _size = size;
+  if(!image || !_validate(checkCrc)){
+    _image = NULL;
+    _size = 0;
+    return false;
+  }
+  return true;
+}
+
+#ifdef ESP32
+bool AsyncBundle::begin(const char *label, bool checkCrc){
+  end();
+  const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+  if(!partition)
+    return false;
+  const void *ptr;
+  spi_flash_mmap_handle_t handle;
+  if(esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &ptr, &handle) != ESP_OK)
+    return false;
+  if(!begin((const uint8_t *)ptr, partition->size, checkCrc)){
+    spi_flash_munmap(handle);
+    return false;
+  }
+  _mmapHandle = handle;
+  _mapped = true;
+  return true;
+}
+#endif
+
+void AsyncBundle::end(){
+#ifdef ESP32
+  if(_mapped){
+    spi_flash_munmap(_mmapHandle);
+    _mapped = false;
+  }
+#endif
+  _image = NULL;
+  _size = 0;
+  _count = 0;
+}
+
+const AsyncBundleEntry* AsyncBundle::entry(size_t index) const {
+  if(!_image || index >= _count)
+    return NULL;
+  return (const AsyncBundleEntry *)(_image + sizeof(AsyncBundleHeader)) + index;
+}
+
+const AsyncBundleEntry* AsyncBundle::find(const char *url) const {
+  for(size_t i = 0; i < _count; i++){
+    const AsyncBundleEntry *e = entry(i);
+    if(strcmp(e->url, url) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+/*
+ * Bundle Response
+ * */
+
+AsyncBundleResponse::AsyncBundleResponse(const AsyncBundle& bundle, const AsyncBundleEntry *entry){
+  _code = 200;
+  _content = bundle.data(entry);
+  _contentLength = entry->length;
+  _contentType = entry->type;
+  if(entry->flags & ASYNC_BUNDLE_GZIP)
+    addHeader("Content-Encoding", "gzip");
+  addHeader("Cache-Control", (entry->flags & ASYNC_BUNDLE_IMMUTABLE) ? ASYNC_BUNDLE_CACHE_IMMUTABLE : ASYNC_BUNDLE_CACHE_REVALIDATE);
+  addHeader("ETag", String(entry->crc, HEX));
+}
+
+void AsyncBundleResponse::_respond(AsyncWebServerRequest *request){
+  addHeader("Connection","close");
+  _head = _assembleHead(request->version());
+  _state = RESPONSE_HEADERS;
+  _ack(request, 0, 0);
+}
+
+size_t AsyncBundleResponse::_ack(AsyncWebServerRequest *request, size_t len, uint32_t time){
+  (void)time;
+  _ackedLength += len;
+  AsyncClient *client = request->client();
+  size_t written = 0;
+
+  if(_state == RESPONSE_HEADERS){
+    size_t space = client->space();
+    size_t headLen = _head.length();
+    if(space < headLen){
+      written = client->add(_head.c_str(), space);
+      _head = _head.substring(written);
+    } else {
+      written = client->add(_head.c_str(), headLen);
+      _head = String();
+      _state = RESPONSE_CONTENT;
+    }
+  }
+
+  if(_state == RESPONSE_CONTENT){
+    // the image stays mapped as long as the bundle lives: the TCP stack may
+    // reference the flash data instead of copying it
+    size_t space = client->space();
+    size_t left = _contentLength - _sentLength;
+    size_t outLen = (left > space) ? space : left;
+    if(outLen){
+      size_t added = client->add((const char *)_content + _sentLength, outLen, 0);
+      _sentLength += added;
+      written += added;
+    }
+    if(_sentLength == _contentLength)
+      _state = RESPONSE_WAIT_ACK;
+  }
+
+  if(written){
+    client->send();
+    _writtenLength += written;
+  } else if(_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength){
+    _state = RESPONSE_END;
+  }
+  return written;
+}
+
+/*
+ * Bundle Handler
+ * */
+
+bool AsyncBundleWebHandler::canHandle(AsyncWebServerRequest *request){
+  if(request->method() != HTTP_GET || !request->isExpectedRequestedConnType(RCT_DEFAULT, RCT_HTTP))
+    return false;
+  if(!_bundle.find(request->url().c_str()))
+    return false;
+  request->addInterestingHeader("If-None-Match");
+  return true;
+}
+
+void AsyncBundleWebHandler::handleRequest(AsyncWebServerRequest *request){
+  if((_username != "" && _password != "") && !request->authenticate(_username.c_str(), _password.c_str()))
+    return request->requestAuthentication();
+
+  const AsyncBundleEntry *entry = _bundle.find(request->url().c_str());
+  if(!entry)
+    return request->send(404);
+
+  if(request->hasHeader("If-None-Match") && request->header("If-None-Match").equals(String(entry->crc, HEX))){
+    AsyncWebServerResponse *response = new AsyncBasicResponse(304); // Not modified
+    response->addHeader("ETag", String(entry->crc, HEX));
+    return request->send(response);
+  }
+  request->send(new AsyncBundleResponse(_bundle, entry));
+}
@@ -0,0 +1,138 @@
+/*
+  Asynchronous WebServer library for Espressif MCUs
+
+  Copyright (c) 2016 Hristo Gochkov. All rights reserved.
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef ASYNCBUNDLE_H_
+#define ASYNCBUNDLE_H_
+
+#include <ESPAsyncWebServer.h>
+
+/*
+ * BUNDLE :: Read-only image of pre-compressed assets (built by tools/asset_bundle.py)
+ *
+ * header (16 bytes, little endian)
+ *   0  char[4]  magic "AWSB"
+ *   4  uint16   version
+ *   6  uint16   number of index entries
+ *   8  uint32   image size
+ *  12  uint32   crc32 of the bytes [16, image size)
+ * index entries (96 bytes each)
+ *   0  char[48] url, NUL terminated
+ *  48  char[32] content type, NUL terminated
+ *  80  uint32   blob offset from the start of the image
+ *  84  uint32   blob length
+ *  88  uint32   flags (ASYNC_BUNDLE_GZIP, ASYNC_BUNDLE_IMMUTABLE)
+ *  92  uint32   crc32 of the blob
+ * blobs
+ * */
+
+#define ASYNC_BUNDLE_MAGIC "AWSB"
+#define ASYNC_BUNDLE_VERSION 1
+#define ASYNC_BUNDLE_URL_LENGTH 48
+#define ASYNC_BUNDLE_TYPE_LENGTH 32
+
+#define ASYNC_BUNDLE_GZIP      0x01
+#define ASYNC_BUNDLE_IMMUTABLE 0x02
+
+#ifndef ASYNC_BUNDLE_PARTITION
+#define ASYNC_BUNDLE_PARTITION "assets"
+#endif
+
+#ifndef ASYNC_BUNDLE_CACHE_IMMUTABLE
+#define ASYNC_BUNDLE_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#endif
+#ifndef ASYNC_BUNDLE_CACHE_REVALIDATE
+#define ASYNC_BUNDLE_CACHE_REVALIDATE "no-cache"
+#endif
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t count;
+  uint32_t size;
+  uint32_t crc;
+} AsyncBundleHeader;
+
+typedef struct {
+  char url[ASYNC_BUNDLE_URL_LENGTH];
+  char type[ASYNC_BUNDLE_TYPE_LENGTH];
+  uint32_t offset;
+  uint32_t length;
+  uint32_t flags;
+  uint32_t crc;
+} AsyncBundleEntry;
+
+class AsyncBundle {
+  private:
+    const uint8_t *_image;
+    size_t _size;
+    uint16_t _count;
+#ifdef ESP32
+    uint32_t _mmapHandle;
+    bool _mapped;
+#endif
+    bool _validate(bool checkCrc);
+  public:
+    AsyncBundle();
+    ~AsyncBundle();
+#ifdef ESP32
+    // memory-maps the data partition holding the image, it stays mapped until end()
+    bool begin(const char *label = ASYNC_BUNDLE_PARTITION, bool checkCrc = true);
+#endif
+    // uses an image already in memory (flash constant, RAM buffer...)
+    bool begin(const uint8_t *image, size_t size, bool checkCrc = true);
+    void end();
+    bool valid() const { return _image != NULL; }
+    size_t count() const { return _count; }
+    const AsyncBundleEntry* entry(size_t index) const;
+    const AsyncBundleEntry* find(const char *url) const;
+    const uint8_t* data(const AsyncBundleEntry *entry) const { return _image + entry->offset; }
+    static uint32_t crc32(const uint8_t *data, size_t len, uint32_t crc = 0);
+};
+
+/*
+ * RESPONSE :: Streams a bundle blob straight from the (memory-mapped) image, without intermediate buffer
+ * */
+
+class AsyncBundleResponse: public AsyncWebServerResponse {
+  private:
+    String _head;
+    const uint8_t *_content;
+  public:
+    AsyncBundleResponse(const AsyncBundle& bundle, const AsyncBundleEntry *entry);
+    void _respond(AsyncWebServerRequest *request);
+    size_t _ack(AsyncWebServerRequest *request, size_t len, uint32_t time);
+    bool _sourceValid() const { return _content != NULL; }
+};
+
+/*
+ * HANDLER :: Serves every url listed in the bundle index
+ * */
+
+class AsyncBundleWebHandler: public AsyncWebHandler {
+  private:
+    const AsyncBundle& _bundle;
+  public:
+    AsyncBundleWebHandler(const AsyncBundle& bundle): _bundle(bundle) {}
+    virtual bool canHandle(AsyncWebServerRequest *request) override final;
+    virtual void handleRequest(AsyncWebServerRequest *request) override final;
+    virtual const char* route() const override { return "bundle"; }
+};
+
+#endif /* ASYNCBUNDLE_H_ */
@@ -0,0 +1,134 @@
+/*
+  Asynchronous WebServer library for Espressif MCUs
+
+  Copyright (c) 2016 Hristo Gochkov. All rights reserved.
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#include "AsyncPathPattern.h"
+
+bool AsyncPathPattern::compile(const String& pattern){
+  _pattern = pattern;
+  _count = 0;
+  _captures = 0;
+  _valid = false;
+
+  const char *p = _pattern.c_str();
+  size_t len = _pattern.length();
+  if(!len || p[0] != '/')
+    return false;
+
+  size_t pos = 1;
+  while(pos <= len){
+    if(_count == ASYNC_PATH_MAX_SEGMENTS)
+      return false;
+    size_t end = pos;
+    while(end < len && p[end] != '/')
+      end++;
+    size_t segLen = end - pos;
+    if(segLen > 255)
+      return false;
+    Segment *seg = &_segments[_count];
+
+    if(segLen >= 2 && p[pos] == '{' && p[end - 1] == '}'){
+      // capture, with an optional ":int" type
+      seg->offset = pos + 1;
+      seg->length = segLen - 2;
+      seg->type = SEG_STRING;
+      const char *colon = (const char *)memchr(p + pos + 1, ':', segLen - 2);
+      if(colon){
+        size_t typeLen = p + end - 1 - (colon + 1);
+        if(typeLen == 3 && !strncmp(colon + 1, "int", 3))
+          seg->type = SEG_INT;
+        else if(!(typeLen == 3 && !strncmp(colon + 1, "str", 3)))
+          return false;
+        seg->length = colon - (p + pos + 1);
+      }
+      if(memchr(p + pos + 1, '{', segLen - 2) || memchr(p + pos + 1, '}', segLen - 2))
+        return false;
+      if(_captures == ASYNC_PATH_MAX_PARAMS)
+        return false;
+      _captures++;
+    } else if(segLen == 1 && p[pos] == '*' && end == len){
+      seg->offset = pos;
+      seg->length = 1;
+      seg->type = SEG_REST;
+    } else {
+      // captures must be a whole segment
+      if(memchr(p + pos, '{', segLen) || memchr(p + pos, '}', segLen))
+        return false;
+      seg->offset = pos;
+      seg->length = segLen;
+      seg->type = SEG_LITERAL;
+    }
+    _count++;
+    pos = end + 1;
+  }
+  _valid = _captures > 0;
+  return _valid;
+}
+
+bool AsyncPathPattern::match(const char *url, size_t len, AsyncPathSpan *spans) const {
+  if(!_valid || !len || url[0] != '/')
+    return false;
+
+  AsyncPathSpan found[ASYNC_PATH_MAX_PARAMS];
+  uint8_t capture = 0;
+  const char *p = _pattern.c_str();
+  size_t pos = 1;
+
+  for(uint8_t i = 0; i < _count; i++){
+    const Segment *seg = &_segments[i];
+    if(seg->type == SEG_REST){
+      pos = len + 1;
+      break;
+    }
+    if(pos > len)
+      return false;
+    size_t end = pos;
+    while(end < len && url[end] != '/')
+      end++;
+    size_t segLen = end - pos;
+
+    switch(seg->type){
+      case SEG_LITERAL:
+        if(segLen != seg->length || memcmp(url + pos, p + seg->offset, segLen) != 0)
+          return false;
+        break;
+      case SEG_INT:
+        for(size_t c = pos; c < end; c++){
+          if(url[c] < '0' || url[c] > '9')
+            return false;
+        }
+        // fall through
+      case SEG_STRING:
+        if(!segLen)
+          return false;
+        found[capture].offset = pos;
+        found[capture].length = segLen;
+        capture++;
+        break;
+    }
+    pos = end + 1;
+  }
+  // the whole url must have been consumed
+  if(pos != len + 1)
+    return false;
+
+  memcpy(spans, found, capture * sizeof(AsyncPathSpan));
+  return true;
+}
+
@@ -0,0 +1,75 @@
+/*
+  Asynchronous WebServer library for Espressif MCUs
+
+  Copyright (c) 2016 Hristo Gochkov. All rights reserved.
+  This file is part of the esp8266 core for Arduino environment.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+#ifndef ASYNCPATHPATTERN_H_
+#define ASYNCPATHPATTERN_H_
+
+#include "Arduino.h"
+
+#ifndef ASYNC_PATH_MAX_SEGMENTS
+#define ASYNC_PATH_MAX_SEGMENTS 12
+#endif
+
+#ifndef ASYNC_PATH_MAX_PARAMS
+#define ASYNC_PATH_MAX_PARAMS 8
+#endif
+
+/*
+ * PATH PATTERN :: Route pattern compiled once at registration
+ *
+ *   /band/{name}/mem/{n:int}
+ *
+ * Each '/' separated segment is either a literal, a capture "{name}" (any non empty
+ * segment), a typed capture "{name:int}" (decimal digits) or a final "*" (rest of the
+ * url, possibly empty). Matching walks the url once and records the captures as
+ * (offset, length) spans into the url, no memory is allocated.
+ * */
+
+typedef struct {
+  uint16_t offset;
+  uint16_t length;
+} AsyncPathSpan;
+
+class AsyncPathPattern {
+  public:
+    typedef enum { SEG_LITERAL, SEG_STRING, SEG_INT, SEG_REST } SegmentType;
+  private:
+    typedef struct {
+      uint16_t offset; // into _pattern, literal text or capture name
+      uint8_t length;
+      uint8_t type;
+    } Segment;
+    String _pattern;
+    Segment _segments[ASYNC_PATH_MAX_SEGMENTS];
+    uint8_t _count;
+    uint8_t _captures;
+    bool _valid;
+  public:
+    AsyncPathPattern(): _count(0), _captures(0), _valid(false) {}
+    // returns false if the pattern contains no capture or cannot be compiled
+    bool compile(const String& pattern);
+    bool valid() const { return _valid; }
+    uint8_t captures() const { return _captures; }
+    // spans must hold captures() entries, they are only written when the url matches
+    bool match(const char *url, size_t len, AsyncPathSpan *spans) const;
+    static bool isPattern(const String& uri) { return uri.indexOf('{') >= 0; }
+};
+
+#endif /* ASYNCPATHPATTERN_H_ */
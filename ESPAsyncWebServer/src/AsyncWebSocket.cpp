@@ -505,6 +505,7 @@ AsyncWebSocketClient::~AsyncWebSocketClient(){
 }
 
 void AsyncWebSocketClient::_onAck(size_t len, uint32_t time){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   _lastMessageTime = millis();
   if(!_controlQueue.isEmpty()){
     auto head = _controlQueue.front();
@@ -527,6 +528,7 @@ void AsyncWebSocketClient::_onAck(size_t len, uint32_t time){
 }
 
 void AsyncWebSocketClient::_onPoll(){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   if(_client->canSend() && (!_controlQueue.isEmpty() || !_messageQueue.isEmpty())){
     _runQueue();
   } else if(_keepAlivePeriod > 0 && _controlQueue.isEmpty() && _messageQueue.isEmpty() && (millis() - _lastMessageTime) >= _keepAlivePeriod){
@@ -619,6 +621,7 @@ void AsyncWebSocketClient::_onDisconnect(){
 }
 
 void AsyncWebSocketClient::_onData(void *pbuf, size_t plen){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   _lastMessageTime = millis();
   uint8_t *data = (uint8_t*)pbuf;
   while(plen > 0){
@@ -649,7 +652,8 @@ void AsyncWebSocketClient::_onData(void *pbuf, size_t plen){
     }
 
     const size_t datalen = std::min((size_t)(_pinfo.len - _pinfo.index), plen);
-    const auto datalast = data[datalen];
+    // the byte after the frame, if it is in this segment : a frame which ends the segment has none
+    const uint8_t datalast = datalen < plen ? data[datalen] : 0;
 
     if(_pinfo.masked){
       for(size_t i=0;i<datalen;i++)
@@ -701,7 +705,7 @@ void AsyncWebSocketClient::_onData(void *pbuf, size_t plen){
     }
 
     // restore byte as _handleEvent may have added a null terminator i.e., data[len] = 0;
-    if (datalen > 0)
+    if (datalen > 0 && datalen < plen)
       data[datalen] = datalast;
 
     data += datalen;
@@ -772,6 +776,7 @@ size_t AsyncWebSocketClient::printf_P(PGM_P formatP, ...) {
 #endif
 
 void AsyncWebSocketClient::text(const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   _queueMessage(new AsyncWebSocketBasicMessage(message, len));
 }
 void AsyncWebSocketClient::text(const char * message){
@@ -787,6 +792,7 @@ void AsyncWebSocketClient::text(const String &message){
   text(message.c_str(), message.length());
 }
 void AsyncWebSocketClient::text(const __FlashStringHelper *data){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   PGM_P p = reinterpret_cast<PGM_P>(data);
   size_t n = 0;
   while (1) {
@@ -808,6 +814,7 @@ void AsyncWebSocketClient::text(AsyncWebSocketMessageBuffer * buffer)
 }
 
 void AsyncWebSocketClient::binary(const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   _queueMessage(new AsyncWebSocketBasicMessage(message, len, WS_BINARY));
 }
 void AsyncWebSocketClient::binary(const char * message){
@@ -823,6 +830,7 @@ void AsyncWebSocketClient::binary(const String &message){
   binary(message.c_str(), message.length());
 }
 void AsyncWebSocketClient::binary(const __FlashStringHelper *data, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   PGM_P p = reinterpret_cast<PGM_P>(data);
   char * message = (char*) malloc(len);
   if(message){
@@ -951,12 +959,14 @@ void AsyncWebSocket::pingAll(uint8_t *data, size_t len){
 }
 
 void AsyncWebSocket::text(uint32_t id, const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->text(message, len);
 }
 
 void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer * buffer){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   if (!buffer) return;
   buffer->lock(); 
   for(const auto& c: _clients){
@@ -970,17 +980,20 @@ void AsyncWebSocket::textAll(AsyncWebSocketMessageBuffer * buffer){
 
 
 void AsyncWebSocket::textAll(const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketMessageBuffer * WSBuffer = makeBuffer((uint8_t *)message, len); 
     textAll(WSBuffer); 
 }
 
 void AsyncWebSocket::binary(uint32_t id, const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketClient * c = client(id);
   if(c)
     c->binary(message, len);
 }
 
 void AsyncWebSocket::binaryAll(const char * message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketMessageBuffer * buffer = makeBuffer((uint8_t *)message, len); 
   binaryAll(buffer); 
 }
@@ -1012,6 +1025,7 @@ void AsyncWebSocket::messageAll(AsyncWebSocketMultiMessage *message){
 }
 
 size_t AsyncWebSocket::printf(uint32_t id, const char *format, ...){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketClient * c = client(id);
   if(c){
     va_list arg;
@@ -1024,6 +1038,7 @@ size_t AsyncWebSocket::printf(uint32_t id, const char *format, ...){
 }
 
 size_t AsyncWebSocket::printfAll(const char *format, ...) {
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   va_list arg;
   char* temp = new char[MAX_PRINTF_LEN];
   if(!temp){
@@ -1049,6 +1064,7 @@ size_t AsyncWebSocket::printfAll(const char *format, ...) {
 
 #ifndef ESP32
 size_t AsyncWebSocket::printf_P(uint32_t id, PGM_P formatP, ...){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   AsyncWebSocketClient * c = client(id);
   if(c != NULL){
     va_list arg;
@@ -1062,6 +1078,7 @@ size_t AsyncWebSocket::printf_P(uint32_t id, PGM_P formatP, ...){
 #endif
 
 size_t AsyncWebSocket::printfAll_P(PGM_P formatP, ...) {
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   va_list arg;
   char* temp = new char[MAX_PRINTF_LEN];
   if(!temp){
@@ -1115,6 +1132,7 @@ void AsyncWebSocket::textAll(const String &message){
   textAll(message.c_str(), message.length());
 }
 void AsyncWebSocket::textAll(const __FlashStringHelper *message){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   for(const auto& c: _clients){
     if(c->status() == WS_CONNECTED)
       c->text(message);
@@ -1150,6 +1168,7 @@ void AsyncWebSocket::binaryAll(const String &message){
   binaryAll(message.c_str(), message.length());
 }
 void AsyncWebSocket::binaryAll(const __FlashStringHelper *message, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   for(const auto& c: _clients){
     if(c->status() == WS_CONNECTED)
       c-> binary(message, len);
@@ -1182,6 +1201,7 @@ bool AsyncWebSocket::canHandle(AsyncWebServerRequest *request){
 }
 
 void AsyncWebSocket::handleRequest(AsyncWebServerRequest *request){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEBSOCKET);
   if(!request->hasHeader(WS_STR_VERSION) || !request->hasHeader(WS_STR_KEY)){
     request->send(400);
     return;
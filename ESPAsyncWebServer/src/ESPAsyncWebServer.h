@@ -27,6 +27,8 @@
 #include "FS.h"
 
 #include "StringArray.h"
+#include "WebAuthentication.h"
+#include "AsyncPathPattern.h"
 
 #ifdef ESP32
 #include <WiFi.h>
@@ -46,6 +48,28 @@
 
 #define DEBUGF(...) //Serial.printf(__VA_ARGS__)
 
+// The allocations of the server are counted by subsystem when the HeapTelemetry library is used
+#if defined(__has_include)
+#if __has_include(<HeapTelemetry.h>)
+#include <HeapTelemetry.h>
+#define ASYNCWEBSERVER_HEAP_TAG(tag) HeapScope heapScope(tag)
+#endif
+#endif
+#ifndef ASYNCWEBSERVER_HEAP_TAG
+#define ASYNCWEBSERVER_HEAP_TAG(tag)
+#endif
+
+// The parsing of the requests and the templates are timed when the CycleTrace library is used
+#if defined(__has_include)
+#if __has_include(<CycleTrace.h>)
+#include <CycleTrace.h>
+#define ASYNCWEBSERVER_TRACE(name) TraceScope traceScope(name)
+#endif
+#endif
+#ifndef ASYNCWEBSERVER_TRACE
+#define ASYNCWEBSERVER_TRACE(name)
+#endif
+
 class AsyncWebServer;
 class AsyncWebServerRequest;
 class AsyncWebServerResponse;
@@ -154,6 +178,8 @@ class AsyncWebServerRequest {
     String _contentType;
     String _boundary;
     String _authorization;
+    String _sessionToken;
+    String _newSessionToken;
     RequestedConnectionType _reqconntype;
     void _removeNotInterestingHeaders();
     bool _isDigest;
@@ -165,7 +191,9 @@ class AsyncWebServerRequest {
 
     LinkedList<AsyncWebHeader *> _headers;
     LinkedList<AsyncWebParameter *> _params;
-    LinkedList<String *> _pathParams;
+    mutable LinkedList<String *> _pathParams;
+    AsyncPathSpan _pathSpans[ASYNC_PATH_MAX_PARAMS];
+    uint8_t _pathSpanCount;
 
     uint8_t _multiParseState;
     uint8_t _boundaryPosition;
@@ -188,13 +216,17 @@ class AsyncWebServerRequest {
 
     void _addParam(AsyncWebParameter*);
     void _addPathParam(const char *param);
+    void _setPathSpans(const AsyncPathSpan *spans, uint8_t count);
 
     bool _parseReqHead();
     bool _parseReqHeader();
     void _parseLine();
     void _parsePlainPostChar(uint8_t data);
     void _parseMultipartPostByte(uint8_t data, bool last);
+    size_t _parseMultipartPostBlock(const uint8_t *data, size_t len);
     void _addGetParams(const String& params);
+    bool _hasSession(const char * identity);
+    void _openSession(const char * identity);
 
     void _handleUploadStart();
     void _handleUploadByte(uint8_t data, bool last);
@@ -227,8 +259,11 @@ class AsyncWebServerRequest {
     bool authenticate(const char * hash);
     bool authenticate(const char * username, const char * password, const char * realm = NULL, bool passwordIsHash = false);
     void requestAuthentication(const char * realm = NULL, bool isDigest = true);
+    // when sessions are enabled on the server, ends the session of the request cookie
+    void endSession();
 
     void setHandler(AsyncWebHandler *handler){ _handler = handler; }
+    AsyncWebHandler* handler() const { return _handler; }
     void addInterestingHeader(const String& name);
 
     void redirect(const String& url);
@@ -277,7 +312,10 @@ class AsyncWebServerRequest {
     bool hasArg(const char* name) const;         // check if argument exists
     bool hasArg(const __FlashStringHelper * data) const;         // check if F(argument) exists
 
-    const String& ASYNCWEBSERVER_REGEX_ATTRIBUTE pathArg(size_t i) const;
+    size_t pathArgs() const;                     // get path captures count
+    const String& pathArg(size_t i) const;       // get path capture by number
+    const char * pathArg(size_t i, size_t *len) const; // get path capture without copying, not null terminated
+    long pathArgInt(size_t i, long defaultValue=0) const; // get path capture as a number
 
     const String& header(const char* name) const;// get request header value by name
     const String& header(const __FlashStringHelper * data) const;// get request header value by F(name)    
@@ -345,6 +383,8 @@ class AsyncWebHandler {
     virtual void handleUpload(AsyncWebServerRequest *request  __attribute__((unused)), const String& filename __attribute__((unused)), size_t index __attribute__((unused)), uint8_t *data __attribute__((unused)), size_t len __attribute__((unused)), bool final  __attribute__((unused))){}
     virtual void handleBody(AsyncWebServerRequest *request __attribute__((unused)), uint8_t *data __attribute__((unused)), size_t len __attribute__((unused)), size_t index __attribute__((unused)), size_t total __attribute__((unused))){}
     virtual bool isRequestHandlerTrivial(){return true;}
+    // uri pattern served by the handler, to label the statistics of its requests (NULL if it has none)
+    virtual const char* route() const { return NULL; }
 };
 
 /*
@@ -374,6 +414,7 @@ class AsyncWebServerResponse {
     AsyncWebServerResponse();
     virtual ~AsyncWebServerResponse();
     virtual void setCode(int code);
+    int code() const { return _code; }
     virtual void setContentLength(size_t len);
     virtual void setContentType(const String& type);
     virtual void addHeader(const String& name, const String& value);
@@ -391,6 +432,7 @@ class AsyncWebServerResponse {
  * */
 
 typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, int code)> ArResponseObserverFunction;
 typedef std::function<void(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final)> ArUploadHandlerFunction;
 typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
 
@@ -400,6 +442,9 @@ class AsyncWebServer {
     LinkedList<AsyncWebRewrite*> _rewrites;
     LinkedList<AsyncWebHandler*> _handlers;
     AsyncCallbackWebHandler* _catchAllHandler;
+    AsyncWebSessions _sessions;
+    ArResponseObserverFunction _onResponse;
+    size_t _openRequests;
 
   public:
     AsyncWebServer(uint16_t port);
@@ -432,6 +477,15 @@ class AsyncWebServer {
     void onRequestBody(ArBodyHandlerFunction fn); //handle posts with plain body content (JSON often transmitted this way as a request)
 
     void reset(); //remove all writers and handlers, with onNotFound/onFileUpload/onRequestBody 
+
+    // opt-in session tokens: sessions().begin(lifetime) after a successful authenticate() the client
+    // gets a cookie and is not checked against the password again until the session expires
+    AsyncWebSessions& sessions(){ return _sessions; }
+
+    // statistics : fn is called for each response sent, with its status code
+    void onResponse(ArResponseObserverFunction fn){ _onResponse = fn; }
+    size_t openRequests() const { return _openRequests; } // connections with a request being received or answered
+    void _notifyResponse(AsyncWebServerRequest *request, int code){ if(_onResponse) _onResponse(request, code); }
   
     void _handleDisconnect(AsyncWebServerRequest *request);
     void _attachHandler(AsyncWebServerRequest *request);
@@ -22,6 +22,7 @@
 #include <libb64/cencode.h>
 #ifdef ESP32
 #include "mbedtls/md5.h"
+#include "esp_system.h"
 #else
 #include "md5.h"
 #endif
@@ -58,40 +59,44 @@ bool checkBasicAuthentication(const char * hash, const char * username, const ch
   return false;
 }
 
-static bool getMD5(uint8_t * data, uint16_t len, char * output){//33 bytes or more
-#ifdef ESP32
-    mbedtls_md5_context _ctx;
-#else
-    md5_context_t _ctx;
-#endif
-  uint8_t i;
-  uint8_t * _buf = (uint8_t*)malloc(16);
-  if(_buf == NULL)
-    return false;
-  memset(_buf, 0x00, 16);
+static void rawMD5(const uint8_t * data, uint16_t len, uint8_t * output){//16 bytes
 #ifdef ESP32
+  mbedtls_md5_context _ctx;
   mbedtls_md5_init(&_ctx);
   mbedtls_md5_starts(&_ctx);
   mbedtls_md5_update(&_ctx, data, len);
-  mbedtls_md5_finish(&_ctx, _buf);
+  mbedtls_md5_finish(&_ctx, output);
+  mbedtls_md5_free(&_ctx);
 #else
+  md5_context_t _ctx;
   MD5Init(&_ctx);
-  MD5Update(&_ctx, data, len);
-  MD5Final(_buf, &_ctx);
+  MD5Update(&_ctx, (uint8_t*)data, len);
+  MD5Final(output, &_ctx);
 #endif
+}
+
+static bool getMD5(uint8_t * data, uint16_t len, char * output){//33 bytes or more
+  uint8_t i;
+  uint8_t _buf[16];
+  rawMD5(data, len, _buf);
   for(i = 0; i < 16; i++) {
     sprintf(output + (i * 2), "%02x", _buf[i]);
   }
-  free(_buf);
   return true;
 }
 
-static String genRandomMD5(){
+static uint32_t randomWord(){
 #ifdef ESP8266
-  uint32_t r = RANDOM_REG32;
+  return RANDOM_REG32;
+#elif defined(ESP32)
+  return esp_random();
 #else
-  uint32_t r = rand();
+  return rand();
 #endif
+}
+
+static String genRandomMD5(){
+  uint32_t r = randomWord();
   char * out = (char*)malloc(33);
   if(out == NULL || !getMD5((uint8_t*)(&r), 4, out))
     return "";
@@ -233,3 +238,175 @@ bool checkDigestAuthentication(const char * header, const char * method, const c
   //os_printf("AUTH FAIL: password\n");
   return false;
 }
+
+/*
+ * Sessions
+ * */
+
+// HMAC-MD5 (RFC 2104), the message is at most 64 bytes
+static void hmacMD5(const uint8_t * key, size_t keyLen, const uint8_t * msg, size_t msgLen, uint8_t * output){
+  uint8_t block[64 + 64];
+  uint8_t inner[64 + 16];
+  if(msgLen > 64)
+    msgLen = 64;
+  memset(block, 0, 64);
+  memcpy(block, key, keyLen);
+  for(uint8_t i = 0; i < 64; i++){
+    inner[i] = block[i] ^ 0x5c;
+    block[i] ^= 0x36;
+  }
+  memcpy(block + 64, msg, msgLen);
+  rawMD5(block, 64 + msgLen, inner + 64);
+  rawMD5(inner, 64 + 16, output);
+}
+
+// FNV-1a, only used to bind a session to the credentials it was opened with
+static uint32_t identityHash(const char * identity){
+  uint32_t h = 2166136261UL;
+  while(identity && *identity){
+    h ^= (uint8_t)*identity++;
+    h *= 16777619UL;
+  }
+  return h;
+}
+
+// same duration whatever the position of the first difference
+static bool bytesEqual(const uint8_t * a, const uint8_t * b, size_t len){
+  uint8_t diff = 0;
+  for(size_t i = 0; i < len; i++)
+    diff |= a[i] ^ b[i];
+  return diff == 0;
+}
+
+static void toHex(const uint8_t * data, size_t len, char * output){
+  for(size_t i = 0; i < len; i++)
+    sprintf(output + (i * 2), "%02x", data[i]);
+}
+
+static bool fromHex(const char * hex, size_t len, uint8_t * output){
+  for(size_t i = 0; i < 2 * len; i++){
+    char c = hex[i];
+    uint8_t v;
+    if(c >= '0' && c <= '9') v = c - '0';
+    else if(c >= 'a' && c <= 'f') v = c - 'a' + 10;
+    else return false;
+    output[i / 2] = (i & 1) ? (output[i / 2] | v) : (v << 4);
+  }
+  return true;
+}
+
+AsyncWebSessions::AsyncWebSessions()
+  : _lifetime(0)
+  , _enabled(false)
+{
+  clear();
+}
+
+void AsyncWebSessions::begin(uint32_t lifetime){
+  for(uint8_t i = 0; i < sizeof(_key); i += 4){
+    uint32_t r = randomWord();
+    memcpy(_key + i, &r, 4);
+  }
+  _lifetime = lifetime;
+  clear();
+  _enabled = true;
+}
+
+void AsyncWebSessions::end(){
+  _enabled = false;
+  clear();
+}
+
+void AsyncWebSessions::clear(){
+  memset(_slots, 0, sizeof(_slots));
+}
+
+size_t AsyncWebSessions::count(){
+  size_t n = 0;
+  uint32_t now = millis();
+  for(uint8_t i = 0; i < WEB_SESSION_SLOTS; i++){
+    if(_slots[i].used && (int32_t)(_slots[i].expires - now) > 0)
+      n++;
+  }
+  return n;
+}
+
+void AsyncWebSessions::_mac(const uint8_t * id, uint32_t identity, uint32_t expires, uint8_t * mac){
+  uint8_t msg[WEB_SESSION_ID_LENGTH + 8];
+  memcpy(msg, id, WEB_SESSION_ID_LENGTH);
+  memcpy(msg + WEB_SESSION_ID_LENGTH, &identity, 4);
+  memcpy(msg + WEB_SESSION_ID_LENGTH + 4, &expires, 4);
+  uint8_t full[16];
+  hmacMD5(_key, sizeof(_key), msg, sizeof(msg), full);
+  memcpy(mac, full, WEB_SESSION_MAC_LENGTH);
+}
+
+// the live slot the token was issued in, NULL if the token is malformed, expired or forged : the id
+// and the MAC are compared with the ones stored by issue(), no MD5 run
+AsyncWebSessions::Slot * AsyncWebSessions::_find(const String& token){
+  uint8_t raw[WEB_SESSION_ID_LENGTH + WEB_SESSION_MAC_LENGTH];
+  if(token.length() != WEB_SESSION_TOKEN_LENGTH || !fromHex(token.c_str(), sizeof(raw), raw))
+    return NULL;
+  uint32_t now = millis();
+  for(uint8_t i = 0; i < WEB_SESSION_SLOTS; i++){
+    Slot * s = &_slots[i];
+    if(!s->used || !bytesEqual(s->id, raw, WEB_SESSION_ID_LENGTH))
+      continue;
+    if((int32_t)(s->expires - now) <= 0){
+      s->used = false;
+      return NULL;
+    }
+    return bytesEqual(s->mac, raw + WEB_SESSION_ID_LENGTH, WEB_SESSION_MAC_LENGTH) ? s : NULL;
+  }
+  return NULL;
+}
+
+String AsyncWebSessions::issue(const char * identity){
+  if(!_enabled)
+    return String();
+
+  uint32_t now = millis();
+
+  // a free or expired slot, otherwise the oldest session is evicted
+  Slot * slot = NULL;
+  Slot * oldest = &_slots[0];
+  for(uint8_t i = 0; i < WEB_SESSION_SLOTS; i++){
+    Slot * s = &_slots[i];
+    if(!s->used || (int32_t)(s->expires - now) <= 0){
+      slot = s;
+      break;
+    }
+    if((int32_t)(s->issued - oldest->issued) < 0)
+      oldest = s;
+  }
+  if(slot == NULL)
+    slot = oldest;
+
+  for(uint8_t i = 0; i < WEB_SESSION_ID_LENGTH; i += 4){
+    uint32_t r = randomWord();
+    memcpy(slot->id + i, &r, 4);
+  }
+  slot->identity = identityHash(identity);
+  slot->issued = now;
+  slot->expires = now + _lifetime * 1000;
+  slot->used = true;
+
+  _mac(slot->id, slot->identity, slot->expires, slot->mac);
+  char token[WEB_SESSION_TOKEN_LENGTH + 1];
+  toHex(slot->id, WEB_SESSION_ID_LENGTH, token);
+  toHex(slot->mac, WEB_SESSION_MAC_LENGTH, token + 2 * WEB_SESSION_ID_LENGTH);
+  return String(token);
+}
+
+bool AsyncWebSessions::check(const String& token, const char * identity){
+  if(!_enabled)
+    return false;
+  Slot * s = _find(token);
+  return s != NULL && s->identity == identityHash(identity);
+}
+
+void AsyncWebSessions::revoke(const String& token){
+  Slot * s = _find(token);
+  if(s != NULL)
+    s->used = false;
+}
@@ -31,4 +31,54 @@ bool checkDigestAuthentication(const char * header, const char * method, const c
 //for storing hashed versions on the device that can be authenticated against
 String generateDigestHash(const char * username, const char * password, const char * realm);
 
+/*
+ * SESSIONS :: Opt-in session tokens issued after one successful Basic/Digest login.
+ * The token is sent as a cookie and checked against a small in-RAM table, so the
+ * following requests do not run the MD5 digest check again.
+ * token = hex(random id | HMAC-MD5(key, id | identity | expiry) truncated)
+ * The MAC is computed once by issue() and kept in the slot with the id: check()
+ * finds the slot by id and compares the MAC of the token with the stored one,
+ * without running MD5.
+ * A new session takes a free or expired slot. When all WEB_SESSION_SLOTS slots
+ * hold live sessions the oldest one is evicted, and its user must log in again.
+ * */
+
+#define WEB_SESSION_COOKIE "ESPSESSIONID"
+#ifndef WEB_SESSION_SLOTS
+#define WEB_SESSION_SLOTS 8
+#endif
+#define WEB_SESSION_ID_LENGTH 8
+#define WEB_SESSION_MAC_LENGTH 8
+#define WEB_SESSION_TOKEN_LENGTH (2 * (WEB_SESSION_ID_LENGTH + WEB_SESSION_MAC_LENGTH))
+
+class AsyncWebSessions {
+  private:
+    typedef struct {
+      uint8_t id[WEB_SESSION_ID_LENGTH];
+      uint8_t mac[WEB_SESSION_MAC_LENGTH];
+      uint32_t identity;
+      uint32_t issued;
+      uint32_t expires;
+      bool used;
+    } Slot;
+    Slot _slots[WEB_SESSION_SLOTS];
+    uint8_t _key[16];
+    uint32_t _lifetime;
+    bool _enabled;
+    void _mac(const uint8_t * id, uint32_t identity, uint32_t expires, uint8_t * mac);
+    Slot * _find(const String& token);
+  public:
+    AsyncWebSessions();
+    void begin(uint32_t lifetime = 3600); // seconds, a new random key invalidates all previous tokens
+    void end();
+    bool enabled() const { return _enabled; }
+    uint32_t lifetime() const { return _lifetime; }
+    // identity is the user name (or the stored hash) the session was opened with
+    String issue(const char * identity);
+    bool check(const String& token, const char * identity);
+    void revoke(const String& token);
+    void clear();
+    size_t count();
+};
+
 #endif
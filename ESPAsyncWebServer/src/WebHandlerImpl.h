@@ -61,6 +61,7 @@ class AsyncStaticWebHandler: public AsyncWebHandler {
     AsyncStaticWebHandler& setLastModified(); //sets to current time. Make sure sntp is runing and time is updated
   #endif
     AsyncStaticWebHandler& setTemplateProcessor(AwsTemplateProcessor newCallback) {_callback = newCallback; return *this;}
+    virtual const char* route() const override { return _uri.c_str(); }
 };
 
 class AsyncCallbackWebHandler: public AsyncWebHandler {
@@ -72,16 +73,28 @@ class AsyncCallbackWebHandler: public AsyncWebHandler {
     ArUploadHandlerFunction _onUpload;
     ArBodyHandlerFunction _onBody;
     bool _isRegex;
+    bool _isPattern;
+    AsyncPathPattern _pattern;
+#ifdef ASYNCWEBSERVER_REGEX
+    std::regex _regex;
+#endif
   public:
-    AsyncCallbackWebHandler() : _uri(), _method(HTTP_ANY), _onRequest(NULL), _onUpload(NULL), _onBody(NULL), _isRegex(false) {}
+    AsyncCallbackWebHandler() : _uri(), _method(HTTP_ANY), _onRequest(NULL), _onUpload(NULL), _onBody(NULL), _isRegex(false), _isPattern(false) {}
     void setUri(const String& uri){ 
       _uri = uri; 
       _isRegex = uri.startsWith("^") && uri.endsWith("$");
+      // "{name}" routes are compiled once here instead of on every request
+      _isPattern = !_isRegex && AsyncPathPattern::isPattern(uri) && _pattern.compile(uri);
+#ifdef ASYNCWEBSERVER_REGEX
+      if(_isRegex)
+        _regex = std::regex(_uri.c_str());
+#endif
     }
     void setMethod(WebRequestMethodComposite method){ _method = method; }
     void onRequest(ArRequestHandlerFunction fn){ _onRequest = fn; }
     void onUpload(ArUploadHandlerFunction fn){ _onUpload = fn; }
     void onBody(ArBodyHandlerFunction fn){ _onBody = fn; }
+    virtual const char* route() const override { return _uri.c_str(); }
 
     virtual bool canHandle(AsyncWebServerRequest *request) override final{
 
@@ -91,12 +104,17 @@ class AsyncCallbackWebHandler: public AsyncWebHandler {
       if(!(_method & request->method()))
         return false;
 
+      if (_isPattern) {
+        AsyncPathSpan spans[ASYNC_PATH_MAX_PARAMS];
+        if(!_pattern.match(request->url().c_str(), request->url().length(), spans))
+          return false;
+        request->_setPathSpans(spans, _pattern.captures());
+      } else
 #ifdef ASYNCWEBSERVER_REGEX
       if (_isRegex) {
-        std::regex pattern(_uri.c_str());
         std::smatch matches;
         std::string s(request->url().c_str());
-        if(std::regex_search(s, matches, pattern)) {
+        if(std::regex_search(s, matches, _regex)) {
           for (size_t i = 1; i < matches.size(); ++i) { // start from 1
             request->_addPathParam(matches[i].str().c_str());
           }
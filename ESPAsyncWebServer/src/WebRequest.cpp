@@ -28,6 +28,20 @@
 
 static const String SharedEmptyString = String();
 
+enum {
+  EXPECT_BOUNDARY,
+  PARSE_HEADERS,
+  WAIT_FOR_RETURN1,
+  EXPECT_FEED1,
+  EXPECT_DASH1,
+  EXPECT_DASH2,
+  BOUNDARY_OR_DATA,
+  DASH3_OR_RETURN2,
+  EXPECT_FEED2,
+  PARSING_FINISHED,
+  PARSE_ERROR
+};
+
 #define __is_param_char(c) ((c) && ((c) != '{') && ((c) != '[') && ((c) != '&') && ((c) != '='))
 
 enum { PARSE_REQ_START, PARSE_REQ_HEADERS, PARSE_REQ_BODY, PARSE_REQ_END, PARSE_REQ_FAIL };
@@ -46,6 +60,8 @@ AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* s, AsyncClient* c)
   , _contentType()
   , _boundary()
   , _authorization()
+  , _sessionToken()
+  , _newSessionToken()
   , _reqconntype(RCT_HTTP)
   , _isDigest(false)
   , _isMultipart(false)
@@ -56,6 +72,7 @@ AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* s, AsyncClient* c)
   , _headers(LinkedList<AsyncWebHeader *>([](AsyncWebHeader *h){ delete h; }))
   , _params(LinkedList<AsyncWebParameter *>([](AsyncWebParameter *p){ delete p; }))
   , _pathParams(LinkedList<String *>([](String *p){ delete p; }))
+  , _pathSpanCount(0)
   , _multiParseState(0)
   , _boundaryPosition(0)
   , _itemStartIndex(0)
@@ -99,6 +116,7 @@ AsyncWebServerRequest::~AsyncWebServerRequest(){
 }
 
 void AsyncWebServerRequest::_onData(void *buf, size_t len){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_REQUEST);
   size_t i = 0;
   while (true) {
 
@@ -134,10 +152,19 @@ void AsyncWebServerRequest::_onData(void *buf, size_t len){
     const bool needParse = _handler && !_handler->isRequestHandlerTrivial();
     if(_isMultipart){
       if(needParse){
-        size_t i;
-        for(i=0; i<len; i++){
+        size_t i = 0;
+        while(i < len){
+          // file contents are passed on in slices, only the bytes around a boundary go through the state machine
+          if(_multiParseState == WAIT_FOR_RETURN1 && _itemIsFile){
+            size_t n = _parseMultipartPostBlock((uint8_t*)buf + i, len - i);
+            i += n;
+            _parsedLength += n;
+            if(i == len)
+              break;
+          }
           _parseMultipartPostByte(((uint8_t*)buf)[i], i == len - 1);
           _parsedLength++;
+          i++;
         }
       } else
           _parsedLength += len;
@@ -180,14 +207,12 @@ void AsyncWebServerRequest::_onData(void *buf, size_t len){
 
 void AsyncWebServerRequest::_removeNotInterestingHeaders(){
   if (_interestingHeaders.containsIgnoreCase("ANY")) return; // nothing to do
-  for(const auto& header: _headers){
-      if(!_interestingHeaders.containsIgnoreCase(header->name().c_str())){
-        _headers.remove(header);
-      }
-  }
+  // removing while iterating would step through the freed node
+  while(_headers.remove_first([this](AsyncWebHeader* const& header){ return !_interestingHeaders.containsIgnoreCase(header->name()); }));
 }
 
 void AsyncWebServerRequest::_onPoll(){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   //os_printf("p\n");
   if(_response != NULL && _client != NULL && _client->canSend() && !_response->_finished()){
     _response->_ack(this, 0, 0);
@@ -195,6 +220,7 @@ void AsyncWebServerRequest::_onPoll(){
 }
 
 void AsyncWebServerRequest::_onAck(size_t len, uint32_t time){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   //os_printf("a:%u:%u\n", len, time);
   if(_response != NULL){
     if(!_response->_finished()){
@@ -237,6 +263,13 @@ void AsyncWebServerRequest::_addPathParam(const char *p){
   _pathParams.add(new String(p));
 }
 
+void AsyncWebServerRequest::_setPathSpans(const AsyncPathSpan *spans, uint8_t count){
+  if(count > ASYNC_PATH_MAX_PARAMS)
+    count = ASYNC_PATH_MAX_PARAMS;
+  memcpy(_pathSpans, spans, count * sizeof(AsyncPathSpan));
+  _pathSpanCount = count;
+}
+
 void AsyncWebServerRequest::_addGetParams(const String& params){
   size_t start = 0;
   while (start < params.length()){
@@ -334,6 +367,13 @@ bool AsyncWebServerRequest::_parseReqHeader(){
         _isDigest = true;
         _authorization = value.substring(7);
       }
+    } else if(name.equalsIgnoreCase("Cookie")){
+      int start = value.indexOf(WEB_SESSION_COOKIE "=");
+      if(start >= 0 && (start == 0 || value[start - 1] == ' ' || value[start - 1] == ';')){
+        start += strlen(WEB_SESSION_COOKIE "=");
+        int end = value.indexOf(';', start);
+        _sessionToken = (end < 0) ? value.substring(start) : value.substring(start, end);
+      }
     } else {
       if(name.equalsIgnoreCase("Upgrade") && value.equalsIgnoreCase("websocket")){
         // WebSocket request can be uniquely identified by header: [Upgrade: websocket]
@@ -377,19 +417,51 @@ void AsyncWebServerRequest::_handleUploadByte(uint8_t data, bool last){
   }
 }
 
-enum {
-  EXPECT_BOUNDARY,
-  PARSE_HEADERS,
-  WAIT_FOR_RETURN1,
-  EXPECT_FEED1,
-  EXPECT_DASH1,
-  EXPECT_DASH2,
-  BOUNDARY_OR_DATA,
-  DASH3_OR_RETURN2,
-  EXPECT_FEED2,
-  PARSING_FINISHED,
-  PARSE_ERROR
-};
+
+// Returns how many leading bytes of data belong to the current file item and passes them
+// to the handler in one call. Stops at a '\r' that may start the closing delimiter
+// ("\r\n--" boundary), including one split over the end of data.
+size_t AsyncWebServerRequest::_parseMultipartPostBlock(const uint8_t *data, size_t len){
+  const char *boundary = _boundary.c_str();
+  size_t boundaryLen = _boundary.length();
+  size_t pos = 0;
+  while(pos < len){
+    const uint8_t *cr = (const uint8_t *)memchr(data + pos, '\r', len - pos);
+    if(!cr){
+      pos = len;
+      break;
+    }
+    size_t at = cr - data;
+    size_t avail = len - at;
+    size_t need = 4 + boundaryLen;
+    size_t check = avail < need ? avail : need;
+    size_t k = 1;
+    for(; k < check; k++){
+      uint8_t expected = k == 1 ? '\n' : (k < 4 ? '-' : boundary[k - 4]);
+      if(data[at + k] != expected)
+        break;
+    }
+    if(k == check){
+      pos = at;
+      break;
+    }
+    pos = at + 1;
+  }
+  if(!pos)
+    return 0;
+
+  if(_handler){
+    //check if authenticated before calling the upload
+    if(_itemBufferIndex){
+      _handler->handleUpload(this, _itemFilename, _itemSize - _itemBufferIndex, _itemBuffer, _itemBufferIndex, false);
+      _itemBufferIndex = 0;
+    }
+    _handler->handleUpload(this, _itemFilename, _itemSize, (uint8_t*)data, pos, false);
+  }
+  _itemBufferIndex = 0;
+  _itemSize += pos;
+  return pos;
+}
 
 void AsyncWebServerRequest::_parseMultipartPostByte(uint8_t data, bool last){
 #define itemWriteByte(b) do { _itemSize++; if(_itemIsFile) _handleUploadByte(b, last); else _itemValue+=(char)(b); } while(0)
@@ -533,25 +605,21 @@ void AsyncWebServerRequest::_parseMultipartPostByte(uint8_t data, bool last){
     } else if(data == '-' && _contentLength == (_parsedLength + 4)){
       _multiParseState = PARSING_FINISHED;
     } else {
-      _multiParseState = WAIT_FOR_RETURN1;
-      itemWriteByte('\r'); itemWriteByte('\n'); itemWriteByte('-');  itemWriteByte('-');
-      uint8_t i; for(i=0; i<_boundary.length(); i++) itemWriteByte(_boundary.c_str()[i]);
-      _parseMultipartPostByte(data, last);
+      // the item was closed by the whole delimiter, its bytes cannot go back into it
+      _multiParseState = PARSE_ERROR;
     }
   } else if(_multiParseState == EXPECT_FEED2){
     if(data == '\n'){
       _multiParseState = PARSE_HEADERS;
       _itemIsFile = false;
     } else {
-      _multiParseState = WAIT_FOR_RETURN1;
-      itemWriteByte('\r'); itemWriteByte('\n'); itemWriteByte('-');  itemWriteByte('-');
-      uint8_t i; for(i=0; i<_boundary.length(); i++) itemWriteByte(_boundary.c_str()[i]);
-      itemWriteByte('\r'); _parseMultipartPostByte(data, last);
+      _multiParseState = PARSE_ERROR;
     }
   }
 }
 
 void AsyncWebServerRequest::_parseLine(){
+  ASYNCWEBSERVER_TRACE("_parseLine");
   if(_parseState == PARSE_REQ_START){
     if(!_temp.length()){
       _parseState = PARSE_REQ_FAIL;
@@ -709,6 +777,7 @@ void AsyncWebServerRequest::addInterestingHeader(const String& name){
 }
 
 void AsyncWebServerRequest::send(AsyncWebServerResponse *response){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   _response = response;
   if(_response == NULL){
     _client->close(true);
@@ -721,50 +790,68 @@ void AsyncWebServerRequest::send(AsyncWebServerResponse *response){
     send(500);
   }
   else {
+    _server->_notifyResponse(this, _response->code());
+    if(_newSessionToken.length()){
+      String cookie = WEB_SESSION_COOKIE "=";
+      cookie.concat(_newSessionToken);
+      cookie.concat("; Path=/; HttpOnly; SameSite=Strict; Max-Age=");
+      cookie.concat(String(_server->sessions().lifetime()));
+      _response->addHeader("Set-Cookie", cookie);
+      _newSessionToken = String();
+    }
     _client->setRxTimeout(0);
     _response->_respond(this);
   }
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(int code, const String& contentType, const String& content){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return new AsyncBasicResponse(code, contentType, content);
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(FS &fs, const String& path, const String& contentType, bool download, AwsTemplateProcessor callback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   if(fs.exists(path) || (!download && fs.exists(path+".gz")))
     return new AsyncFileResponse(fs, path, contentType, download, callback);
   return NULL;
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(File content, const String& path, const String& contentType, bool download, AwsTemplateProcessor callback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   if(content == true)
     return new AsyncFileResponse(content, path, contentType, download, callback);
   return NULL;
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(Stream &stream, const String& contentType, size_t len, AwsTemplateProcessor callback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return new AsyncStreamResponse(stream, contentType, len, callback);
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse(const String& contentType, size_t len, AwsResponseFiller callback, AwsTemplateProcessor templateCallback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return new AsyncCallbackResponse(contentType, len, callback, templateCallback);
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginChunkedResponse(const String& contentType, AwsResponseFiller callback, AwsTemplateProcessor templateCallback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   if(_version)
     return new AsyncChunkedResponse(contentType, callback, templateCallback);
   return new AsyncCallbackResponse(contentType, 0, callback, templateCallback);
 }
 
 AsyncResponseStream * AsyncWebServerRequest::beginResponseStream(const String& contentType, size_t bufferSize){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return new AsyncResponseStream(contentType, bufferSize);
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, const uint8_t * content, size_t len, AwsTemplateProcessor callback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return new AsyncProgmemResponse(code, contentType, content, len, callback);
 }
 
 AsyncWebServerResponse * AsyncWebServerRequest::beginResponse_P(int code, const String& contentType, PGM_P content, AwsTemplateProcessor callback){
+  ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_RESPONSE);
   return beginResponse_P(code, contentType, (const uint8_t *)content, strlen_P(content), callback);
 }
 
@@ -810,22 +897,47 @@ void AsyncWebServerRequest::redirect(const String& url){
   send(response);
 }
 
+bool AsyncWebServerRequest::_hasSession(const char * identity){
+  return _sessionToken.length() && _server->sessions().check(_sessionToken, identity);
+}
+
+void AsyncWebServerRequest::_openSession(const char * identity){
+  if(_server->sessions().enabled())
+    _newSessionToken = _server->sessions().issue(identity);
+}
+
+void AsyncWebServerRequest::endSession(){
+  if(_sessionToken.length())
+    _server->sessions().revoke(_sessionToken);
+  _sessionToken = String();
+}
+
 bool AsyncWebServerRequest::authenticate(const char * username, const char * password, const char * realm, bool passwordIsHash){
+  if(_hasSession(username))
+    return true;
+  bool authenticated = false;
   if(_authorization.length()){
     if(_isDigest)
-      return checkDigestAuthentication(_authorization.c_str(), methodToString(), username, password, realm, passwordIsHash, NULL, NULL, NULL);
+      authenticated = checkDigestAuthentication(_authorization.c_str(), methodToString(), username, password, realm, passwordIsHash, NULL, NULL, NULL);
     else if(!passwordIsHash)
-      return checkBasicAuthentication(_authorization.c_str(), username, password);
+      authenticated = checkBasicAuthentication(_authorization.c_str(), username, password);
     else
-      return _authorization.equals(password);
+      authenticated = _authorization.equals(password);
   }
-  return false;
+  if(authenticated)
+    _openSession(username);
+  return authenticated;
 }
 
 bool AsyncWebServerRequest::authenticate(const char * hash){
-  if(!_authorization.length() || hash == NULL)
+  if(hash == NULL)
+    return false;
+  if(_hasSession(hash))
+    return true;
+  if(!_authorization.length())
     return false;
 
+  bool authenticated = false;
   if(_isDigest){
     String hStr = String(hash);
     int separator = hStr.indexOf(":");
@@ -838,10 +950,13 @@ bool AsyncWebServerRequest::authenticate(const char * hash){
       return false;
     String realm = hStr.substring(0, separator);
     hStr = hStr.substring(separator + 1);
-    return checkDigestAuthentication(_authorization.c_str(), methodToString(), username.c_str(), hStr.c_str(), realm.c_str(), true, NULL, NULL, NULL);
+    authenticated = checkDigestAuthentication(_authorization.c_str(), methodToString(), username.c_str(), hStr.c_str(), realm.c_str(), true, NULL, NULL, NULL);
+  } else {
+    authenticated = _authorization.equals(hash);
   }
-
-  return (_authorization.equals(hash));
+  if(authenticated)
+    _openSession(hash);
+  return authenticated;
 }
 
 void AsyncWebServerRequest::requestAuthentication(const char * realm, bool isDigest){
@@ -917,11 +1032,44 @@ const String& AsyncWebServerRequest::argName(size_t i) const {
   return getParam(i)->name();
 }
 
+size_t AsyncWebServerRequest::pathArgs() const {
+  return _pathSpanCount ? _pathSpanCount : _pathParams.length();
+}
+
 const String& AsyncWebServerRequest::pathArg(size_t i) const {
+  // captures of a compiled pattern are only copied out of the url when asked for
+  if(_pathSpanCount && _pathParams.isEmpty()){
+    for(uint8_t n = 0; n < _pathSpanCount; n++)
+      _pathParams.add(new String(_url.substring(_pathSpans[n].offset, _pathSpans[n].offset + _pathSpans[n].length)));
+  }
   auto param = _pathParams.nth(i);
   return param ? **param : SharedEmptyString;
 }
 
+const char * AsyncWebServerRequest::pathArg(size_t i, size_t *len) const {
+  if(i < _pathSpanCount){
+    *len = _pathSpans[i].length;
+    return _url.c_str() + _pathSpans[i].offset;
+  }
+  auto param = _pathParams.nth(i);
+  *len = param ? (*param)->length() : 0;
+  return param ? (*param)->c_str() : "";
+}
+
+long AsyncWebServerRequest::pathArgInt(size_t i, long defaultValue) const {
+  size_t len;
+  const char *p = pathArg(i, &len);
+  if(!len)
+    return defaultValue;
+  long value = 0;
+  for(size_t n = 0; n < len; n++){
+    if(p[n] < '0' || p[n] > '9')
+      return defaultValue;
+    value = value * 10 + (p[n] - '0');
+  }
+  return value;
+}
+
 const String& AsyncWebServerRequest::header(const char* name) const {
   AsyncWebHeader* h = getHeader(String(name));
   return h ? h->value() : SharedEmptyString;
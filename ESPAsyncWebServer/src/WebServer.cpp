@@ -34,6 +34,7 @@ AsyncWebServer::AsyncWebServer(uint16_t port)
   : _server(port)
   , _rewrites(LinkedList<AsyncWebRewrite*>([](AsyncWebRewrite* r){ delete r; }))
   , _handlers(LinkedList<AsyncWebHandler*>([](AsyncWebHandler* h){ delete h; }))
+  , _openRequests(0)
 {
   _catchAllHandler = new AsyncCallbackWebHandler();
   if(_catchAllHandler == NULL)
@@ -42,7 +43,10 @@ AsyncWebServer::AsyncWebServer(uint16_t port)
     if(c == NULL)
       return;
     c->setRxTimeout(3);
+    ASYNCWEBSERVER_HEAP_TAG(HEAP_WEB_REQUEST);
     AsyncWebServerRequest *r = new AsyncWebServerRequest((AsyncWebServer*)s, c);
+    if(r != NULL)
+      ((AsyncWebServer*)s)->_openRequests++;
     if(r == NULL){
       c->close(true);
       c->free();
@@ -99,6 +103,7 @@ void AsyncWebServer::beginSecure(const char *cert, const char *key, const char *
 #endif
 
 void AsyncWebServer::_handleDisconnect(AsyncWebServerRequest *request){
+  _openRequests--;
   delete request;
 }
 
@@ -27,6 +27,8 @@ FT857D Display
   it is possible to affect pin 25, 26 and 27 for Rx/tx.
   As it is a graphical TFT screen, screen must be cleared before any write to avoid scories of previous writes.
   The tft.fillRect(x,y,width,height, color) function was used for that.
+  The screen is drawn in a RAM copy (TFT_eDirtySprite) and only the changed tiles are sent over the SPI bus,
+  which is faster and removes the flicker of the clear and write sequence.
 
   A web display was added and some CAT commands can be executed from the web page (toogle VFO, SPLIT, frequency input, mode modification , clarifier on/off).
 
@@ -65,7 +67,9 @@ I would like to also thank Rui Santos and Sara Santos for their comprehensive tu
 
 // include the Wi-Fi and webserver libraries
 #include <WiFi.h>
+#include "esp_wifi.h"
 #include "ESPAsyncWebServer.h"
+#include "AsyncBundle.h"
 
 // include the librairies needed for the TFT screen management - SPI bus
 #include <TFT_eSPI.h>
@@ -75,6 +79,11 @@ I would like to also thank Rui Santos and Sara Santos for their comprehensive tu
 // include the librairies for the FT-857D CAT management
 #include <HardwareSerial.h> // replace the softwareserial library used for Arduino
 #include "FT857D-ESP32.h"    // Customized library of the FT857D CAT controls
+#include "TaskRing.h"        // lock-free ring buffers between tasks
+#include "SeqLock.h"         // state published by a task and read by the others
+#include "HeapTelemetry.h"   // heap samples and allocations counted by subsystem
+#include "CycleTrace.h"      // scoped timers dumped for chrome://tracing
+#include "FreqFormat.h"      // frequency of the screen and of the web page, also built by the host benchmark
 
 // TFT declarations for the use on an SPI bus
 
@@ -96,43 +105,183 @@ I would like to also thank Rui Santos and Sara Santos for their comprehensive tu
 #define ADC_EN          14
 #define ADC_PIN         34
 TFT_eSPI tft = TFT_eSPI(135, 240); // Invoke custom library - TTGO screen of 135 pixels x 240 pixels
+// The status screen is drawn in a RAM copy of the screen and only the 16x16 pixels tiles which changed
+// are sent to the TTGO screen. If the RAM is not available the status is drawn directly on the screen.
+TFT_eDirtySprite screen = TFT_eDirtySprite(&tft);
+TFT_eSPI *lcd = &tft;
+uint16_t *screenBuffer = NULL; // pixels of the RAM copy (colours byte swapped), NULL if the screen is not drawn in RAM
+#define SCREEN_W 240
+#define SCREEN_H 135
 int btnDisp = true;
 
 // Variables for the FT-857D CAT and parameters display
 
 FT857D radio; // instanciate the FT857D class i.e. define "radio" so that we may pass CAT commands
-bool On_Air = false;
-String RTStatus;
 bool PTT = false;
-bool Split = false;
-String SPLStatus;
 bool Keyer;
-String KYRStatus;
 bool Break_In;
-String BKStatus;
 byte MeterConf;
-String VFO1;
-String prevVFO = " ";
 bool DNF = false;
-String DNFStatus;
 bool DNR = false;
-String DNRStatus;
 bool DBF = false;
-String DBFStatus;
 bool AGC = false;
 bool Clar = false;
 String ClarStatus;
 String blank = "      ";
-String radmode = "   ";
 String reqmode = "LSB";
-String prevmode = "   ";
-String Smeter;
-String prevSmeter = "     ";
-int dly = 500;            // delay for x milliseconds between commands
-String Wfrequency;
+const unsigned long dly = 500; // delay for x milliseconds between two reads of the radio parameters other than the S-meter and TX
 String reqfreq;
 String deltafreq;
-unsigned long frequency_int;
+
+// Regions of the screen (widgets), each one is drawn from some of the radio parameters
+enum {WIDGET_VFO, WIDGET_SMETER, WIDGET_RXTX, WIDGET_SPLIT, WIDGET_MODE, WIDGET_FREQ, WIDGET_DSP, WIDGET_CW, WIDGET_METER, WIDGET_COUNT};
+
+// Radio parameters as last read through the CAT interface. When a field changes the counter of the widget
+// drawn from it is incremented, the display compares the counters with the ones it drew to find what changed.
+// There is no String so that the structure can be copied to the display task.
+struct RadioState {
+  char vfo[2];         // "a" or "b"
+  char smeter[6];      // "S0" .. "S9+60"
+  byte smeterLevel;    // 0 .. 15 for the same values, read more often than the other fields
+  bool tx;
+  bool split;
+  unsigned long freq;  // in 10 Hz
+  char mode[4];        // "LSB", "CW " ...
+  bool dbf, dnf, dnr;
+  bool cw;             // mode is CW or CWR : the keyer and break-in status are displayed
+  bool keyer, breakIn;
+  bool linkUp;         // the radio answers the CAT commands
+  long catRate;        // bps, rate found by detectCatRate(), 0 if the radio did not answer
+  uint16_t changes[WIDGET_COUNT];
+};
+RadioState radioState;                      // written by the CAT task, which polls the radio
+
+// After each read the CAT task publishes a copy of radioState. The display and web server tasks read a consistent
+// snapshot of it at any time : the CAT task never waits for them and they never see half of an update.
+SeqLock<RadioState> radioPublished;
+
+// The CAT task is the only one which uses the serial link to the radio. The web server handlers do not send
+// CAT commands : they push a CatCommand in a lock-free ring, wake up the CAT task and return at once. Each queued
+// command gets a ticket number, sent back in the X-CAT-Ticket header, and /catdone?ticket=n tells whether it
+// was sent to the radio. The ticket is the position of the command in the ring plus one : it is only given
+// by a successful push, and the CAT task pops and sends the commands in the order of their tickets.
+enum {CAT_SWITCH_VFO, CAT_SPLIT, CAT_SET_MODE, CAT_SET_FREQ, CAT_STEP_FREQ, CAT_CLAR};
+struct CatCommand {
+  byte type;
+  long value;          // frequency or step in 10 Hz, true / false for the split and the clarifier
+  char mode[4];        // for CAT_SET_MODE
+  unsigned long queued; // micros() when queued
+};
+#define CAT_QUEUE_LENGTH 16
+#define CAT_STACK 4096                      // bytes
+MpscRing<CatCommand, CAT_QUEUE_LENGTH> catQueue;
+TaskHandle_t catTaskHandle = NULL;          // notified when a command is queued
+bool catTaskOK = false;                     // if the task could not be created loop() polls the radio itself
+volatile uint32_t catDone = 0;              // ticket of the last command sent to the radio (they run in order)
+
+// The screen is drawn by its own task, on the other core than the CAT task, at its own frame rate, from the
+// latest published radio state.
+#define DISPLAY_STACK 4096                  // bytes
+bool displayTaskOK = false;                 // if the task could not be created the CAT task draws the screen
+RadioState drawState;                       // the state drawn on the screen, only used by the display task
+
+uint16_t dirtyWidgets = 0xFFFF;             // one bit per widget, everything is drawn at start
+unsigned long widgetRedraws[WIDGET_COUNT];  // number of times each widget was drawn
+unsigned long displayFrames = 0;            // number of display frames
+volatile unsigned long displayMillis = 0;   // time spent drawing and pushing the frames, never reset
+#define DISPLAY_STATS_PERIOD 60000          // ms between two printouts of the redraw counters on the serial port, 0 = none
+unsigned long drawMicros = 0, pushMicros = 0; // time spent in the display steps since the last printout
+volatile unsigned long pollPasses = 0, pollMicros = 0; // number of polls and total time spent in them, never reset
+
+// Pre-rendered characters of the frequency readout
+#define GLYPH_W 17                          // width of a digit cell of the frequency readout
+#define GLYPH_H 25
+const char glyphChars[] = "0123456789. ";   // the space is an empty cell
+uint16_t *glyphAtlas = NULL;                // GLYPH_W x GLYPH_H pixels per character, NULL if the RAM is not available
+char shownFreq[9];                          // characters displayed in the 8 digit cells and the point cell, 0 = to be drawn
+
+// Graphical S-meter : a bar of 15 segments (S1 to S9+60) with a peak hold under the frequency and an
+// analog needle at the right of the mode. The S-meter alone is read every SMETER_PERIOD ms.
+#define SMETER_PERIOD 33                    // ms between two S-meter reads and meter frames (30 frames per second)
+#define SMETER_NEEDLE 1                     // 1 = draw the needle (only when the screen is drawn in RAM), 0 = bar only
+#define PEAK_HOLD 1000                      // ms the peak segment is held
+#define PEAK_DECAY 100                      // ms per segment when the peak segment falls back
+#define BAR_Y 101                           // bar of 15 segments of 16 x 8 pixels
+#define NEEDLE_X 198                        // pivot of the needle
+#define NEEDLE_Y 72
+#define NEEDLE_LEN 40
+TFT_eSprite needle = TFT_eSprite(&tft);
+bool needleOK = false;                      // the needle Sprite was created
+byte meterPeak = 0;                         // peak hold segment
+unsigned long peakTime = 0;                 // time of the peak, or of the last decay step
+int needleAngle = -60;                      // needle angle in degrees, follows the S-meter with some inertia
+byte shownLevel = 0, shownPeak = 0;         // segments as drawn
+bool meterDrawn = false;                    // the bar was drawn at least once
+int16_t needleBox[4];                       // bounding box of the needle as drawn : min x, min y, max x, max y
+bool needleDrawn = false;
+unsigned long meterMicros = 0;              // CPU time spent drawing the meter since the last printout
+unsigned long meterBytes = 0;               // bytes sent to the screen in the frames where the meter was drawn
+
+// CAT transactions are scheduled by class. The commands queued by the web server go first, then the polls which
+// animate the display (S-meter, transmit state), then the background polls of the other parameters, the most late
+// first within a class. A poll is due every period ms; once it is late by more than its promotion delay it runs
+// before everything else, commands included, so that a dial turned for a long time does not freeze the rest of
+// the display. A transaction in progress is never interrupted : a command waits at most for its end.
+enum {CAT_CLASS_COMMAND, CAT_CLASS_FAST, CAT_CLASS_BACKGROUND, CAT_CLASS_COUNT};
+const char *catClassNames[CAT_CLASS_COUNT] = {"command", "fast", "background"};
+struct CatPoll {
+  void (*read)();        // CAT transaction(s) updating radioState
+  byte cls;              // CAT_CLASS_FAST or CAT_CLASS_BACKGROUND
+  unsigned long period;  // ms between two reads
+  unsigned long promote; // ms of lateness after which the poll runs first
+  unsigned long due;     // micros() of the next read
+};
+void pollSMeter();
+void pollTx();
+void pollFreqMode();
+void pollVFO();
+void pollSplit();
+void pollDSP();
+void pollCW();
+CatPoll catPolls[] = {
+  {pollSMeter,   CAT_CLASS_FAST,       SMETER_PERIOD, SMETER_PERIOD, 0},
+  {pollTx,       CAT_CLASS_FAST,       100,           100,           0},
+  {pollFreqMode, CAT_CLASS_BACKGROUND, dly,           dly,           0},
+  {pollVFO,      CAT_CLASS_BACKGROUND, dly,           dly,           0},
+  {pollSplit,    CAT_CLASS_BACKGROUND, dly,           dly,           0},
+  {pollDSP,      CAT_CLASS_BACKGROUND, dly,           dly,           0},
+  {pollCW,       CAT_CLASS_BACKGROUND, dly,           dly,           0},
+};
+#define CAT_POLLS (sizeof(catPolls) / sizeof(catPolls[0]))
+#define CAT_POLL_SMETER 0                   // index of the S-meter poll in catPolls
+
+// Time waited by the transactions of each class : since they were queued (commands) or since they were due (polls).
+// Updated by the CAT task only, runs and waitMicros are never reset.
+struct CatClassStats {
+  unsigned long runs;      // transactions run
+  uint64_t waitMicros;     // total wait
+  unsigned long maxWait;   // longest wait in us since the last printout
+  unsigned long promoted;  // polls run first because they were late
+};
+CatClassStats catStats[CAT_CLASS_COUNT];
+uint64_t catBusyMicros = 0;                 // time spent in CAT transactions, never reset
+uint64_t catPollMicros = 0;                 // part of it spent in polls
+
+// Counters of the CAT task published every CAT_METRICS_PERIOD ms for /metrics
+#define CAT_METRICS_PERIOD 1000
+struct CatMetrics {
+  CatClassStats classes[CAT_CLASS_COUNT];
+  FT857D_Link link;
+  unsigned long polls;
+  uint64_t pollMicros, busyMicros;
+  long rate;
+};
+SeqLock<CatMetrics> catMetrics;
+
+// The CAT rate is detected at start, and again every CAT_DETECT_PERIOD ms while the radio does not answer (its
+// menu may have been changed, or it was off).
+#define CAT_DETECT_PERIOD 10000
+unsigned long catDetectTime = 0;            // millis() of the last detection
 
 // Two possibilities for WiFi network :
 // - the ESP32 is connected to a WiFi Access Point,
@@ -150,51 +299,252 @@ const char* password = "Esp32-accesspoint2-port&&32";
 // Instanciation of the aynchronous web server (port number 80)
 AsyncWebServer server(80);
 
-// This function supplies the values of the placeholders in the HTML code (%VAR%)with the effective radio parameters values
+// Responses of the web server counted by route (uri pattern of the handler which answered) and status class
+// for /metrics. Only used by the web server task.
+#define METRIC_ROUTES 48                    // the responses of the routes beyond are counted in the last one
+struct RouteMetrics {
+  const char *route;                        // "none" : no handler (not found)
+  uint32_t responses[5];                    // 1xx .. 5xx
+};
+RouteMetrics routeMetrics[METRIC_ROUTES];
+byte metricRoutes = 0;                      // entries used
+
+// Families of /metrics, in the order they are written
+enum {
+  MF_UPTIME, MF_CAT_POLLS, MF_CAT_POLL_SECONDS, MF_CAT_BUSY_SECONDS, MF_CAT_TRANSACTIONS, MF_CAT_WAIT_SECONDS,
+  MF_CAT_PROMOTED, MF_CAT_COMMANDS, MF_CAT_TIMEOUTS, MF_CAT_SHORT_REPLIES, MF_CAT_RESYNCS, MF_CAT_STALE_BYTES,
+  MF_CAT_LINK_UP, MF_CAT_RATE, MF_CAT_REPLY_SECONDS, MF_CAT_QUEUE_DEPTH, MF_CAT_QUEUE_CAPACITY,
+  MF_DISPLAY_FRAMES, MF_DISPLAY_SECONDS, MF_HTTP_RESPONSES, MF_HTTP_OPEN_REQUESTS,
+  MF_HEAP_FREE, MF_HEAP_LARGEST_FREE_BLOCK, MF_HEAP_MIN_FREE, MF_PSRAM_FREE, MF_HEAP_ALLOCS, MF_HEAP_FREES,
+  MF_HEAP_LIVE, MF_WIFI_STATIONS, MF_WIFI_STATION_RSSI, METRIC_FAMILIES
+};
+struct MetricFamily {
+  const char *name, *type, *help;
+};
+const MetricFamily metricFamilies[METRIC_FAMILIES] = {
+  {"ft857_uptime_seconds", "gauge", "Time since the start."},
+  {"ft857_cat_polls_total", "counter", "Polls of the radio parameters."},
+  {"ft857_cat_poll_seconds_total", "counter", "Time spent in the polls."},
+  {"ft857_cat_busy_seconds_total", "counter", "Time spent in CAT transactions, polls and commands."},
+  {"ft857_cat_transactions_total", "counter", "CAT transactions by scheduling class."},
+  {"ft857_cat_wait_seconds_total", "counter", "Time the transactions waited to be run, by class."},
+  {"ft857_cat_promoted_total", "counter", "Polls run first because they were late, by class."},
+  {"ft857_cat_commands_total", "counter", "Commands sent to the radio."},
+  {"ft857_cat_timeouts_total", "counter", "Replies not received before the timeout."},
+  {"ft857_cat_short_replies_total", "counter", "Replies with missing bytes at the timeout."},
+  {"ft857_cat_resyncs_total", "counter", "Input discarded after a failed reply."},
+  {"ft857_cat_stale_bytes_total", "counter", "Bytes received out of any reply."},
+  {"ft857_cat_link_up", "gauge", "1 if the radio answers."},
+  {"ft857_cat_rate_bps", "gauge", "Rate of the serial link to the radio."},
+  {"ft857_cat_reply_seconds", "histogram", "Time from a command to the end of its reply."},
+  {"ft857_cat_queue_depth", "gauge", "Commands queued for the CAT task."},
+  {"ft857_cat_queue_capacity", "gauge", "Size of the CAT command queue."},
+  {"ft857_display_frames_total", "counter", "Display frames."},
+  {"ft857_display_seconds_total", "counter", "Time spent drawing and pushing the frames."},
+  {"ft857_http_responses_total", "counter", "HTTP responses by route and status class."},
+  {"ft857_http_open_requests", "gauge", "Connections with a request being received or answered."},
+  {"ft857_heap_free_bytes", "gauge", "Free internal heap."},
+  {"ft857_heap_largest_free_block_bytes", "gauge", "Largest block of internal heap which can be allocated."},
+  {"ft857_heap_min_free_bytes", "gauge", "Lowest free heap since the start."},
+  {"ft857_psram_free_bytes", "gauge", "Free PSRAM, 0 without PSRAM."},
+  {"ft857_heap_allocs_total", "counter", "Allocations by new, by subsystem."},
+  {"ft857_heap_frees_total", "counter", "Blocks freed by delete, by subsystem."},
+  {"ft857_heap_live_bytes", "gauge", "Bytes allocated by new and not freed, by subsystem."},
+  {"ft857_wifi_stations", "gauge", "Stations connected to the access point."},
+  {"ft857_wifi_station_rssi_dbm", "gauge", "Signal of each station connected to the access point."},
+};
+
+// Cursor of /metrics over the families, kept by the response between the chunks (see /trace.json). The snapshots
+// of the other tasks and the list of the stations are taken once, so that the lines of a family agree.
+struct MetricsCursor {
+  CatMetrics cat;
+  HeapTagStats heap[HEAP_TAGS];
+  wifi_sta_list_t stations;
+  byte family;                              // METRIC_FAMILIES at the end
+  uint16_t sample;                          // 0 : the HELP and TYPE lines, then 1 + the sample of the family
+  char pending[192];                        // line being written
+  uint8_t length, sent;                     // its length and the bytes already in a chunk
+};
+
+// Cache policies of the web client files.
+// The fingerprinted assets (their name contains a hash of their content) never change and are cached by the browser
+// for one year, the HTML page and the non fingerprinted names are revalidated at each load.
+#define ASSET_MANIFEST          "/assets.txt"
+#define ASSET_CACHE_IMMUTABLE   "public, max-age=31536000, immutable"
+#define ASSET_CACHE_REVALIDATE  "no-cache"
+
+// Read-only bundle of the web client assets, memory-mapped from the "assets" flash partition (see partitions.csv)
+AsyncBundle assets;
+
+// This function supplies the values of the placeholders in the HTML code (%VAR%) with the effective radio parameters values,
+// taken from a snapshot of the published radio state
 //
 String processor(const String& var){
+  RadioState s;
+  radioPublished.read(s);
+  return webField(s, var);
+}
+
+// Text of a radio parameter displayed on the web page
+//
+String webField(const RadioState &s, const String& var) {
 
   if (var == "VFO") {
-    return VFO1;}
+    return s.vfo;}
 
   if (var == "SMETER") {
-      return Smeter;}
+      return s.smeter;}
 
   if (var == "RXTX") {
-      return RTStatus;}
+      return s.tx ? "Tx" : "Rx";}
 
   if (var == "SPLIT") {
-      return SPLStatus;}
+      return s.split ? "SPL" : "   ";}
 
   if (var == "MODE") {
-      return radmode;}
+      return s.mode;}
 
   if (var == "FREQ") {
-      return Wfrequency;}
+      return formatFreq(s.freq);}
 
   if (var == "BK") {
-      return BKStatus;}
+      return (s.cw && s.breakIn) ? "BK" : "  ";}
 
   if (var == "KYR") {
-      return KYRStatus;}
+      return (s.cw && s.keyer) ? "KYR" : "   ";}
 
   if (var == "DNF") {
-      return DNFStatus;}
+      return s.dnf ? "DNF" : "   ";}
 
   if (var == "DNR") {
-      return DNRStatus;}
+      return s.dnr ? "DNR" : "   ";}
 
   if (var == "DBF") {
-      return DBFStatus;}
+      return s.dbf ? "DBF" : "   ";}
+
+  if (var == "LINK") {
+      return s.linkUp ? "OK" : "NO CAT";}
+
+  if (var == "CATRATE") {
+      return String(s.catRate);}
 
   if (var == "CLAR") {
-      return ClarStatus;}
+      return ClarStatus;} // only used by the web server task
+
+  return String();
+}
+
+// Answers the request of one radio parameter. The text is copied in the response and the version of the
+// snapshot (number of radio state updates) is sent in the X-Radio-Version header.
+//
+void sendField(AsyncWebServerRequest *request, const String& var) {
+  RadioState s;
+  uint32_t version = radioPublished.read(s);
+  AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", webField(s, var));
+  response->addHeader("X-Radio-Version", String(version));
+  request->send(response);
+}
+
+
+// Declares the route of one web client asset stored in SPIFFS under path (the file name given by the manifest).
+// A file whose name ends with .gz is sent with the "Content-Encoding: gzip" header.
+//
+void serveAsset(const String& uri, const String& path, const String& type, const char* cache) {
+  server.on(uri.c_str(), HTTP_GET, [uri, path, type, cache](AsyncWebServerRequest *request){
+    AsyncWebServerResponse *response = request->beginResponse(SPIFFS.open(path, "r"), uri, type);
+    if (response == NULL) {request->send(404); return;} // listed in the manifest but not uploaded
+    response->addHeader("Cache-Control", cache);
+    request->send(response);
+  });
+}
+
+// Reads the asset manifest written by tools/build_assets.py and declares the routes of the assets.
+// Each line is : <logical url> <hashed url> <SPIFFS file> <content type>
+// The hashed url is cached for ever by the browser. The logical url (used by the raw data files)
+// still answers with the same content but is revalidated.
+// Returns false if there is no manifest i.e. the raw data directory was uploaded.
+//
+bool loadAssetManifest() {
+  File manifest = SPIFFS.open(ASSET_MANIFEST, "r");
+  if (!manifest || manifest.isDirectory()) {return false;}
+
+  while (manifest.available()) {
+    String line = manifest.readStringUntil('\n');
+    line.trim();
+    int sep1 = line.indexOf(' ');
+    int sep2 = line.indexOf(' ', sep1 + 1);
+    int sep3 = line.indexOf(' ', sep2 + 1);
+    if ((sep1 < 0) || (sep2 < 0) || (sep3 < 0)) {continue;} // malformed line
+    String logical = line.substring(0, sep1);
+    String hashed = line.substring(sep1 + 1, sep2);
+    String path = line.substring(sep2 + 1, sep3);
+    String type = line.substring(sep3 + 1);
+    serveAsset(hashed, path, type, ASSET_CACHE_IMMUTABLE);
+    serveAsset(logical, path, type, ASSET_CACHE_REVALIDATE);
+  }
+  manifest.close();
+  return true;
+}
+
+// Capture of the screen : /screen.bmp and /screen.rle are streamed from the RAM copy of the screen, each chunk
+// is converted when the web server asks for it so the frame is never copied. The display task is not stopped,
+// a capture taken while the screen changes may mix two frames.
+//
+// BMP : 24 bits per pixel, the rows from the bottom one to the top one (720 bytes per row, no padding)
+#define BMP_HEADER 54
+#define BMP_ROW (SCREEN_W * 3)
+#define BMP_SIZE (BMP_HEADER + BMP_ROW * SCREEN_H)
+#define LE16(v) (uint8_t) (v), (uint8_t) ((v) >> 8)
+#define LE32(v) LE16(v), LE16((v) >> 16)
+const uint8_t bmpHeader[BMP_HEADER] = {
+  'B', 'M', LE32(BMP_SIZE), LE32(0), LE32(BMP_HEADER),                   // file header
+  LE32(40), LE32(SCREEN_W), LE32(SCREEN_H), LE16(1), LE16(24), LE32(0), // info header, no compression
+  LE32(BMP_ROW * SCREEN_H), LE32(2835), LE32(2835), LE32(0), LE32(0)    // 72 dpi
+};
+
+size_t fillScreenBMP(uint8_t *buffer, size_t maxLen, size_t index) {
+  size_t n = 0;
+  for (; (n < maxLen) && (index < BMP_SIZE); n++, index++) {
+    if (index < BMP_HEADER) {buffer[n] = bmpHeader[index]; continue;}
+    size_t pos = index - BMP_HEADER;
+    uint16_t c = screenBuffer[(SCREEN_H - 1 - pos / BMP_ROW) * SCREEN_W + (pos % BMP_ROW) / 3];
+    c = (c >> 8) | (c << 8);
+    switch (pos % 3) {
+      case 0:  buffer[n] = c << 3; break;          // blue
+      case 1:  buffer[n] = (c >> 3) & 0xFC; break; // green
+      default: buffer[n] = (c >> 8) & 0xF8; break; // red
+    }
+  }
+  return n;
+}
+
+// RLE : "R565", the width and the height (uint16), then the pixels from the top left corner in runs of 3 bytes :
+// the number of pixels - 1 (1 to 256 pixels) and the RGB565 colour (uint16). Everything is little endian.
+// pixel is the next pixel to send, kept by the response between the chunks. See tools/screen_capture.py.
+#define RLE_HEADER 8
+const uint8_t rleHeader[RLE_HEADER] = {'R', '5', '6', '5', LE16(SCREEN_W), LE16(SCREEN_H)};
+
+size_t fillScreenRLE(uint8_t *buffer, size_t maxLen, size_t index, uint32_t &pixel) {
+  size_t n = 0;
+  for (; (n < maxLen) && (index < RLE_HEADER); n++, index++) {buffer[n] = rleHeader[index];}
+  while ((n + 3 <= maxLen) && (pixel < SCREEN_W * SCREEN_H)) {
+    uint16_t c = screenBuffer[pixel];
+    uint32_t end = pixel + 1;
+    while ((end < SCREEN_W * SCREEN_H) && (end - pixel < 256) && (screenBuffer[end] == c)) {end++;}
+    c = (c >> 8) | (c << 8);
+    buffer[n++] = end - pixel - 1;
+    buffer[n++] = c;
+    buffer[n++] = c >> 8;
+    pixel = end;
+  }
+  return n;
 }
 
 
 void setup() {
     Serial.begin(115200); // serial link to the PC for debugging purposes
-    radio.begin(38400); // serial link to the FT-857
+    cycleTrace.begin();
+    detectCatRate(); // serial link to the FT-857
 
     // screen initialization
     tft.init();
@@ -243,23 +593,59 @@ void setup() {
      tft.println(IP); // F6CZV
 
      delay(3000); // display the IP address during 3s
-     tft.fillRect(0,0,240,135, TFT_BLUE); // erase the screen display
-     tft.setTextSize(3);
-     tft.setCursor(0, 35); // (x colonne , y ligne) - F6CZV
-     tft.print("VFO"); // F6CZV
+     screenBuffer = (uint16_t*) screen.createSprite(SCREEN_W, SCREEN_H); // 240 x 135 x 2 bytes
+     if (screenBuffer != NULL) {lcd = &screen;}
+     tft.initDMA(); // the changed parts of the sprite are sent by DMA while the loop polls the radio
+     if (SMETER_NEEDLE && lcd == &screen && needle.createSprite(3, NEEDLE_LEN)) {
+       needle.fillSprite(TFT_WHITE);
+       needle.setPivot(1, NEEDLE_LEN - 1); // the needle rotates around its bottom end
+       screen.setPivot(NEEDLE_X, NEEDLE_Y);
+       needleOK = true;
+     }
+     lcd->setTextColor(TFT_WHITE, TFT_BLUE); // with a background colour each character is sent in one block
+     lcd->fillRect(0,0,240,135, TFT_BLUE); // erase the screen display
+     lcd->setTextSize(3);
+     lcd->setCursor(0, 35); // (x colonne , y ligne) - F6CZV
+     lcd->print("VFO"); // F6CZV
+     lcd->setCursor(120,75); // the comma and "kHz" do not change, only the digits are redrawn
+     lcd->print(",");
+     lcd->setCursor(177,75); // (num colonne , num ligne)
+     lcd->print("kHz");
+     buildGlyphAtlas();
+     drawDial();
+
+     // from now on only the display task draws on the screen
+     displayTaskOK = xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_STACK, NULL, 1, NULL, 1 - xPortGetCoreID()) == pdPASS;
+
+   //start the file manager SPIFFS. It must be started before the web server routes are defined
+   // as the asset manifest is read from the flash memory
+  if (!SPIFFS.begin(true)) {Serial.println("SPIFFS non démarré");}
 
    // Web server request management :
 
+   // The HTML file is processed by the template processor at each request, it is small and is
+   // always revalidated by the browser.
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
+      AsyncWebServerResponse *response = request->beginResponse(SPIFFS, "/index.html", String(), false, processor);
+      response->addHeader("Cache-Control", ASSET_CACHE_REVALIDATE);
+      request->send(response);
+   });
+
    // Upload to the web client of the necessary files from the SPIFFS file mgt:
-   // - HTML file,
    // - css file,
    // - javascript jogdial.js function to manage the VFO dial
    // - the images of the FT-857D, dial, knob and tx LED.
-
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send(SPIFFS, "/index.html", String(), false, processor);
-   });
-
+   // If the files were prepared by tools/build_assets.py they are minified, gzipped and fingerprinted
+   // and the browser may cache them forever. Otherwise the raw files of the data directory are served.
+   // If the asset bundle (tools/asset_bundle.py) was flashed, the files are streamed directly from the
+   // memory-mapped flash partition instead of SPIFFS.
+
+   if (assets.begin()) {
+     server.addHandler(new AsyncBundleWebHandler(assets));
+     Serial.print("Asset bundle loaded : ");
+     Serial.println(assets.count());}
+   else if (loadAssetManifest()) {Serial.println("Asset manifest loaded");}
+   else {
    server.on("/style.css", HTTP_GET, [](AsyncWebServerRequest *request){
   request->send(SPIFFS, "/style.css","text/css");
   });
@@ -287,52 +673,71 @@ void setup() {
    server.on("/run", HTTP_GET, [](AsyncWebServerRequest *request){
         request->send(SPIFFS, "/run.gif", "image/gif");
    });
+   }
 
    // for each request the value to be displayed on the web page is supplied
-   // the values are stored in global variables.
-   // If the variable type is not a char * the variable must be converted
-   // from String to char * by the c_str()function
+   // from a snapshot of the radio state published by the CAT task
    //
    server.on("/vfo", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send_P(200, "text/plain", VFO1.c_str()); // VFO A or B
+     sendField(request, "VFO"); // VFO A or B
    });
    server.on("/smeter", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", Smeter.c_str()); // Smeter value
+     sendField(request, "SMETER"); // Smeter value
     });
    server.on("/rxtx", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", RTStatus.c_str()); // Rx / Tx indication
+     sendField(request, "RXTX"); // Rx / Tx indication
     });
     server.on("/split", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", SPLStatus.c_str()); // Split
+     sendField(request, "SPLIT"); // Split
     });
     server.on("/mode", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain",radmode.c_str()); // radio mode
+     sendField(request, "MODE"); // radio mode
     });
     server.on("/freq", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", Wfrequency.c_str()); // frequency
+     sendField(request, "FREQ"); // frequency
     });
 
     server.on("/kyr", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", KYRStatus.c_str()); // keyer status
+     sendField(request, "KYR"); // keyer status
     });
 
     server.on("/bk", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", BKStatus.c_str()); // Break-In status
+     sendField(request, "BK"); // Break-In status
     });
 
     server.on("/dbf", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", DBFStatus.c_str());
+     sendField(request, "DBF");
     });
 
     server.on("/dnr", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", DNRStatus.c_str());
+     sendField(request, "DNR");
     });
 
     server.on("/dnf", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", DNFStatus.c_str());
+     sendField(request, "DNF");
     });
     server.on("/clar", HTTP_GET, [](AsyncWebServerRequest *request){
-     request->send_P(200, "text/plain", ClarStatus.c_str());
+     sendField(request, "CLAR");
+    });
+    server.on("/link", HTTP_GET, [](AsyncWebServerRequest *request){
+     sendField(request, "LINK"); // the radio answers the CAT commands
+    });
+    server.on("/catrate", HTTP_GET, [](AsyncWebServerRequest *request){
+     sendField(request, "CATRATE"); // bps, 0 if the radio did not answer
+    });
+
+    // capture of the TTGO screen
+    server.on("/screen.bmp", HTTP_GET, [](AsyncWebServerRequest *request){
+     if (screenBuffer == NULL) {request->send(503, "text/plain", "The screen is not drawn in RAM"); return;}
+     request->send(request->beginChunkedResponse("image/bmp", fillScreenBMP));
+    });
+    server.on("/screen.rle", HTTP_GET, [](AsyncWebServerRequest *request){
+     if (screenBuffer == NULL) {request->send(503, "text/plain", "The screen is not drawn in RAM"); return;}
+     uint32_t pixel = 0;
+     request->send(request->beginChunkedResponse("application/octet-stream",
+       [pixel](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+         return fillScreenRLE(buffer, maxLen, index, pixel);
+       }));
     });
 
     // action following the click on the Toggle VFO button
@@ -340,8 +745,7 @@ void setup() {
     // by the client web page
     //
     server.on("/ToggleVFO", HTTP_GET, [](AsyncWebServerRequest *request){
-     radio.switchVFO();
-     request->send(200, "text/plain", "OK");
+     sendQueued(request, queueCatCommand(CAT_SWITCH_VFO, 0, ""));
     });
 
     // action following the click on the Toggle split button
@@ -349,10 +753,9 @@ void setup() {
     // by the client web page
     //
     server.on("/Togglesplit", HTTP_GET, [](AsyncWebServerRequest *request){
-     if (Split) {radio.split(false);}
-     else
-     {radio.split(true);}
-     request->send(200, "text/plain", "OK");
+     RadioState s;
+     radioPublished.read(s);
+     sendQueued(request, queueCatCommand(CAT_SPLIT, !s.split, ""));
     });
 
     // action following the selection of the radio mode on the mode form
@@ -362,8 +765,10 @@ void setup() {
     server.on("/setmode", HTTP_GET, [](AsyncWebServerRequest *request){
       reqmode = request->getParam("Fmode")->value();
       // Serial.println(reqmode);
-     if (reqmode != radmode) {radio.setMode(reqmode);}
-     request->send(200, "text/plain", "OK");
+     RadioState s;
+     radioPublished.read(s);
+     if (reqmode == s.mode) {request->send(200, "text/plain", "OK"); return;}
+     sendQueued(request, queueCatCommand(CAT_SET_MODE, 0, reqmode));
     });
     //
     // action following the input of the frequency on the frequency form
@@ -371,8 +776,7 @@ void setup() {
     server.on("/setfreq", HTTP_GET, [](AsyncWebServerRequest *request){
       reqfreq = request->getParam("FFreq")->value() + "00";
       // Serial.println(reqfreq);
-     radio.setFreq(reqfreq.toInt());
-     request->send(200, "text/plain", "OK");
+     sendQueued(request, queueCatCommand(CAT_SET_FREQ, reqfreq.toInt(), ""));
     });
     //
     // request to update the frequency if the VFO dial was rotated
@@ -380,8 +784,7 @@ void setup() {
     server.on("/updatefrequency", HTTP_GET, [](AsyncWebServerRequest *request){
       deltafreq = request->getParam(0)->value();
      // Serial.println(reqfreq);
-     radio.setFreq(frequency_int + deltafreq.toInt());
-     request->send(200, "text/plain", "OK");
+     sendQueued(request, queueCatCommand(CAT_STEP_FREQ, deltafreq.toInt(), "")); // added to the frequency when sent
     });
 
 
@@ -393,187 +796,844 @@ void setup() {
     // by the client web page
     //
     server.on("/Toggleclar", HTTP_GET, [](AsyncWebServerRequest *request){
-     if (Clar) {radio.clar(false);
-                Clar = false; ClarStatus = " ";}
-     else
-     {radio.clar(true);
-      Clar = true;ClarStatus = "-";}
-     request->send(200, "text/plain", "OK");
+     uint32_t ticket = queueCatCommand(CAT_CLAR, !Clar, "");
+     if (ticket != 0) {Clar = !Clar; ClarStatus = Clar ? "-" : " ";}
+     sendQueued(request, ticket);
+    });
+
+    // completion of a queued command : "1" if the command of the ticket was sent to the radio, else "0"
+    server.on("/catdone", HTTP_GET, [](AsyncWebServerRequest *request){
+     if (!request->hasParam("ticket")) {request->send(400, "text/plain", "No ticket"); return;}
+     uint32_t ticket = request->getParam("ticket")->value().toInt();
+     request->send(200, "text/plain", (ticket != 0) && (ticket <= catDone) ? "1" : "0");
+    });
+
+    // heap samples, oldest first, and allocations by subsystem
+    server.on("/heap", HTTP_GET, [](AsyncWebServerRequest *request){
+     sendHeapTelemetry(request);
+    });
+
+    // Prometheus metrics of the whole device
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request){
+     sendMetrics(request);
     });
+    server.onResponse(countResponse);
+
+    // last events of the scoped timers in the Chrome Trace Event format, streamed from the rings of the two cores
+    // (see the cursor of /screen.rle)
+    server.on("/trace.json", HTTP_GET, [](AsyncWebServerRequest *request){
+     TraceCursor cursor;
+     cycleTrace.startRead(cursor);
+     request->send(request->beginChunkedResponse("application/json",
+       [cursor](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+         return cycleTrace.fillJson(cursor, buffer, maxLen);
+       }));
+    });
+
+  // from now on only the CAT task uses the serial link to the radio, on the core where loop() runs. It is created
+  // before the web server starts : a request may queue a command and notify it at once.
+  catTaskOK = xTaskCreatePinnedToCore(catTask, "cat", CAT_STACK, NULL, 1, &catTaskHandle, xPortGetCoreID()) == pdPASS;
+  if (!catTaskOK) {catTaskHandle = xTaskGetCurrentTaskHandle();} // setup() and loop() run in the same task
 
   // Start web server
    server.begin();
-
-  //start the file manager SPIFFS
-  if (!SPIFFS.begin(true)) {Serial.println("SPIFFS non démarré");}
 }
 
 void loop(){
+  if (catTaskOK) {vTaskDelete(NULL);} // the radio is polled by the CAT task, loop() is not used
+  catCycle();
+}
+
+// CAT task : the only user of the serial link to the radio
+//
+void catTask(void *param) {
+  heapTag(HEAP_CAT);
+  for (;;) {catCycle();}
+}
+
+// The CAT task runs the commands queued by the web server and the polls of the radio parameters as scheduled by
+// nextPoll(), and publishes the radio state for the display and web server tasks after each transaction. When
+// nothing is due the task waits for a command until the next poll.
+//
+void catCycle() {
+  if (!radio.link().up && millis() - catDetectTime >= CAT_DETECT_PERIOD) {
+    detectCatRate();
+    radioState.linkUp = radio.link().up;
+    radioPublished.write(radioState);
+    return;
+  }
+  unsigned long now = micros();
+  int p = nextPoll(now);
+  CatCommand cmd;
+  uint32_t position;
+  if ((p < 0 || !catPromoted(p, now)) && catQueue.pop(cmd, &position)) {
+    countWait(CAT_CLASS_COMMAND, now - cmd.queued, false);
+    runCatCommand(cmd);
+    catDone = position + 1;
+    catBusyMicros += micros() - now;
+    radioState.linkUp = radio.link().up;
+    radioPublished.write(radioState);
+    for (byte i = 0; i < CAT_POLLS; i++) { // the parameters are read at once to show the result
+      if (catPolls[i].cls == CAT_CLASS_BACKGROUND && (long) (catPolls[i].due - now) > 0) {catPolls[i].due = now;}
+    }
+    return;
+  }
+  if (p < 0) { // until a command or the next poll
+    unsigned long next = now + 1000000;
+    for (byte i = 0; i < CAT_POLLS; i++) {
+      if ((long) (catPolls[i].due - next) < 0) {next = catPolls[i].due;}
+    }
+    TickType_t ticks = pdMS_TO_TICKS((next - now + 999) / 1000);
+    ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+    return;
+  }
+
+  CatPoll &poll = catPolls[p];
+  countWait(poll.cls, now - poll.due, catPromoted(p, now));
+  poll.due += poll.period * 1000; // keeps the cadence unless more than one period late
+  if ((long) (now - poll.due) >= 0) {poll.due = now + poll.period * 1000;}
+  unsigned long t0 = micros();
+  poll.read();
+  radioState.linkUp = radio.link().up;
+  radioPublished.write(radioState);
+  unsigned long pollTime = micros() - t0;
+  pollMicros += pollTime;
+  catPollMicros += pollTime;
+  catBusyMicros += pollTime;
+  pollPasses++;
+
+  if (!displayTaskOK && p == CAT_POLL_SMETER) {displayFrame();}
+  printCatStats();
+  publishCatMetrics();
+  heapTelemetry.poll(millis());
+}
+
+// Publishes the counters of the CAT task for the web server task every CAT_METRICS_PERIOD ms
+//
+void publishCatMetrics() {
+  static unsigned long lastPublish = 0;
+  if (millis() - lastPublish < CAT_METRICS_PERIOD) {return;}
+  lastPublish = millis();
+  CatMetrics m;
+  memcpy(m.classes, catStats, sizeof(m.classes));
+  m.link = radio.link();
+  m.polls = pollPasses;
+  m.pollMicros = catPollMicros;
+  m.busyMicros = catBusyMicros;
+  m.rate = radio.baud();
+  catMetrics.write(m);
+}
+
+// Finds the rate of the serial link set in the radio menu, publishes it and reports it on the serial port with
+// the time of a reply. The fastest rate leaves more time for the polls.
+//
+void detectCatRate() {
+  long rate = radio.detectBaud();
+  catDetectTime = millis();
+  radioState.catRate = rate;
+  if (rate == 0) {
+    Serial.println("CAT : no answer from the radio");
+    return;
+  }
+  Serial.print("CAT rate ");
+  Serial.print(rate);
+  Serial.print(" bps, reply in us ");
+  Serial.println(radio.link().lastRtt);
+  if (rate < FT857D::catRates[0]) {
+    Serial.print("Set the CAT RATE menu of the radio to ");
+    Serial.print(FT857D::catRates[0]);
+    Serial.println(" bps for faster polls");
+  }
+}
+
+// Index in catPolls of the poll to run next, -1 if none is due. The promoted polls go first, the most late
+// past its promotion delay first, then the due polls of the highest class, the most late first.
+//
+int nextPoll(unsigned long now) {
+  int next = -1;
+  bool nextPromoted = false;
+  long nextLate = 0;
+  for (byte p = 0; p < CAT_POLLS; p++) {
+    long late = (long) (now - catPolls[p].due);
+    if (late < 0) {continue;}
+    bool promoted = catPromoted(p, now);
+    if (promoted) {late -= catPolls[p].promote * 1000;}
+    bool better;
+    if (next < 0) {better = true;}
+    else if (promoted != nextPromoted) {better = promoted;}
+    else if (!promoted && catPolls[p].cls != catPolls[next].cls) {better = catPolls[p].cls < catPolls[next].cls;}
+    else {better = late > nextLate;}
+    if (better) {next = p; nextPromoted = promoted; nextLate = late;}
+  }
+  return next;
+}
+
+// True if the poll is late by more than its promotion delay
+//
+bool catPromoted(int p, unsigned long now) {
+  return (long) (now - catPolls[p].due) > (long) (catPolls[p].promote * 1000);
+}
+
+// Adds the wait of a transaction to the statistics of its class
+//
+void countWait(byte cls, unsigned long wait, bool promoted) {
+  CatClassStats &c = catStats[cls];
+  c.runs++;
+  c.waitMicros += wait;
+  if (wait > c.maxWait) {c.maxWait = wait;}
+  if (promoted) {c.promoted++;}
+}
+
+// Prints for each class the number of transactions and their mean and longest wait on the serial port
+//
+void printCatStats() {
+  static unsigned long lastStats = 0;
+  static unsigned long lastRuns[CAT_CLASS_COUNT], lastPromoted[CAT_CLASS_COUNT];
+  static uint64_t lastWait[CAT_CLASS_COUNT];
+  static uint64_t lastBusy = 0;
+  if (!DISPLAY_STATS_PERIOD || (millis() - lastStats < DISPLAY_STATS_PERIOD)) {return;}
+  unsigned long elapsed = millis() - lastStats;
+  lastStats = millis();
+  for (byte cls = 0; cls < CAT_CLASS_COUNT; cls++) {
+    CatClassStats &c = catStats[cls];
+    unsigned long runs = c.runs - lastRuns[cls];
+    if (runs != 0) {
+      Serial.print("CAT ");
+      Serial.print(catClassNames[cls]);
+      Serial.print(" runs ");
+      Serial.print(runs);
+      Serial.print(", wait us mean ");
+      Serial.print((unsigned long) ((c.waitMicros - lastWait[cls]) / runs));
+      Serial.print(" max ");
+      Serial.print(c.maxWait);
+      Serial.print(", promoted ");
+      Serial.println(c.promoted - lastPromoted[cls]);
+    }
+    lastRuns[cls] = c.runs;
+    lastWait[cls] = c.waitMicros;
+    lastPromoted[cls] = c.promoted;
+    c.maxWait = 0;
+  }
+  const FT857D_Link &link = radio.link();
+  Serial.print(link.up ? "CAT link up" : "CAT link down");
+  Serial.print(", rate ");
+  Serial.print(radio.baud());
+  Serial.print(", busy % ");
+  Serial.print((unsigned long) ((catBusyMicros - lastBusy) / (elapsed * 10)));
+  lastBusy = catBusyMicros;
+  Serial.print(", commands ");
+  Serial.print(link.commands);
+  Serial.print(", timeouts ");
+  Serial.print(link.timeouts);
+  Serial.print(", short replies ");
+  Serial.print(link.shortReplies);
+  Serial.print(", resyncs ");
+  Serial.print(link.resyncs);
+  Serial.print(", stale bytes ");
+  Serial.print(link.staleBytes);
+  Serial.print(", S-meter timeout ms ");
+  Serial.println(radio.replyTimeout(CAT_RX_DATA_CMD));
+}
+
+// Sends a queued command to the radio
+//
+void runCatCommand(const CatCommand &cmd) {
+  switch (cmd.type) {
+    case CAT_SWITCH_VFO: radio.switchVFO(); break;
+    case CAT_SPLIT:      radio.split(cmd.value); break;
+    case CAT_SET_MODE:   radio.setMode(cmd.mode); break;
+    case CAT_SET_FREQ:   radio.setFreq(cmd.value);
+                         setField(radioState.freq, (unsigned long) cmd.value, WIDGET_FREQ); break;
+    case CAT_STEP_FREQ:  // the next steps of the dial may be queued before the frequency is read again
+                         radio.setFreq(radioState.freq + cmd.value);
+                         setField(radioState.freq, radioState.freq + cmd.value, WIDGET_FREQ); break;
+    case CAT_CLAR:       radio.clar(cmd.value); break;
+  }
+}
+
+// Queues a command for the CAT task (called by the web server task), returns its ticket or 0 if the queue is full
+//
+uint32_t queueCatCommand(byte type, long value, const String &mode) {
+  CatCommand cmd;
+  cmd.type = type;
+  cmd.value = value;
+  mode.toCharArray(cmd.mode, sizeof(cmd.mode));
+  cmd.queued = micros();
+  uint32_t position;
+  if (!catQueue.push(cmd, &position)) {return 0;}
+  xTaskNotifyGive(catTaskHandle);
+  return position + 1;
+}
+
+// Answers a request which queued a command. The client web page only needs the 200 status, the ticket is in the
+// X-CAT-Ticket header.
+//
+void sendQueued(AsyncWebServerRequest *request, uint32_t ticket) {
+  if (ticket == 0) {request->send(503, "text/plain", "CAT queue full"); return;}
+  AsyncWebServerResponse *response = request->beginResponse(200, "text/plain", "OK");
+  response->addHeader("X-CAT-Ticket", String(ticket));
+  request->send(response);
+}
+
+// Answers /heap : the heap samples in the ring, then the counters of the allocations (new / delete) of each
+// subsystem. The fragmentation is the part of the free heap which cannot be allocated in one block.
+//
+void sendHeapTelemetry(AsyncWebServerRequest *request) {
+  AsyncResponseStream *response = request->beginResponseStream("text/plain");
+  response->print("# time_ms free_heap largest_block min_free_heap fragmentation_% psram_free psram_size\n");
+  uint32_t count = heapTelemetry.samples();
+  uint32_t first = count > HEAP_SAMPLES ? count - HEAP_SAMPLES : 0;
+  for (uint32_t n = first; n < count; n++) {
+    HeapSample s;
+    if (!heapTelemetry.getSample(n, s)) {continue;} // overwritten meanwhile
+    uint32_t fragmentation = s.freeHeap ? 100 - (uint64_t) s.largestBlock * 100 / s.freeHeap : 0;
+    response->printf("%" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+                     s.time, s.freeHeap, s.largestBlock, s.minFreeHeap, fragmentation, s.psramFree, s.psramSize);
+  }
+  response->print("# subsystem allocs frees alloc_bytes live_bytes peak_bytes\n");
+  for (uint8_t tag = 0; tag < HEAP_TAGS; tag++) {
+    HeapTagStats t;
+    heapTelemetry.tagStats(tag, t);
+    response->printf("%s %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 "\n",
+                     heapTagNames[tag], t.allocs, t.frees, t.allocBytes, t.liveBytes, t.peakBytes);
+  }
+  request->send(response);
+}
+
+// Counts a response of the web server by route and status class (called by the web server)
+//
+void countResponse(AsyncWebServerRequest *request, int code) {
+  const char *route = "none";
+  if (request->handler()) {route = request->handler()->route() ? request->handler()->route() : "other";}
+  byte r = 0;
+  while (r < metricRoutes && strcmp(routeMetrics[r].route, route)) {r++;}
+  if (r == METRIC_ROUTES) {r = METRIC_ROUTES - 1; routeMetrics[r].route = "other";}
+  else if (r == metricRoutes) {routeMetrics[r].route = route; metricRoutes++;}
+  byte status = code / 100 - 1;
+  if (status < 5) {routeMetrics[r].responses[status]++;}
+}
+
+// These functions write a line of /metrics in the Prometheus text format and return its length (see snprintf).
+// The seconds are written from microseconds without going through a float.
+//
+int metricHeader(char *line, size_t size, const MetricFamily &f) {
+  return snprintf(line, size, "# HELP %s %s\n# TYPE %s %s\n", f.name, f.help, f.name, f.type);
+}
+
+int metric(char *line, size_t size, const char *name, const char *labels, uint64_t value) {
+  return snprintf(line, size, labels ? "%s{%s} %llu\n" : "%s%s %llu\n", name, labels ? labels : "", (unsigned long long) value);
+}
+
+int metricSeconds(char *line, size_t size, const char *name, const char *labels, uint64_t micros) {
+  return snprintf(line, size, labels ? "%s{%s} %llu.%06lu\n" : "%s%s %llu.%06lu\n", name, labels ? labels : "",
+                  (unsigned long long) (micros / 1000000), (unsigned long) (micros % 1000000));
+}
 
-  // the loop requests the data from the radio, displays it on the TTGO tft screen and updates the global variables
-  //
-  displayVFO();
-  displaySMeter();
-  displayRXTX();
-  displaySplit_status();
-  displayMode();
-  displayFreq(frequency_int);
-  displayDSP();
-
-  // the status of the keyer and Break-in options are only displayed if the mode is CW or CWR
-  //
-  if ((radmode == "CW ") || (radmode == "CWR")) {displayCWConf();}
-  else {tft.fillRect(160, 110, 75, 15, TFT_BLUE);
-        KYRStatus = "   ";
-        BKStatus = "  ";
+// Writes the sample i of the family of the cursor in line. Returns its length, 0 for a sample which is not written
+// (a status class a route never answered with) and -1 after the last sample of the family.
+//
+int metricSample(MetricsCursor &c, uint16_t i, char *line, size_t size) {
+  const char *name = metricFamilies[c.family].name;
+  const FT857D_Link &link = c.cat.link;
+  char labels[64];
+  switch (c.family) {
+    case MF_UPTIME: return i ? -1 : metricSeconds(line, size, name, NULL, (uint64_t) millis() * 1000);
+
+    // CAT task
+    case MF_CAT_POLLS: return i ? -1 : metric(line, size, name, NULL, c.cat.polls);
+    case MF_CAT_POLL_SECONDS: return i ? -1 : metricSeconds(line, size, name, NULL, c.cat.pollMicros);
+    case MF_CAT_BUSY_SECONDS: return i ? -1 : metricSeconds(line, size, name, NULL, c.cat.busyMicros);
+    case MF_CAT_TRANSACTIONS:
+      if (i >= CAT_CLASS_COUNT) {return -1;}
+      snprintf(labels, sizeof(labels), "class=\"%s\"", catClassNames[i]);
+      return metric(line, size, name, labels, c.cat.classes[i].runs);
+    case MF_CAT_WAIT_SECONDS:
+      if (i >= CAT_CLASS_COUNT) {return -1;}
+      snprintf(labels, sizeof(labels), "class=\"%s\"", catClassNames[i]);
+      return metricSeconds(line, size, name, labels, c.cat.classes[i].waitMicros);
+    case MF_CAT_PROMOTED:
+      if (CAT_CLASS_FAST + i >= CAT_CLASS_COUNT) {return -1;}
+      snprintf(labels, sizeof(labels), "class=\"%s\"", catClassNames[CAT_CLASS_FAST + i]);
+      return metric(line, size, name, labels, c.cat.classes[CAT_CLASS_FAST + i].promoted);
+    case MF_CAT_COMMANDS: return i ? -1 : metric(line, size, name, NULL, link.commands);
+    case MF_CAT_TIMEOUTS: return i ? -1 : metric(line, size, name, NULL, link.timeouts);
+    case MF_CAT_SHORT_REPLIES: return i ? -1 : metric(line, size, name, NULL, link.shortReplies);
+    case MF_CAT_RESYNCS: return i ? -1 : metric(line, size, name, NULL, link.resyncs);
+    case MF_CAT_STALE_BYTES: return i ? -1 : metric(line, size, name, NULL, link.staleBytes);
+    case MF_CAT_LINK_UP: return i ? -1 : metric(line, size, name, NULL, link.up);
+    case MF_CAT_RATE: return i ? -1 : metric(line, size, name, NULL, c.cat.rate);
+    case MF_CAT_REPLY_SECONDS: { // the buckets, then the sum and the count
+      uint64_t replies = 0;
+      for (byte b = 0; b < CAT_LATENCY_BUCKETS && b <= i; b++) {replies += link.rttBuckets[b];}
+      if (i < CAT_LATENCY_BUCKETS - 1) {snprintf(labels, sizeof(labels), "le=\"%.3f\"", catLatencyBounds[i] / 1000.0);}
+      else if (i == CAT_LATENCY_BUCKETS - 1) {strcpy(labels, "le=\"+Inf\"");}
+      else if (i == CAT_LATENCY_BUCKETS) {return metricSeconds(line, size, "ft857_cat_reply_seconds_sum", NULL, link.rttMicros);}
+      else if (i == CAT_LATENCY_BUCKETS + 1) {return metric(line, size, "ft857_cat_reply_seconds_count", NULL, replies);}
+      else {return -1;}
+      return metric(line, size, "ft857_cat_reply_seconds_bucket", labels, replies);
+    }
+    case MF_CAT_QUEUE_DEPTH: return i ? -1 : metric(line, size, name, NULL, catQueue.size());
+    case MF_CAT_QUEUE_CAPACITY: return i ? -1 : metric(line, size, name, NULL, catQueue.capacity());
+
+    // display task
+    case MF_DISPLAY_FRAMES: return i ? -1 : metric(line, size, name, NULL, displayFrames);
+    case MF_DISPLAY_SECONDS: return i ? -1 : metricSeconds(line, size, name, NULL, (uint64_t) displayMillis * 1000);
+
+    // web server
+    case MF_HTTP_RESPONSES: { // by route, then by status class
+      byte r = i / 5, status = i % 5;
+      if (r >= metricRoutes) {return -1;}
+      if (routeMetrics[r].responses[status] == 0) {return 0;}
+      snprintf(labels, sizeof(labels), "route=\"%s\",code=\"%dxx\"", routeMetrics[r].route, status + 1);
+      return metric(line, size, name, labels, routeMetrics[r].responses[status]);
+    }
+    case MF_HTTP_OPEN_REQUESTS: return i ? -1 : metric(line, size, name, NULL, server.openRequests());
+
+    // heap
+    case MF_HEAP_FREE: return i ? -1 : metric(line, size, name, NULL, ESP.getFreeHeap());
+    case MF_HEAP_LARGEST_FREE_BLOCK: return i ? -1 : metric(line, size, name, NULL, ESP.getMaxAllocHeap());
+    case MF_HEAP_MIN_FREE: return i ? -1 : metric(line, size, name, NULL, ESP.getMinFreeHeap());
+    case MF_PSRAM_FREE: return i ? -1 : metric(line, size, name, NULL, ESP.getFreePsram());
+    case MF_HEAP_ALLOCS: case MF_HEAP_FREES: case MF_HEAP_LIVE: {
+      if (i >= HEAP_TAGS) {return -1;}
+      const HeapTagStats &t = c.heap[i];
+      snprintf(labels, sizeof(labels), "subsystem=\"%s\"", heapTagNames[i]);
+      return metric(line, size, name, labels, c.family == MF_HEAP_ALLOCS ? t.allocs : c.family == MF_HEAP_FREES ? t.frees : t.liveBytes);
+    }
+
+    // Wi-Fi : the device is the access point, the signal of each station as received by it
+    case MF_WIFI_STATIONS: return i ? -1 : metric(line, size, name, NULL, c.stations.num);
+    case MF_WIFI_STATION_RSSI: {
+      if (i >= c.stations.num) {return -1;}
+      const uint8_t *mac = c.stations.sta[i].mac;
+      return snprintf(line, size, "%s{station=\"%02x:%02x:%02x:%02x:%02x:%02x\"} %d\n", name,
+                      mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], c.stations.sta[i].rssi);
+    }
+  }
+  return -1;
+}
+
+// Fills a chunk of /metrics : the rest of the pending line, then the next lines, family by family. A line cut at
+// the end of a chunk is continued in the next one. Returns 0 after the last family (end of the response).
+//
+size_t fillMetrics(MetricsCursor &c, uint8_t *buffer, size_t maxLen) {
+  size_t n = 0;
+  while (n < maxLen) {
+    if (c.sent < c.length) {
+      size_t len = c.length - c.sent;
+      if (len > maxLen - n) {len = maxLen - n;}
+      memcpy(buffer + n, c.pending + c.sent, len);
+      c.sent += len;
+      n += len;
+      continue;
+    }
+    if (c.family == METRIC_FAMILIES) {break;}
+    int len;
+    if (c.sample == 0) {len = metricHeader(c.pending, sizeof(c.pending), metricFamilies[c.family]);}
+    else {
+      len = metricSample(c, c.sample - 1, c.pending, sizeof(c.pending));
+      if (len < 0) { // next family
+        c.family++;
+        c.sample = 0;
+        continue;
+      }
     }
-   delay(dly);
+    c.sample++;
+    if (len >= (int) sizeof(c.pending)) {len = sizeof(c.pending) - 1;} // a very long route is cut
+    c.length = len;
+    c.sent = 0;
+  }
+  return n;
+}
+
+// Answers /metrics : a chunked response written family by family by fillMetrics(), from the snapshots published
+// by the other tasks, the counters of the web server and the heap and Wi-Fi status, without building a String
+//
+void sendMetrics(AsyncWebServerRequest *request) {
+  MetricsCursor cursor;
+  catMetrics.read(cursor.cat);
+  for (uint8_t tag = 0; tag < HEAP_TAGS; tag++) {heapTelemetry.tagStats(tag, cursor.heap[tag]);}
+  if (esp_wifi_ap_get_sta_list(&cursor.stations) != ESP_OK) {cursor.stations.num = 0;}
+  cursor.family = 0;
+  cursor.sample = 0;
+  cursor.length = cursor.sent = 0;
+  request->send(request->beginChunkedResponse("text/plain; version=0.0.4",
+    [cursor](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+      return fillMetrics(cursor, buffer, maxLen);
+    }));
+}
+
+// Display task : draws a frame every SMETER_PERIOD ms
+//
+void displayTask(void *param) {
+  heapTag(HEAP_DISPLAY);
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    displayFrame();
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(SMETER_PERIOD));
+  }
+}
+
+// Takes the latest published radio state, then redraws on the TTGO tft screen only the widgets whose data changed
+//
+void displayFrame() {
+  RadioState s;
+  radioPublished.read(s);
+  for (byte w = 0; w < WIDGET_COUNT; w++) {
+    if (s.changes[w] != drawState.changes[w]) {dirtyWidgets |= 1 << w;}
+  }
+  drawState = s;
+
+  tickMeter(millis());
+  unsigned long t1 = micros();
+  uint16_t drawn = drawWidgets();
+  unsigned long t2 = micros();
+  if (drawn && lcd == &screen) { // send the changed parts to the TTGO screen, returns before the end of the DMA
+    TRACE_SCOPE("pushDirty");
+    screen.pushDirty(0, 0);
+    if (drawn & (1 << WIDGET_METER)) {meterBytes += screen.pushedBytes();}
+  }
+  unsigned long t3 = micros();
+  drawMicros += t2 - t1;
+  pushMicros += t3 - t2;
+  static unsigned long frameMicros = 0; // below 1 ms
+  frameMicros += t3 - t1;
+  displayMillis += frameMicros / 1000;
+  frameMicros %= 1000;
+  displayFrames++;
+  printDisplayStats();
+}
+
+// These functions store a new value of a RadioState field and count a change of the widget drawn from it
+//
+void setField(char *field, size_t size, const String &value, byte widget) {
+  if (value != field) {strlcpy(field, value.c_str(), size); radioState.changes[widget]++;}
+}
+
+void setField(bool &field, bool value, byte widget) {
+  if (field != value) {field = value; radioState.changes[widget]++;}
+}
+
+void setField(unsigned long &field, unsigned long value, byte widget) {
+  if (field != value) {field = value; radioState.changes[widget]++;}
+}
+
+void setField(byte &field, byte value, byte widget) {
+  if (field != value) {field = value; radioState.changes[widget]++;}
+}
+
+// These functions read some of the radio parameters through the CAT interface (FT857D-ESP32 library functions)
+// and update radioState, they are scheduled by the CAT task. A field is left as it was when the reply was
+// missing or incomplete.
+//
+void pollVFO() {
+  String vfo = radio.getVFO();
+  if (radio.replyOK()) {setField(radioState.vfo, sizeof(radioState.vfo), vfo, WIDGET_VFO);}
+}
+
+void pollTx() {
+  bool tx = radio.chkTx();
+  if (radio.replyOK()) {setField(radioState.tx, tx, WIDGET_RXTX);}
+}
+
+void pollSplit() {
+  bool split = radio.getSPLIT_status();
+  if (radio.replyOK()) {setField(radioState.split, split, WIDGET_SPLIT);}
+}
+
+void pollFreqMode() {
+  RadioState &s = radioState;
+  unsigned long freq = radio.getFreqMode();
+  if (!radio.replyOK()) {return;}
+  setField(s.freq, freq, WIDGET_FREQ);
+  String mode = radio.getMode(); // reads the frequency and the mode again
+  if (!radio.replyOK()) {return;}
+  setField(s.mode, sizeof(s.mode), mode, WIDGET_MODE);
+  setField(s.cw, !strcmp(s.mode, "CW ") || !strcmp(s.mode, "CWR"), WIDGET_CW);
+}
+
+void pollDSP() {
+  RadioState &s = radioState;
+  radio.getAGC_DSP_Conf(AGC,DBF,DNR,DNF);
+  if (!radio.replyOK()) {return;}
+  setField(s.dbf, DBF, WIDGET_DSP);
+  setField(s.dnf, DNF, WIDGET_DSP);
+  setField(s.dnr, DNR, WIDGET_DSP);
+}
+
+// the status of the keyer and Break-in options are only read and displayed if the mode is CW or CWR
+void pollCW() {
+  RadioState &s = radioState;
+  if (!s.cw) {return;}
+  radio.getCW_MTR_Conf(MeterConf,Keyer,Break_In);
+  if (!radio.replyOK()) {return;}
+  setField(s.keyer, Keyer, WIDGET_CW);
+  setField(s.breakIn, Break_In, WIDGET_CW);
+}
+
+// Reads the S-meter only, it is read more often than the other parameters
+//
+void pollSMeter() {
+  RadioState &s = radioState;
+  byte level = radio.getSMeterLevel();
+  if (!radio.replyOK()) {return;}
+  setField(s.smeterLevel, level, WIDGET_METER);
+  setField(s.smeter, sizeof(s.smeter), (level < 10) ? "S" + String(level) : "S9+" + String((level - 9) * 10), WIDGET_SMETER);
+}
+
+// Moves the peak hold and the needle of the meter, called for each frame
+//
+void tickMeter(unsigned long now) {
+  byte level = drawState.smeterLevel;
+  if (level >= meterPeak) {meterPeak = level; peakTime = now;}
+  else if (now - peakTime >= PEAK_HOLD) {meterPeak--; peakTime = now - PEAK_HOLD + PEAK_DECAY;}
+  if (meterPeak != shownPeak) {dirtyWidgets |= 1 << WIDGET_METER;}
+
+  if (!needleOK) {return;}
+  int target = -60 + level * 8; // S0 at -60 degrees, S9+60 at +60 degrees
+  int step = (target - needleAngle) / 2;
+  if (step == 0) {step = target - needleAngle;}
+  if (step != 0) {needleAngle += step; dirtyWidgets |= 1 << WIDGET_METER;}
+}
+
+// Draws the widgets marked in dirtyWidgets, returns the widgets drawn (0 if there was none)
+//
+uint16_t drawWidgets() {
+  TRACE_SCOPE("drawWidgets");
+  uint16_t drawn = dirtyWidgets;
+  if (!drawn) {return 0;}
+  for (byte w = 0; w < WIDGET_COUNT; w++) {
+    if (!(dirtyWidgets & (1 << w))) {continue;}
+    switch (w) {
+      case WIDGET_VFO:    displayVFO(); break;
+      case WIDGET_SMETER: displaySMeter(); break;
+      case WIDGET_RXTX:   displayRXTX(); break;
+      case WIDGET_SPLIT:  displaySplit_status(); break;
+      case WIDGET_MODE:   displayMode(); break;
+      case WIDGET_FREQ:   displayFreq(); break;
+      case WIDGET_DSP:    displayDSP(); break;
+      case WIDGET_CW:     displayCWConf(); break;
+      case WIDGET_METER:  {unsigned long t = micros(); displayMeter(); meterMicros += micros() - t;} break;
+    }
+    widgetRedraws[w]++;
+  }
+  dirtyWidgets = 0;
+  return drawn;
+}
+
+// Prints the number of display frames, of redraws of each widget, the mean time of a radio poll and of the
+// display steps on the serial port
+//
+void printDisplayStats() {
+  static unsigned long lastStats = 0;
+  if (!DISPLAY_STATS_PERIOD || (millis() - lastStats < DISPLAY_STATS_PERIOD)) {return;}
+  lastStats = millis();
+  Serial.print("Display frames ");
+  Serial.print(displayFrames);
+  Serial.print(", redraws VFO SMETER RXTX SPLIT MODE FREQ DSP CW METER :");
+  for (byte w = 0; w < WIDGET_COUNT; w++) {
+    Serial.print(" ");
+    Serial.print(widgetRedraws[w]);
+  }
+  Serial.println();
+  static unsigned long lastFrames = 0, lastPolls = 0, lastPollMicros = 0;
+  unsigned long frames = displayFrames - lastFrames;
+  unsigned long polls = pollPasses - lastPolls; // the poll counters are updated by the CAT task, they are read once
+  unsigned long pollTime = pollMicros - lastPollMicros;
+  lastFrames = displayFrames;
+  lastPolls += polls;
+  lastPollMicros += pollTime;
+  if (polls != 0) {
+    Serial.print("Polls ");
+    Serial.print(polls);
+    Serial.print(", mean poll time us ");
+    Serial.println(pollTime / polls);
+  }
+  if (frames == 0) {return;}
+  Serial.print("Mean frame time us, draw push : ");
+  Serial.print(drawMicros / frames);
+  Serial.print(" ");
+  Serial.println(pushMicros / frames);
+  drawMicros = pushMicros = 0;
+  static unsigned long lastMeterFrames = 0;
+  unsigned long meterFrames = widgetRedraws[WIDGET_METER] - lastMeterFrames;
+  lastMeterFrames = widgetRedraws[WIDGET_METER];
+  if (meterFrames == 0) {return;}
+  Serial.print("Meter frames ");
+  Serial.print(meterFrames);
+  Serial.print(", mean draw us ");
+  Serial.print(meterMicros / meterFrames);
+  Serial.print(", mean bytes to the screen ");
+  Serial.println(meterBytes / meterFrames);
+  meterMicros = meterBytes = 0;
 }
 
 void displayDSP() {
-radio.getAGC_DSP_Conf(AGC,DBF,DNR,DNF); // FT857D-ESP32 library function
-tft.setCursor(0,110);
-tft.setTextSize(2);
-if (DBF) {tft.print("DBF");DBFStatus = "DBF";} else
-                      {tft.fillRect(0, 110, 35, 15, TFT_BLUE); // x, y, width, height, color
-                       DBFStatus = "   ";}
-tft.setCursor(40,110);
-if (DNF) {tft.print("DNF");DNFStatus = "DNF";} else
-                      {tft.fillRect(40, 110, 35, 15, TFT_BLUE); // x, y, width, height, color
-                       DNFStatus = "   ";}
-tft.setCursor(80,110);
-if (DNR) {tft.print("DNR");DNRStatus = "DNR";} else
-                      {tft.fillRect(80, 110, 35, 15, TFT_BLUE); // x, y, width, height, color
-                      DNRStatus = "   ";}
+lcd->setTextSize(2);
+lcd->setCursor(0,110);
+if (drawState.dbf) {lcd->print("DBF");} else
+                      {lcd->fillRect(0, 110, 35, 15, TFT_BLUE);} // x, y, width, height, color
+lcd->setCursor(40,110);
+if (drawState.dnf) {lcd->print("DNF");} else
+                      {lcd->fillRect(40, 110, 35, 15, TFT_BLUE);} // x, y, width, height, color
+lcd->setCursor(80,110);
+if (drawState.dnr) {lcd->print("DNR");} else
+                      {lcd->fillRect(80, 110, 35, 15, TFT_BLUE);} // x, y, width, height, color
 }
 
 void displayCWConf() {
-radio.getCW_MTR_Conf(MeterConf,Keyer,Break_In); // FT857D-ESP32 library function
-tft.setTextSize(2);
-tft.setCursor(160,110); // (num colonne , num ligne)
-  if (Keyer) {
-     tft.print("KYR");
-     KYRStatus = "KYR";}
-     else {tft.fillRect(160, 110, 35, 15, TFT_BLUE); // x, y, width, height, color
-     KYRStatus = "   ";}
-  tft.setCursor(210,110); // (colonne , ligne)
-  if (Break_In) {
-    tft.print("BK");
-    BKStatus = "BK";}
-     else {tft.fillRect(210, 110, 25, 15, TFT_BLUE); // x, y, width, height, color
-     BKStatus = "  ";}
+lcd->setTextSize(2);
+if (!drawState.cw) {lcd->fillRect(160, 110, 75, 15, TFT_BLUE); return;}
+lcd->setCursor(160,110); // (num colonne , num ligne)
+  if (drawState.keyer) {lcd->print("KYR");}
+     else {lcd->fillRect(160, 110, 35, 15, TFT_BLUE);} // x, y, width, height, color
+  lcd->setCursor(210,110); // (colonne , ligne)
+  if (drawState.breakIn) {lcd->print("BK");}
+     else {lcd->fillRect(210, 110, 25, 15, TFT_BLUE);} // x, y, width, height, color
 }
 
   void displayVFO() { // F6CZV
-  VFO1 = radio.getVFO(); // FT857D-ESP32 library function
-  if (VFO1 != prevVFO) {
-  tft.setTextSize(3);
-  tft.fillRect(60, 35, 20, 25, TFT_BLUE); // x, y, width, height, color
-  tft.setCursor(60,35); // (num colonne , num ligne)
-  tft.print(VFO1);
-  prevVFO = VFO1;}
+  lcd->setTextSize(3);
+  lcd->fillRect(60, 35, 20, 25, TFT_BLUE); // x, y, width, height, color
+  lcd->setCursor(60,35); // (num colonne , num ligne)
+  lcd->print(drawState.vfo);
   }
 
   void displaySMeter() { // F6CZV
-  Smeter = radio.getSMeter(); // FT857D-ESP32 library function
-  if (Smeter != prevSmeter) {
-  tft.setTextSize(3);
-  tft.setCursor(0,0);
-  tft.fillRect(0, 0, 100, 25, TFT_BLUE); // x, y, width, height, color
-  prevSmeter = Smeter;
-  tft.print(Smeter);
+  lcd->setTextSize(3);
+  lcd->setCursor(0,0);
+  lcd->fillRect(0, 0, 100, 25, TFT_BLUE); // x, y, width, height, color
+  lcd->print(drawState.smeter);
   }
+
+  // Colour of the segment seg (1 to 15) of the bar for an S-meter level and a peak
+  uint16_t segmentColour(byte seg, byte level, byte peak) {
+  if (seg <= level) {return (seg < 10) ? TFT_GREEN : TFT_RED;}
+  if (seg == peak) {return TFT_YELLOW;}
+  return TFT_NAVY;
+  }
+
+  // Draws the scale of the needle : a tick every 2 S units (every 20 dB above S9)
+  void drawDial() {
+  if (!needleOK) {return;}
+  for (byte level = 1; level <= 15; level += 2) {
+    float a = (-60 + level * 8) * DEG_TO_RAD;
+    lcd->drawLine(NEEDLE_X + (NEEDLE_LEN + 2) * sin(a), NEEDLE_Y - (NEEDLE_LEN + 2) * cos(a),
+                  NEEDLE_X + (NEEDLE_LEN + 5) * sin(a), NEEDLE_Y - (NEEDLE_LEN + 5) * cos(a),
+                  (level < 10) ? TFT_WHITE : TFT_RED); // outside of the needle circle
+  }
+  }
+
+  // Draws the segments of the bar that changed and moves the needle
+  void displayMeter() {
+  byte level = drawState.smeterLevel;
+  for (byte seg = 1; seg <= 15; seg++) {
+    uint16_t colour = segmentColour(seg, level, meterPeak);
+    if (!meterDrawn || colour != segmentColour(seg, shownLevel, shownPeak)) {
+      lcd->fillRect((seg - 1) * 16, BAR_Y, 15, 8, colour); // x, y, width, height, color
+    }
+  }
+  shownLevel = level;
+  shownPeak = meterPeak;
+  meterDrawn = true;
+
+  if (!needleOK) {return;}
+  if (needleDrawn) { // erase the needle where it was then redraw the scale which may be in the same box
+    screen.fillRect(needleBox[0], needleBox[1], needleBox[2] - needleBox[0] + 1, needleBox[3] - needleBox[1] + 1, TFT_BLUE);
+    drawDial();
+  }
+  needleDrawn = needle.getRotatedBounds(&screen, needleAngle, &needleBox[0], &needleBox[1], &needleBox[2], &needleBox[3]);
+  needle.pushRotated(&screen, needleAngle);
   }
 
   void displayRXTX() { // F6CZV
-  tft.setTextSize(3);
-  On_Air = radio.chkTx(); // FT857D-ESP32 library function
-  if (On_Air) {
-    tft.setCursor(200,0);
-    tft.fillRect(195, 0, 45, 25, TFT_RED); // x, y, width, height, color
-    tft.print("Tx");
-    RTStatus = "Tx";}
+  lcd->setTextSize(3);
+  lcd->setCursor(200,0);
+  if (drawState.tx) {
+    lcd->fillRect(195, 0, 45, 25, TFT_RED); // x, y, width, height, color
+    lcd->setTextColor(TFT_WHITE, TFT_RED);
+    lcd->print("Tx");
+    lcd->setTextColor(TFT_WHITE, TFT_BLUE);}
   else
-  {tft.setCursor(200,0);
-  tft.fillRect(195, 0, 45, 25, TFT_BLUE); // x, y, width, height, color
-  tft.print("Rx");
-  RTStatus = "Rx";
+  {lcd->fillRect(195, 0, 45, 25, TFT_BLUE); // x, y, width, height, color
+  lcd->print("Rx");
   }
   }
 
   void displaySplit_status() { // F6CZV
-  Split = radio.getSPLIT_status(); // FT857D-ESP32 library function
-  tft.setTextSize(3);
-  tft.setCursor(130,0);
-  if (Split) {
-    tft.print("SPL");
-    SPLStatus = "SPL";}
+  lcd->setTextSize(3);
+  lcd->setCursor(130,0);
+  if (drawState.split) {lcd->print("SPL");}
   else
-   {tft.fillRect(130, 0, 55, 25, TFT_BLUE); // x, y, width, height, color
-   SPLStatus = "   ";}
+   {lcd->fillRect(130, 0, 55, 25, TFT_BLUE);} // x, y, width, height, color
+  }
+
+  // Pre-renders the characters of the frequency readout (text size 3, white on blue) in RAM, a changed digit
+  // is then a single image blit instead of a fillRect and a scaled character
+  void buildGlyphAtlas() {
+  TFT_eSprite glyph = TFT_eSprite(&tft);
+  if (glyph.createSprite(GLYPH_W, GLYPH_H) == NULL) {return;}
+  glyphAtlas = (uint16_t*) malloc(strlen(glyphChars) * GLYPH_W * GLYPH_H * 2);
+  if (glyphAtlas != NULL) {
+    for (byte c = 0; glyphChars[c]; c++) {
+      glyph.fillSprite(TFT_BLUE);
+      glyph.drawChar(0, 0, glyphChars[c], TFT_WHITE, TFT_BLUE, 3); // the 6th (blank) column of the character is clipped
+      uint16_t *img = glyphAtlas + c * GLYPH_W * GLYPH_H;
+      for (int y = 0; y < GLYPH_H; y++) {
+        for (int x = 0; x < GLYPH_W; x++) {*img++ = glyph.readPixel(x, y);}
+      }
+    }
+  }
+  glyph.deleteSprite();
+  }
+
+  // Draws one character cell of the frequency readout at x
+  void drawFreqCell(int x, char c) {
+  const char *g = (c != '\0') ? strchr(glyphChars, c) : NULL; // strchr() finds the terminator of glyphChars
+  if (c == '\0') {c = ' ';}
+  if (glyphAtlas != NULL && g != NULL) {
+    uint16_t *img = glyphAtlas + (g - glyphChars) * GLYPH_W * GLYPH_H;
+    if (lcd == &screen) {screen.pushImage(x, 75, GLYPH_W, GLYPH_H, img);} // pushImage() is not virtual
+    else {
+      tft.setSwapBytes(true); // the atlas holds the colours in the TFT_eSPI format
+      tft.pushImage(x, 75, GLYPH_W, GLYPH_H, img);
+      tft.setSwapBytes(false);
+    }
+    return;
+  }
+  lcd->fillRect(x, 75, GLYPH_W, GLYPH_H, TFT_BLUE); // x, y, width, height, color
+  lcd->setCursor(x, 75); // (num colonne , num ligne)
+  if (c != ' ') {lcd->print(c);}
   }
 
-  String displayFreq(unsigned long &freq_int) { // F6CZV
-  char frequency[9];
-  String Sfrequency;
-  byte shift = 0;
-  unsigned long tempfreq;
+  // Draws the cells of the frequency readout that differ from the displayed ones
+  void displayFreq() { // F6CZV
+  TRACE_SCOPE("displayFreq");
+  const int cellX[8] = {5, 22, 39, 70, 87, 104, 135, 152}; // digit cells, the point is at 54 and the comma at 120
+  char frequency[12];
+  char cells[9]; // 8 digits then the point
+  byte shift = freqDigits(drawState.freq, frequency);
   int n;
-  tempfreq = radio.getFreqMode(); // FT857D-ESP32 library function
-  freq_int = tempfreq;
-  sprintf(frequency, "%lu", tempfreq);
 
-  if (tempfreq < 10000000 & tempfreq >= 1000000) {
-   shift = 1;
-   }
-   if (tempfreq < 1000000 & tempfreq >= 100000) {
-   shift = 2;
-   }
-   if (tempfreq < 100000) {
-   shift = 3;
-   }
-  tft.setTextSize(3);
-  tft.setCursor(54,75); // (num colonne , num ligne)
-  if (shift != 3) {tft.print(".");}
-
-  for (n = 0; n < 3;n++) {
-    tft.setCursor(70+n*17,75); // (num colonne , num ligne)
-    tft.fillRect(70+n*17, 75, 17, 25, TFT_BLUE); // x, y, width, height, color
-    tft.print(frequency[3+n-shift]);
-    Sfrequency = Sfrequency + String(frequency[3+n-shift]);}
-
-  tft.setCursor(120,75); // (num colonne , num ligne)
-  tft.print(",");
-  Sfrequency = Sfrequency + ",";
-
-  for (n = 0; n < 2;n++) {
-    tft.setCursor(135+n*17,75); // (num colonne , num ligne)
-    tft.fillRect(135+n*17, 75, 17, 25, TFT_BLUE); // x, y, width, height, color
-    tft.print(frequency[6+n-shift]);
-    Sfrequency = Sfrequency + String(frequency[6+n-shift]);}
-
-  if (shift != 3) {Sfrequency = "." + Sfrequency;}
-
-  for (n = 2; n >= 0;n--) {
-    tft.setCursor(5+n*17,75); // (num colonne , num ligne)
-    tft.fillRect(5+n*17, 75, 17, 25, TFT_BLUE); // x, y, width, height, color
-    if ((n-shift)>= 0) {tft.print(frequency[n-shift]);
-                        Sfrequency = String(frequency[n-shift]) + Sfrequency;}
-  }
-  tft.setCursor(177,75); // (num colonne , num ligne)
-  tft.print("kHz");
-  Sfrequency = Sfrequency + " ";
-  shift = 0 ;
-  Wfrequency = Sfrequency;
-  return Wfrequency;
+  for (n = 0; n < 8; n++) {cells[n] = frequency[n];}
+  cells[8] = (shift != 3) ? '.' : ' ';
+
+  if (cells[8] != shownFreq[8]) {
+    drawFreqCell(54, cells[8]);
+    shownFreq[8] = cells[8];
+    shownFreq[3] = 0; // the point cell overlaps the first column of the next digit
+  }
+  for (n = 0; n < 8; n++) {
+    if (cells[n] != shownFreq[n]) {
+      drawFreqCell(cellX[n], cells[n]);
+      shownFreq[n] = cells[n];
+    }
+  }
   }
 
   void displayMode() {
-  radmode = radio.getMode(); // FT857D-ESP32 library function
-  if (radmode != prevmode) {
-  tft.setTextSize(3);
-  tft.setCursor(100,35); // (num colonne , num ligne)
-  tft.fillRect(100, 35, 51, 25, TFT_BLUE); // x, y, width, height, color
-  tft.print(radmode);
-  prevmode = radmode;}
+  lcd->setTextSize(3);
+  lcd->setCursor(100,35); // (num colonne , num ligne)
+  lcd->fillRect(100, 35, 51, 25, TFT_BLUE); // x, y, width, height, color
+  lcd->print(drawState.mode);
   }
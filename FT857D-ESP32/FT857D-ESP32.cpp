@@ -17,6 +17,10 @@ Version 1.1 :
   - char getVFO() is now String get VFO(),
   - setMode(String mode), squelch(String mode), rptrOffset(String ofst) and squelchFreq(unsigned int freq, String sqlType) parameters are now a String (were char*)
 
+Version 2.1 :
+  - adaptive reply timeouts, resynchronization of the input after a failed reply, replyOK() and link()
+  - detectBaud()
+
 LIMITATION OF LIABILITY :
  This source code is provided "as-is". It may contain bugs. 
 Any damages resulting from its use is done under the sole responsibility of the user/developper
@@ -30,11 +34,21 @@ Any damages resulting from its use is done under the sole responsibility of the
 #include "FT857D-ESP32.h"
 
 // define hardware serial port here:
-extern HardwareSerial rigCat(2); //  UART 3 of ESP32. 
+HardwareSerial rigCat(2); //  UART 3 of ESP32. 
 
 #define dlyTime 5	// delay (in ms) after serial writes
 
-FT857D::FT857D(){ }	// nothing to do when first instanced
+FT857D::FT857D(){
+	memset(rtt, 0, sizeof(rtt));
+	memset(&linkState, 0, sizeof(linkState));
+	linkState.up = true;
+	freq = 0;
+	lastCmd = 0;
+	sentTime = 0;
+	lastReplyOK = true;
+	probing = false;
+	baudRate = 0;
+}
 
 //********************************************************************
 
@@ -50,6 +64,82 @@ function put in comments by F6CZV - a priori not used */
 // similar to Serial.begin(baud)
   void FT857D::begin(int baud) {
   rigCat.begin(baud, SERIAL_8N2, 26, 27); // speed - 8 bits - No parity - 2 stop bits - pin Rx - pin Tx  
+  baudRate = baud;
+}
+
+long FT857D::baud() {
+	return baudRate;
+}
+
+//********************************************************************
+
+// rates of the CAT RATE menu of the FT857D, fastest first
+const long FT857D::catRates[] = {38400, 9600, 4800, 0};
+
+// tries the rates of the radio menu from the fastest, keeps the first one at
+// which the radio answers with plausible replies and returns it. Each rate is
+// tried CAT_PROBE_TRIES times, the framing of the radio realigned before each
+// try. If there is none the fastest rate is set and 0 is returned.
+long FT857D::detectBaud() {
+	probing = true;
+	for (byte i = 0; catRates[i] != 0; i++) {
+		begin(catRates[i]);
+		for (byte t = 0; t < CAT_PROBE_TRIES; t++) {
+			realign();
+			if (probe()) {
+				probing = false;
+				return catRates[i];
+			}
+		}
+	}
+	probing = false;
+	begin(catRates[0]);
+	return 0;
+}
+
+// the bytes sent at another rate may have left the radio with the beginning
+// of a command : after a quiet line, single CAT_RX_DATA_CMD bytes are sent
+// until the radio answers (at most 5). Whatever bytes the radio holds, the
+// command it completes reads the RX status, the next byte starts a command.
+// Not 0x00, which would lock the radio. True if the radio answered.
+bool FT857D::realign() {
+	resync(CAT_PROBE_TIMEOUT * 1000UL); // the end of a reply to the previous try
+	byte pad = CAT_RX_DATA_CMD;
+	for (byte i = 0; i < 5; i++) {
+		sendCmd(&pad, 1);
+		while (micros() - sentTime < CAT_PROBE_TIMEOUT * 1000UL) {
+			if (rigCat.available() > 0) {
+				resync(CAT_PROBE_TIMEOUT * 1000UL); // the reply, garbled at a wrong rate
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// reads the frequency and mode and the RX status, true if the replies arrived
+// and are plausible
+bool FT857D::probe() {
+	byte cmd[5] = {0x00,0x00,0x00,0x00,CAT_RX_FREQ_CMD};
+	byte reply[5];
+
+	sendCmd(cmd, 5);
+	if (!getReply(reply, 5)) return false;
+	for (byte i = 0; i < 4; i++) {
+		if ((reply[i] >> 4) > 9 || (reply[i] & 0x0f) > 9) return false; // not BCD
+	}
+	unsigned long f = from_bcd_be(reply, 8);
+	if (f < CAT_FREQ_MIN || f > CAT_FREQ_MAX) return false;
+	switch (reply[4]) {
+		case CAT_MODE_LSB: case CAT_MODE_USB: case CAT_MODE_CW: case CAT_MODE_CWR:
+		case CAT_MODE_AM: case CAT_MODE_FM: case CAT_MODE_WFM: case CAT_MODE_DIG:
+		case CAT_MODE_PKT: case CAT_MODE_FMN: case 0xFC: break;
+		default: return false;
+	}
+
+	cmd[4] = CAT_RX_DATA_CMD;
+	sendCmd(cmd, 5);
+	return getReply(reply, 1);
 }
 
 //********************************************************************
@@ -204,7 +294,7 @@ void FT857D::squelchFreq(unsigned int freq, String sqlType) {
 	to_bcd_be(freq_bcd, (long)  freq, 4);
 
 	for (byte i=0; i<4; i++){
-		rigSqlFreq[i] = freq_bcd[i];
+		rigSqlFreq[i] = freq_bcd[i % 2]; // the same tone / code for TX and RX
 	}
 	sendCmd(rigSqlFreq,5);
 	getByte();
@@ -224,28 +314,20 @@ void FT857D::squelchFreq(unsigned int freq, String sqlType) {
 // if called as getFreqMode() return only the frequency
 
 unsigned long FT857D::getFreqMode() {
+	FT857D_TRACE("FT857D::getFreqMode");
 	byte rigGetFreq[5] = {0x00,0x00,0x00,0x00,0x00};
 	rigGetFreq[4] = CAT_RX_FREQ_CMD; // command byte
-	byte chars[4];
-	long timeout = millis();
-	long elapsed = 0;
-
-//	rigCat.flush();	// clear the RX buffer which helps prevent
-				// any crap data from making it through
+	byte chars[5];
 
 	sendCmd(rigGetFreq, 5);
-	
-	while (rigCat.available() < 5 && elapsed < 2000) {
-		elapsed = millis() - timeout;
-     	;}
-	
-	for (int j = 0; j < 4; j++) {
-		chars[j] = rigCat.read();  
-   	}
+
+	if (!getReply(chars, 5)) {
+		return freq; // the last frequency and mode received are kept
+	}
       /*  in V0.1 mode was a byte. The returned mode is now a user-friendly string directly displayable - F6CZV */
 
         byte modeint;
-        modeint = rigCat.read(); // F6CZV
+        modeint = chars[4]; // F6CZV
        
       switch (modeint)
        {
@@ -310,6 +392,7 @@ unsigned long FT857D::getFreqMode() {
 // 0x255 so any value other than 0x255 means TX !
 
 bool FT857D::chkTx() {                         // was boolean F6CZV
+	FT857D_TRACE("FT857D::chkTx");
 	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
 	rigTXState[4] = CAT_TX_DATA_CMD;
 	
@@ -331,16 +414,11 @@ bool FT857D::chkTx() {                         // was boolean F6CZV
 // 
 
 String FT857D::getSMeter() {   
-	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
-	rigTXState[4] = CAT_RX_DATA_CMD;
+	FT857D_TRACE("FT857D::getSMeter");
 	String SMeterl;
 	byte reply;
 	
-	sendCmd(rigTXState, 5);	
-	
-	reply = getByte();
-	
-	reply = reply & 0x0f;
+	reply = getSMeterLevel();
 
 	if (reply < 10) {SMeterl = "S" + String(reply);
 	}
@@ -381,6 +459,21 @@ String FT857D::getSMeter() {
 	return SMeterl;
 }
 
+//********************************************************************
+
+// get the S Meter value from the radio as a number (0 to 15) for bar graphs
+// 
+
+byte FT857D::getSMeterLevel() {   
+	FT857D_TRACE("FT857D::getSMeterLevel");
+	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
+	rigTXState[4] = CAT_RX_DATA_CMD;
+	
+	sendCmd(rigTXState, 5);	
+	
+	return getByte() & 0x0f;
+}
+
 
 //********************************************************************
 
@@ -388,6 +481,7 @@ String FT857D::getSMeter() {
 // 
 
  String FT857D::getVFO() {   
+	FT857D_TRACE("FT857D::getVFO");
 	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
 	rigTXState[4] = CAT_EEPROM_READ_CMD;
 	rigTXState[0] = MSB_ADD_VFO_status;
@@ -397,13 +491,13 @@ String FT857D::getSMeter() {
 	
 	sendCmd(rigTXState, 5);
 
-	byte reply = getByte();
+	byte reply[2]; // D2 is discarded
+	getReply(reply, 2);
 	
-	if (reply == 0x80) {VFO = 'a';}
+	if (reply[0] == 0x80) {VFO = 'a';}
 
 	else {VFO = 'b';}
 
-        reply = getByte(); // byte discarded
 	return VFO;
 }
 
@@ -413,6 +507,7 @@ String FT857D::getSMeter() {
 // 
 
    void FT857D::getCW_MTR_Conf(byte &MTR,bool &KYR,bool &BK) {   
+	FT857D_TRACE("FT857D::getCW_MTR_Conf");
 	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
 	rigTXState[4] = CAT_EEPROM_READ_CMD;
 	rigTXState[0] = MSB_ADD_CW_MTR_CONF;
@@ -420,12 +515,11 @@ String FT857D::getSMeter() {
 	
 	sendCmd(rigTXState, 5);
 
-	byte reply = getByte();
-	MTR = reply & 0x03;
-	KYR = reply & 0x10;
-	BK = reply & 0x20;
-
-        reply = getByte(); // byte discarded
+	byte reply[2]; // D2 is discarded
+	getReply(reply, 2);
+	MTR = reply[0] & 0x03;
+	KYR = reply[0] & 0x10;
+	BK = reply[0] & 0x20;
 
 }
 
@@ -435,6 +529,7 @@ String FT857D::getSMeter() {
 // 
 
    void FT857D::getAGC_DSP_Conf(bool &AGC,bool &DBF,bool &DNR, bool &DNF) {   
+	FT857D_TRACE("FT857D::getAGC_DSP_Conf");
 	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
 	rigTXState[4] = CAT_EEPROM_READ_CMD;
 	rigTXState[0] = MSB_ADD_AGC_DSP_CONF;
@@ -442,13 +537,12 @@ String FT857D::getSMeter() {
 	
 	sendCmd(rigTXState, 5);
 
-	byte reply = getByte();
-	AGC = reply & 0x20;
-	DBF = reply & 0x04; // only one bit is tested
-	DNR = reply & 0x02;
-	DNF = reply & 0x01;
-
-        reply = getByte(); // byte discarded
+	byte reply[2]; // D2 is discarded
+	getReply(reply, 2);
+	AGC = reply[0] & 0x20;
+	DBF = reply[0] & 0x04; // only one bit is tested
+	DNR = reply[0] & 0x02;
+	DNF = reply[0] & 0x01;
 
 }
 
@@ -458,6 +552,7 @@ String FT857D::getSMeter() {
 // 
 
    bool FT857D::getSPLIT_status() {   
+	FT857D_TRACE("FT857D::getSPLIT_status");
 	byte rigTXState[5] = {0x00,0x00,0x00,0x00,0x00};
 	bool Status = false;
 	rigTXState[4] = CAT_EEPROM_READ_CMD;
@@ -466,10 +561,10 @@ String FT857D::getSMeter() {
 	
 	sendCmd(rigTXState, 5);
 
-	byte reply = getByte();
-	Status = reply & 0x80;
+	byte reply[2]; // D2 is discarded
+	getReply(reply, 2);
+	Status = reply[0] & 0x80;
 	
-        reply = getByte(); // byte discarded
 	return Status;
 
 }
@@ -484,24 +579,143 @@ void FT857D::comError(char * string) {
 
 //********************************************************************
 
-// gets a byte of input data from the radio
+// gets a byte of input data from the radio, 0xFF if it did not arrive in time
 byte FT857D::getByte() {
-	unsigned long startTime = millis();
-	while (rigCat.available() < 1 && millis() < startTime + 2000) {
-		;
-	}
-	byte radioReply = rigCat.read();
+	byte radioReply;
+	getReply(&radioReply, 1);
 	return radioReply ;
 }
 
 //********************************************************************
 
+// gets the len bytes of the reply to the last command. If they did not all
+// arrive before the timeout of the command the missing bytes are 0xFF, the
+// input is resynchronized and false is returned
+bool FT857D::getReply(byte reply[], byte len) {
+	RttHistogram &h = rttHistogram(lastCmd);
+	unsigned long timeout = (probing ? CAT_PROBE_TIMEOUT : replyTimeout(lastCmd)) * 1000;
+	byte n = 0;
+	while (n < len) {
+		if (rigCat.available() > 0) {reply[n++] = rigCat.read();}
+		else if (micros() - sentTime >= timeout) {break;}
+	}
+
+	if (n == len) {
+		unsigned long us = micros() - sentTime;
+		unsigned long ms = us / 1000;
+		if (!probing) {h.count[ms < CAT_RTT_BUCKETS ? ms : CAT_RTT_BUCKETS - 1]++;}
+		if (!probing && ++h.replies >= CAT_RTT_AGE) { // older replies weigh less
+			h.replies = 0;
+			for (byte b = 0; b < CAT_RTT_BUCKETS; b++) {
+				h.count[b] /= 2;
+				h.replies += h.count[b];
+			}
+		}
+		h.backoff = 0;
+		byte b = 0;
+		while (b < CAT_LATENCY_BUCKETS - 1 && ms >= catLatencyBounds[b]) {b++;}
+		linkState.rttBuckets[b]++;
+		linkState.rttMicros += us;
+		linkState.lastRtt = us;
+		linkState.failures = 0;
+		linkState.up = true;
+		lastReplyOK = true;
+		return true;
+	}
+
+	for (byte i = n; i < len; i++) {reply[i] = 0xFF;}
+	if (n == 0) {linkState.timeouts++;}
+	else {linkState.shortReplies++;}
+	if (!probing && h.backoff < CAT_BACKOFF_MAX) {h.backoff++;}
+	if (++linkState.failures >= CAT_LINK_DOWN) {linkState.up = false;}
+	lastReplyOK = false;
+	resync(timeout);
+	return false;
+}
+
+//********************************************************************
+
+// discards the input until the line was quiet for quiet us (at most
+// CAT_RESYNC_MAX ms), so that the end of a late reply is not taken as the
+// beginning of the reply to the next command
+void FT857D::resync(unsigned long quiet) {
+	if (quiet > CAT_RESYNC_MAX * 1000UL) {quiet = CAT_RESYNC_MAX * 1000UL;}
+	unsigned long start = micros();
+	unsigned long last = start;
+	while (micros() - last < quiet && micros() - start < 2 * CAT_RESYNC_MAX * 1000UL) {
+		if (rigCat.available() > 0) {
+			rigCat.read();
+			linkState.staleBytes++;
+			last = micros();
+		}
+	}
+	linkState.resyncs++;
+}
+
+//********************************************************************
+
+// histogram of the round trip times of a command code
+FT857D::RttHistogram &FT857D::rttHistogram(byte cmd) {
+	for (byte i = 0; i < CAT_RTT_CODES - 1; i++) {
+		if (!rtt[i].used) {
+			rtt[i].used = true;
+			rtt[i].cmd = cmd;
+		}
+		if (rtt[i].cmd == cmd) {return rtt[i];}
+	}
+	return rtt[CAT_RTT_CODES - 1]; // shared by the other codes
+}
+
+//********************************************************************
+
+// percentile of the round trip time of a command code, in ms (upper bound
+// of its bucket), CAT_TIMEOUT_MAX if too few replies were received
+unsigned long FT857D::rttPercentile(byte cmd, byte percent) {
+	RttHistogram &h = rttHistogram(cmd);
+	if (h.replies < CAT_RTT_LEARN) {return CAT_TIMEOUT_MAX;}
+	unsigned long sum = 0;
+	for (byte b = 0; b < CAT_RTT_BUCKETS - 1; b++) {
+		sum += h.count[b];
+		if (sum * 100 >= (unsigned long) h.replies * percent) {return b + 1;}
+	}
+	return CAT_TIMEOUT_MAX;
+}
+
+//********************************************************************
+
+// current reply timeout of a command code in ms
+unsigned long FT857D::replyTimeout(byte cmd) {
+	unsigned long timeout = rttPercentile(cmd, 99) * CAT_TIMEOUT_FACTOR;
+	if (timeout < CAT_TIMEOUT_MIN) {timeout = CAT_TIMEOUT_MIN;}
+	timeout <<= rttHistogram(cmd).backoff;
+	return timeout < CAT_TIMEOUT_MAX ? timeout : CAT_TIMEOUT_MAX;
+}
+
+//********************************************************************
+
+bool FT857D::replyOK() {
+	return lastReplyOK;
+}
+
+const FT857D_Link &FT857D::link() {
+	return linkState;
+}
+
+//********************************************************************
+
 // this is the function which actually does the 
 // serial transaction to the radio
 void FT857D::sendCmd(byte cmd[], byte len) {
+	while (rigCat.available() > 0) { // the end of a reply which came too late
+		rigCat.read();
+		linkState.staleBytes++;
+	}
 	for (byte i=0; i<len; i++) {
 		rigCat.write(cmd[i]);
 	}
+	lastCmd = cmd[len - 1];
+	sentTime = micros();
+	linkState.commands++;
 //	return getByte();	// should make this work more quickly
 					// in a future update
 }
@@ -22,6 +22,11 @@ version 1.1
 - char getVFO(), char* getmode() are now String getVFO() and String getMode()
 -  setMode(String mode), squelch(String mode), rptrOffset(String ofst) and squelchFreq(unsigned int freq, String sqlType) parameters are now a String (were char*)
 
+version 2.1
+- the reply timeout of each command adapts to the measured round trip times, the input is resynchronized after
+  a missing or short reply, replyOK() and link() tell whether the replies are received
+- detectBaud() finds the CAT rate set in the radio menu, realigning the framing of the commands before each try
+
 
 CAT commands for FT-857D radio taken from the FT-857D Manual (page 66):
 	
@@ -340,6 +345,17 @@ All CAT commands to the radio should be sent as 5-byte blocks. The commands are
 #include <Arduino.h>  // ESP32 library
 #include <HardwareSerial.h> // ESP32 SoftwareSerial was replaced by HardwareSerial
 
+// The getters are timed when the CycleTrace library is used
+#if defined(__has_include)
+#if __has_include(<CycleTrace.h>)
+#include <CycleTrace.h>
+#define FT857D_TRACE(name) TraceScope traceScope(name)
+#endif
+#endif
+#ifndef FT857D_TRACE
+#define FT857D_TRACE(name)
+#endif
+
 // New constants added by F6CZV
 
 #define LSB_ADD_VFO_status		0x68
@@ -397,12 +413,62 @@ All CAT commands to the radio should be sent as 5-byte blocks. The commands are
 #define CAT_RX_FREQ_CMD			0x03
 #define CAT_NULL_DATA			0x00
 
+// Reply timeouts : the round trip time (RTT, from the command sent to the last byte of its reply) of each command
+// code is counted in a histogram of 1 ms buckets. Once CAT_RTT_LEARN replies were received the timeout of the
+// command is CAT_TIMEOUT_FACTOR times the 99th percentile of its RTT, at least CAT_TIMEOUT_MIN ms, doubled after
+// each consecutive timeout up to CAT_BACKOFF_MAX times. Before, it is CAT_TIMEOUT_MAX ms.
+// After a missing or short reply the input is discarded until the line is quiet, so that the end of a late reply
+// is not taken as the beginning of the next one.
+
+#define CAT_TIMEOUT_MAX			2000	// ms
+#define CAT_TIMEOUT_MIN			20	// ms
+#define CAT_TIMEOUT_FACTOR		2
+#define CAT_BACKOFF_MAX			3
+#define CAT_RTT_BUCKETS			32	// the last bucket counts the replies of 31 ms or more
+#define CAT_RTT_LEARN			16
+#define CAT_RTT_AGE			1024	// the histogram of a command is halved when it reaches this count
+#define CAT_RTT_CODES			12	// command codes with their own histogram, the last one is shared
+#define CAT_LINK_DOWN			3	// consecutive failed replies after which the link is down
+#define CAT_RESYNC_MAX			100	// ms of quiet line waited at most after a failed reply
+
+// CAT rate detection : the rates of the radio menu (019 CAT RATE) are tried from the fastest. Before each try the
+// 5 byte framing of the radio is realigned with single RX status commands, then the frequency / mode and the RX
+// status are read with a short timeout. The rate is kept if the replies arrive and are plausible : valid BCD
+// digits, a frequency in the range of the radio and a known mode. Each rate is tried CAT_PROBE_TRIES times.
+
+#define CAT_PROBE_TIMEOUT		100	// ms
+#define CAT_PROBE_TRIES			2
+#define CAT_FREQ_MIN			10000	// 100 kHz in 10 Hz
+#define CAT_FREQ_MAX			47000000 // 470 MHz
+
+// Reply times of all the commands, counted by bucket for the statistics : upper bounds in ms of the first
+// buckets, the last bucket counts the slower replies
+#define CAT_LATENCY_BUCKETS		8
+const uint16_t catLatencyBounds[CAT_LATENCY_BUCKETS - 1] = {2, 5, 10, 20, 50, 100, 500};
+
+// Health of the CAT link, counters since the start
+struct FT857D_Link {
+	unsigned long commands;		// commands sent
+	unsigned long timeouts;		// no reply at all before the timeout
+	unsigned long shortReplies;	// some bytes of the reply missing at the timeout
+	unsigned long resyncs;		// input discarded after a failed reply
+	unsigned long staleBytes;	// bytes received out of any reply (late replies), discarded
+	unsigned long lastRtt;		// us, of the last complete reply
+	unsigned long rttBuckets[CAT_LATENCY_BUCKETS]; // complete replies by reply time
+	uint64_t rttMicros;		// total reply time of the complete replies
+	unsigned int failures;		// consecutive failed replies
+	bool up;			// less than CAT_LINK_DOWN consecutive failed replies
+};
+
 class FT857D
 {
   public:
 	FT857D();
 //	void setSerial(SoftwareSerial portInfo); // a priori not used - F6CZV
 	void begin(int baud);
+	long detectBaud();			// sets and returns the rate the radio answers at, 0 if none (then the fastest is set)
+	long baud();				// current rate
+	static const long catRates[];		// rates of the radio menu, fastest first, 0 terminated
 
 	void lock(boolean toggle);
 	void PTT(boolean toggle);
@@ -421,10 +487,19 @@ class FT857D
 	unsigned long getFreqMode();
 	bool chkTx(); // was boolean F6CZV
         String getSMeter(); // new function F6CZV
+	byte getSMeterLevel(); // S-meter as a number, 0 to 9 = S0 to S9, 10 to 15 = S9+10 to S9+60
 	void getCW_MTR_Conf(byte &MTR,bool &KYR,bool &BK); // new function F6CZV
 	void getAGC_DSP_Conf(bool &AGC,bool &DBF,bool &DNR, bool &DNF); // new function F6CZV
 	bool getSPLIT_status(); // new function F6CZV
 	void flushRX();
+	bool replyOK();				// the reply of the last command was received complete and in time
+	const FT857D_Link &link();		// health of the CAT link
+	unsigned long replyTimeout(byte cmd);	// ms, current reply timeout of a command code
+	unsigned long rttPercentile(byte cmd, byte percent); // ms, upper bound, CAT_TIMEOUT_MAX if not known
+
+	// BCD of the CAT frames, most significant digit first, bcd_len digits
+	static unsigned long from_bcd_be(const byte bcd_data[], unsigned bcd_len);
+	static unsigned char * to_bcd_be( byte bcd_data[], unsigned long freq, unsigned bcd_len);
 	
 
   private:
@@ -436,10 +511,28 @@ class FT857D
 	void sendCmd(byte cmd[], byte len);
 	byte singleCmd(int cmd);		// simplifies small cmds
 	byte getByte();
+	bool getReply(byte reply[], byte len);
+
+	struct RttHistogram {
+		byte cmd;
+		bool used;
+		uint16_t replies;
+		byte backoff;			// consecutive timeouts, up to CAT_BACKOFF_MAX
+		uint16_t count[CAT_RTT_BUCKETS];
+	};
+	RttHistogram rtt[CAT_RTT_CODES];
+	FT857D_Link linkState;
+	byte lastCmd;				// code of the last command sent
+	unsigned long sentTime;			// micros() when it was sent
+	bool lastReplyOK;
+	bool probing;				// short timeout, round trip times not counted
+	long baudRate;
+	bool probe();
+	bool realign();
+	RttHistogram &rttHistogram(byte cmd);
+	void resync(unsigned long quiet);
 
 	void sendByte(byte cmd);
-	unsigned long from_bcd_be(const byte bcd_data[], unsigned bcd_len);
-	unsigned char * to_bcd_be( byte bcd_data[], unsigned long freq, unsigned bcd_len);
 	void comError(char * string);
 };
 
@@ -0,0 +1,37 @@
+/*
+  FreqFormat.h		Frequency of the radio (in 10 Hz) as drawn on the TTGO screen and
+			written on the web page. Also built on a PC by the host benchmark
+			(test/bench_cat.cpp).
+*/
+#ifndef FREQFORMAT_H_
+#define FREQFORMAT_H_
+
+#include <Arduino.h>
+
+// Writes the frequency (in 10 Hz) in digits as 8 characters at fixed positions, the missing MHz digits as
+// spaces and the kHz digits always written (a frequency above 999.999,99 MHz is clamped), and returns the
+// number of missing MHz digits (0 to 3)
+inline byte freqDigits(unsigned long freq, char *digits) { // F6CZV
+  if (freq > 99999999UL) {freq = 99999999UL;}
+  sprintf(digits, "%8lu", freq);
+  byte shift = 0;
+  while (shift < 3 && digits[shift] == ' ') {shift++;}
+  for (byte n = 3; n < 8; n++) {if (digits[n] == ' ') {digits[n] = '0';}}
+  return shift;
+}
+
+// Frequency as displayed on the web page e.g. "14.074,00 "
+inline String formatFreq(unsigned long freq) { // F6CZV
+  char frequency[12];
+  String Sfrequency;
+  byte shift = freqDigits(freq, frequency);
+  int n;
+  for (n = shift; n < 3; n++) {Sfrequency = Sfrequency + String(frequency[n]);}
+  if (shift != 3) {Sfrequency = Sfrequency + ".";}
+  for (n = 3; n < 6; n++) {Sfrequency = Sfrequency + String(frequency[n]);}
+  Sfrequency = Sfrequency + ",";
+  for (n = 6; n < 8; n++) {Sfrequency = Sfrequency + String(frequency[n]);}
+  return Sfrequency + " ";
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+  HeapTelemetry.cpp	Heap usage over time and allocations counted by subsystem.
+*/
+
+#include "HeapTelemetry.h"
+#include <stdlib.h>
+#include <new>
+
+#if defined (ESP32)
+  #include <Arduino.h>
+  #include "esp_heap_caps.h"
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#endif
+
+const char *heapTagNames[HEAP_TAGS] = {"other", "cat", "web_request", "web_response", "websocket", "display"};
+
+HeapTelemetry heapTelemetry;
+
+// The counters are not initialized by the constructor : operator new may count allocations of the static
+// constructors which run before it, they start at zero as all the global variables.
+HeapTelemetry::HeapTelemetry() : _count(0), _lastSample(0) {}
+
+void HeapTelemetry::poll(uint32_t now) {
+	if (samples() != 0 && now - _lastSample < HEAP_SAMPLE_PERIOD) {return;}
+	sample(now);
+}
+
+void HeapTelemetry::sample(uint32_t now) {
+	HeapSample s;
+	s.number = samples();
+	s.time = now;
+#if defined (ESP32)
+	const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+	s.freeHeap = heap_caps_get_free_size(caps);
+	s.largestBlock = heap_caps_get_largest_free_block(caps);
+	s.minFreeHeap = heap_caps_get_minimum_free_size(caps);
+	s.psramFree = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+	s.psramSize = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+#else
+	s.freeHeap = s.largestBlock = s.minFreeHeap = s.psramFree = s.psramSize = 0;
+#endif
+	_ring[s.number % HEAP_SAMPLES].write(s);
+	_count.store(s.number + 1, std::memory_order_release);
+	_lastSample = now;
+}
+
+bool HeapTelemetry::getSample(uint32_t n, HeapSample &s) const {
+	_ring[n % HEAP_SAMPLES].read(s);
+	return s.number == n && n < samples(); // else the slot holds an older or a newer sample
+}
+
+void HeapTelemetry::tagStats(uint8_t tag, HeapTagStats &stats) const {
+	const Counters &c = _tags[tag];
+	stats.allocs = c.allocs.load(std::memory_order_relaxed);
+	stats.frees = c.frees.load(std::memory_order_relaxed);
+	stats.allocBytes = c.allocBytes.load(std::memory_order_relaxed);
+	stats.liveBytes = c.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = c.peakBytes.load(std::memory_order_relaxed);
+}
+
+void HeapTelemetry::countAlloc(uint8_t tag, uint32_t size) {
+	Counters &c = _tags[tag];
+	c.allocs.fetch_add(1, std::memory_order_relaxed);
+	c.allocBytes.fetch_add(size, std::memory_order_relaxed);
+	uint32_t live = c.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+	uint32_t peak = c.peakBytes.load(std::memory_order_relaxed);
+	while (live > peak && !c.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+}
+
+void HeapTelemetry::countFree(uint8_t tag, uint32_t size) {
+	Counters &c = _tags[tag];
+	c.frees.fetch_add(1, std::memory_order_relaxed);
+	c.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// Subsystem of each task. A task takes a free entry the first time it sets its subsystem, the entries are never
+// given back : only tasks which run for ever should set their subsystem.
+#if defined (ESP32)
+static std::atomic<TaskHandle_t> tagTasks[HEAP_TASKS];
+static uint8_t taskTags[HEAP_TASKS];
+
+static TaskHandle_t currentTask() {
+	if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {return NULL;} // static constructors
+	return xTaskGetCurrentTaskHandle();
+}
+
+static int taskEntry(TaskHandle_t task, bool add) {
+	for (int i = 0; i < HEAP_TASKS; i++) {
+		TaskHandle_t t = tagTasks[i].load(std::memory_order_acquire);
+		if (t == task) {return i;}
+		if (t == NULL) {
+			if (!add) {return -1;}
+			if (tagTasks[i].compare_exchange_strong(t, task)) {return i;}
+			if (t == task) {return i;}
+		}
+	}
+	return -1;
+}
+
+uint8_t heapTag(uint8_t tag) {
+	TaskHandle_t task = currentTask();
+	int i = task ? taskEntry(task, true) : -1;
+	if (i < 0) {return HEAP_OTHER;}
+	uint8_t previous = taskTags[i];
+	taskTags[i] = tag;
+	return previous;
+}
+
+static uint8_t currentTag() {
+	TaskHandle_t task = currentTask();
+	int i = task ? taskEntry(task, false) : -1;
+	return i < 0 ? HEAP_OTHER : taskTags[i];
+}
+#else
+static thread_local uint8_t threadTag = HEAP_OTHER;
+
+uint8_t heapTag(uint8_t tag) {
+	uint8_t previous = threadTag;
+	threadTag = tag;
+	return previous;
+}
+
+static uint8_t currentTag() {
+	return threadTag;
+}
+#endif
+
+// Global operator new and delete : a header before each block holds its size and subsystem. 8 bytes keep the
+// alignment of malloc().
+struct HeapHeader {
+	uint32_t size;
+	uint8_t tag;
+	uint8_t unused[3];
+};
+static_assert(sizeof(HeapHeader) == 8, "the header must keep the alignment of malloc()");
+
+static void *countedAlloc(size_t size) {
+	HeapHeader *h = (HeapHeader *) malloc(sizeof(HeapHeader) + size);
+	if (h == NULL) {return NULL;}
+	h->size = size;
+	h->tag = currentTag();
+	heapTelemetry.countAlloc(h->tag, size);
+	return h + 1;
+}
+
+static void countedFree(void *p) {
+	if (p == NULL) {return;}
+	HeapHeader *h = (HeapHeader *) p - 1;
+	heapTelemetry.countFree(h->tag, h->size);
+	free(h);
+}
+
+static void *countedNew(size_t size) {
+	void *p = countedAlloc(size);
+#if defined (__cpp_exceptions) || defined (__EXCEPTIONS)
+	if (p == NULL) {throw std::bad_alloc();}
+#else
+	if (p == NULL) {abort();}
+#endif
+	return p;
+}
+
+void *operator new(size_t size) {return countedNew(size);}
+void *operator new[](size_t size) {return countedNew(size);}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {return countedAlloc(size);}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {return countedAlloc(size);}
+void operator delete(void *p) noexcept {countedFree(p);}
+void operator delete[](void *p) noexcept {countedFree(p);}
+void operator delete(void *p, const std::nothrow_t &) noexcept {countedFree(p);}
+void operator delete[](void *p, const std::nothrow_t &) noexcept {countedFree(p);}
+void operator delete(void *p, size_t) noexcept {countedFree(p);}
+void operator delete[](void *p, size_t) noexcept {countedFree(p);}
@@ -0,0 +1,100 @@
+/*
+  HeapTelemetry.h	Heap usage over time and allocations counted by subsystem.
+
+  Free heap, largest free block, lowest free heap since the start and PSRAM
+  usage are sampled in a fixed ring of HEAP_SAMPLES samples : the history of
+  the last hours is kept in RAM without allocating anything. A largest block
+  much smaller than the free heap shows fragmentation.
+
+  The library replaces the global operator new and delete. Each block gets a
+  header of 8 bytes holding its size and the subsystem of the task which
+  allocated it, so that the counters of a subsystem stay right when the block
+  is freed by another task. The subsystem of a task is set by heapTag() for
+  the whole task or by a HeapScope for the duration of a block of code.
+  malloc() (the Arduino String, C code) is not counted by subsystem, it is seen
+  in the free heap samples only.
+
+  The samples and the counters can be read at any time from any task.
+*/
+#ifndef HEAPTELEMETRY_H_
+#define HEAPTELEMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <SeqLock.h>
+
+#define HEAP_SAMPLES 120            // ring of samples
+#define HEAP_SAMPLE_PERIOD 60000    // ms between two samples (2 hours of history)
+#define HEAP_TASKS 12               // tasks with their own subsystem
+
+enum {HEAP_OTHER, HEAP_CAT, HEAP_WEB_REQUEST, HEAP_WEB_RESPONSE, HEAP_WEBSOCKET, HEAP_DISPLAY, HEAP_TAGS};
+extern const char *heapTagNames[HEAP_TAGS];
+
+struct HeapSample {
+	uint32_t number;        // of the sample since the start
+	uint32_t time;          // millis()
+	uint32_t freeHeap;      // bytes of internal RAM
+	uint32_t largestBlock;  // largest block of internal RAM which can be allocated
+	uint32_t minFreeHeap;   // lowest free heap since the start
+	uint32_t psramFree;     // 0 without PSRAM
+	uint32_t psramSize;
+};
+
+// Counters of a subsystem since the start, read by HeapTelemetry::tagStats()
+struct HeapTagStats {
+	uint32_t allocs;
+	uint32_t frees;
+	uint32_t allocBytes;    // total allocated
+	uint32_t liveBytes;     // allocated and not freed yet
+	uint32_t peakBytes;     // highest liveBytes
+};
+
+// Sets the subsystem of the current task, returns the previous one
+uint8_t heapTag(uint8_t tag);
+
+// Sets the subsystem of the current task until the end of the scope
+class HeapScope
+{
+  public:
+	explicit HeapScope(uint8_t tag) : _previous(heapTag(tag)) {}
+	~HeapScope() {heapTag(_previous);}
+
+  private:
+	uint8_t _previous;
+};
+
+class HeapTelemetry
+{
+  public:
+	HeapTelemetry();
+
+	// Takes a sample if HEAP_SAMPLE_PERIOD ms elapsed since the last one, from one task only
+	void poll(uint32_t now);
+	void sample(uint32_t now);
+
+	// Number of samples taken since the start
+	uint32_t samples() const {return _count.load(std::memory_order_acquire);}
+	// Copies sample number n, false if it is not in the ring any more (or not yet)
+	bool getSample(uint32_t n, HeapSample &s) const;
+
+	void tagStats(uint8_t tag, HeapTagStats &stats) const;
+
+	// Called by operator new and delete
+	void countAlloc(uint8_t tag, uint32_t size);
+	void countFree(uint8_t tag, uint32_t size);
+
+  private:
+	struct Counters {
+		std::atomic<uint32_t> allocs, frees, allocBytes, liveBytes, peakBytes;
+	};
+
+	SeqLock<HeapSample> _ring[HEAP_SAMPLES];
+	std::atomic<uint32_t> _count;
+	uint32_t _lastSample;
+	Counters _tags[HEAP_TAGS];
+};
+
+extern HeapTelemetry heapTelemetry;
+
+#endif
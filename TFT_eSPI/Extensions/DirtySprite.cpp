@@ -0,0 +1,267 @@
+/**************************************************************************************
+// The following class is a 16 bit Sprite that only pushes the tiles that changed
+**************************************************************************************/
+
+/***************************************************************************************
+** Function name:           TFT_eDirtySprite
+** Description:             Class constructor
+*************************************************************************************x*/
+TFT_eDirtySprite::TFT_eDirtySprite(TFT_eSPI *tft) : TFT_eSprite(tft)
+{
+  _target    = tft;
+  _tileHash  = nullptr;
+  _tileDirty = nullptr;
+  _tileCols  = 0;
+  _tileRows  = 0;
+  _valid     = false;
+
+  _dmaPending   = false;
+  _dmaBuffer[0] = nullptr;
+  _dmaBuffer[1] = nullptr;
+  _dmaIndex     = 0;
+
+  _pushedTiles = _pushedWindows = 0;
+  _pushedBytes = 0;
+}
+
+
+/***************************************************************************************
+** Function name:           ~TFT_eDirtySprite
+** Description:             Class destructor
+*************************************************************************************x*/
+TFT_eDirtySprite::~TFT_eDirtySprite(void)
+{
+  deleteSprite();
+}
+
+
+/***************************************************************************************
+** Function name:           createSprite
+** Description:             Create a 16 bit sprite and the tile hash table
+*************************************************************************************x*/
+void* TFT_eDirtySprite::createSprite(int16_t w, int16_t h)
+{
+  if (_created) return _img;
+
+  setColorDepth(16);
+  if (TFT_eSprite::createSprite(w, h) == NULL) return NULL;
+
+  _tileCols  = (w + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+  _tileRows  = (h + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+  _tileHash  = (uint32_t*)calloc(_tileCols * _tileRows, sizeof(uint32_t));
+  _tileDirty = (uint8_t*) calloc(_tileCols * _tileRows, sizeof(uint8_t));
+
+  if (!_tileHash || !_tileDirty) {
+    deleteSprite();
+    return NULL;
+  }
+
+  _valid = false;
+  return _img;
+}
+
+
+/***************************************************************************************
+** Function name:           deleteSprite
+** Description:             Delete the sprite and the tile hash table
+*************************************************************************************x*/
+void TFT_eDirtySprite::deleteSprite(void)
+{
+  pushWait();
+  TFT_eSprite::deleteSprite();
+
+#ifdef ESP32_DMA
+  heap_caps_free(_dmaBuffer[0]);
+  heap_caps_free(_dmaBuffer[1]);
+#endif
+  _dmaBuffer[0] = nullptr;
+  _dmaBuffer[1] = nullptr;
+
+  free(_tileHash);
+  free(_tileDirty);
+  _tileHash  = nullptr;
+  _tileDirty = nullptr;
+  _tileCols  = 0;
+  _tileRows  = 0;
+  _valid     = false;
+}
+
+
+/***************************************************************************************
+** Function name:           invalidate
+** Description:             Send all the tiles at the next pushDirty()
+*************************************************************************************x*/
+void TFT_eDirtySprite::invalidate(void)
+{
+  _valid = false;
+}
+
+
+/***************************************************************************************
+** Function name:           hashTile
+** Description:             FNV-1a hash of the pixels of one tile
+*************************************************************************************x*/
+uint32_t TFT_eDirtySprite::hashTile(uint16_t col, uint16_t row)
+{
+  int32_t x0 = col * DIRTY_TILE_SIZE;
+  int32_t y0 = row * DIRTY_TILE_SIZE;
+  int32_t w  = _iwidth  - x0; if (w > DIRTY_TILE_SIZE) w = DIRTY_TILE_SIZE;
+  int32_t h  = _iheight - y0; if (h > DIRTY_TILE_SIZE) h = DIRTY_TILE_SIZE;
+
+  uint32_t hash = 2166136261UL;
+  uint16_t *line = _img + y0 * _iwidth + x0;
+
+  while (h--) {
+    for (int32_t i = 0; i < w; i++) hash = (hash ^ line[i]) * 16777619UL;
+    line += _iwidth;
+  }
+  return hash;
+}
+
+
+/***************************************************************************************
+** Function name:           pushDirty
+** Description:             Push the changed tiles to the TFT at x, y
+*************************************************************************************x*/
+// Adjacent changed tiles of a tile row are sent in one address window. The Sprite is not
+// clipped, it must fit on the TFT at x, y.
+// When the TFT DMA is enabled the tiles are copied to two DMA buffers in turn, a buffer is
+// filled while the other one is sent. The function returns while the last transfer is still
+// running so the caller can go on with other work, see pushWait().
+uint16_t TFT_eDirtySprite::pushDirty(int32_t x, int32_t y)
+{
+  pushWait();
+
+  _pushedTiles = _pushedWindows = 0;
+  _pushedBytes = 0;
+
+  if (!_created) return 0;
+
+  for (uint16_t row = 0; row < _tileRows; row++) {
+    for (uint16_t col = 0; col < _tileCols; col++) {
+      uint16_t t = row * _tileCols + col;
+      uint32_t hash = hashTile(col, row);
+      _tileDirty[t] = !_valid || hash != _tileHash[t];
+      _tileHash[t] = hash;
+    }
+  }
+  _valid = true;
+
+  bool dma = false;
+#ifdef ESP32_DMA
+  if (_target->DMA_Enabled && _iwidth <= DIRTY_DMA_PIXELS) {
+    if (!_dmaBuffer[0]) _dmaBuffer[0] = (uint16_t*)heap_caps_malloc(DIRTY_DMA_PIXELS * 2, MALLOC_CAP_DMA);
+    if (!_dmaBuffer[1]) _dmaBuffer[1] = (uint16_t*)heap_caps_malloc(DIRTY_DMA_PIXELS * 2, MALLOC_CAP_DMA);
+    dma = _dmaBuffer[0] && _dmaBuffer[1];
+  }
+#endif
+
+  bool oldSwapBytes = _target->getSwapBytes();
+  _target->setSwapBytes(false); // Sprite pixels are already in the TFT byte order
+  _target->startWrite();
+
+  for (uint16_t row = 0; row < _tileRows; row++) {
+    uint8_t *dirty = _tileDirty + row * _tileCols;
+    uint16_t col = 0;
+    while (col < _tileCols) {
+      if (!dirty[col]) { col++; continue; }
+
+      uint16_t first = col;
+      while (col < _tileCols && dirty[col]) col++;
+
+      int32_t x0 = first * DIRTY_TILE_SIZE;
+      int32_t y0 = row * DIRTY_TILE_SIZE;
+      int32_t w  = col * DIRTY_TILE_SIZE; if (w > _iwidth) w = _iwidth; w -= x0;
+      int32_t h  = _iheight - y0; if (h > DIRTY_TILE_SIZE) h = DIRTY_TILE_SIZE;
+
+      uint16_t *line = _img + y0 * _iwidth + x0;
+      if (dma) pushRunDMA(x + x0, y + y0, w, h, line);
+      else {
+        _target->setAddrWindow(x + x0, y + y0, w, h);
+        for (int32_t j = 0; j < h; j++) {
+          _target->pushPixels(line, w);
+          line += _iwidth;
+        }
+      }
+
+      _pushedTiles   += col - first;
+      _pushedWindows += 1;
+      _pushedBytes   += w * h * 2;
+    }
+  }
+
+  // With DMA the transaction stays open until the last transfer has been collected
+  if (dma && _pushedWindows) _dmaPending = true;
+  else _target->endWrite();
+  _target->setSwapBytes(oldSwapBytes);
+
+  return _pushedTiles;
+}
+
+
+/***************************************************************************************
+** Function name:           pushRunDMA
+** Description:             Send a run of changed tiles with DMA
+*************************************************************************************x*/
+// As many whole lines as fit are copied to the free DMA buffer, at most one transfer is
+// queued so the other buffer can be filled while it is sent.
+void TFT_eDirtySprite::pushRunDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *line)
+{
+#ifdef ESP32_DMA
+  int32_t maxLines = DIRTY_DMA_PIXELS / w;
+  bool    window   = false;
+
+  while (h > 0) {
+    int32_t lines = h < maxLines ? h : maxLines;
+    uint16_t *buf = _dmaBuffer[_dmaIndex];
+
+    for (int32_t j = 0; j < lines; j++) {
+      memcpy(buf + j * w, line, w * 2);
+      line += _iwidth;
+    }
+
+    if (!window) {
+      _target->dmaWait(); // The window commands are sent by the CPU
+      _target->setAddrWindow(x, y, w, h);
+      window = true;
+    }
+    _target->pushPixelsDMA(buf, lines * w);
+
+    _dmaIndex ^= 1;
+    h -= lines;
+  }
+#endif
+}
+
+
+/***************************************************************************************
+** Function name:           pushWait
+** Description:             Wait for the end of the last DMA transfer and release the bus
+*************************************************************************************x*/
+void TFT_eDirtySprite::pushWait(void)
+{
+  if (!_dmaPending) return;
+
+  _dmaPending = false;
+  _target->endWrite(); // endWrite() waits for the DMA to complete
+}
+
+
+/***************************************************************************************
+** Function name:           pushedTiles, pushedWindows, pushedBytes
+** Description:             Statistics of the last pushDirty()
+*************************************************************************************x*/
+uint16_t TFT_eDirtySprite::pushedTiles(void)
+{
+  return _pushedTiles;
+}
+
+uint16_t TFT_eDirtySprite::pushedWindows(void)
+{
+  return _pushedWindows;
+}
+
+uint32_t TFT_eDirtySprite::pushedBytes(void)
+{
+  return _pushedBytes;
+}
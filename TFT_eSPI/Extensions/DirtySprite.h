@@ -0,0 +1,62 @@
+/***************************************************************************************
+// The following class is a 16 bit Sprite that remembers what was last pushed to the TFT.
+// The Sprite is split in square tiles and a hash of each tile is kept, pushDirty() only
+// sends the tiles whose content changed since the previous push. A full screen layout
+// can then be redrawn in RAM at every update while the SPI bus only carries the changes.
+***************************************************************************************/
+
+#ifndef DIRTY_TILE_SIZE
+  #define DIRTY_TILE_SIZE 16   // Tile width and height in pixels
+#endif
+
+#ifndef DIRTY_DMA_PIXELS
+  #define DIRTY_DMA_PIXELS 2048 // Size of each of the two DMA buffers in pixels (ESP32 with initDMA() only)
+#endif
+
+class TFT_eDirtySprite : public TFT_eSprite {
+
+ public:
+
+  TFT_eDirtySprite(TFT_eSPI *tft);
+  ~TFT_eDirtySprite(void);
+
+           // Create a 16 bit Sprite and its tile hash table, returns NULL if the RAM is not available
+  void*    createSprite(int16_t width, int16_t height);
+
+           // Delete the sprite and the hash table
+  void     deleteSprite(void);
+
+           // Force the next pushDirty() to send every tile (e.g. after the TFT was written directly)
+  void     invalidate(void);
+
+           // Push the tiles that changed since the last push to the TFT at x, y, returns the tile count
+  uint16_t pushDirty(int32_t x, int32_t y);
+
+           // Wait for the DMA of the last pushDirty() to end and release the SPI bus. This must be
+           // called before drawing directly on the TFT when DMA is enabled, pushDirty() calls it.
+  void     pushWait(void);
+
+           // Statistics of the last pushDirty() call
+  uint16_t pushedTiles(void),
+           pushedWindows(void);
+  uint32_t pushedBytes(void);
+
+ private:
+
+  TFT_eSPI *_target;
+
+  uint32_t *_tileHash;  // hash of each tile as last pushed
+  uint8_t  *_tileDirty; // per tile flag for the push in progress
+  uint16_t _tileCols, _tileRows;
+  bool     _valid;      // false until a complete frame was pushed
+
+  uint16_t _pushedTiles, _pushedWindows;
+  uint32_t _pushedBytes;
+
+  bool     _dmaPending; // the last DMA transfer may still run, the SPI transaction is open
+  uint16_t *_dmaBuffer[2];
+  uint8_t  _dmaIndex;
+
+  uint32_t hashTile(uint16_t col, uint16_t row);
+  void     pushRunDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t *line);
+};
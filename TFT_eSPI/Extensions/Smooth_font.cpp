@@ -292,6 +292,8 @@ void TFT_eSPI::unloadFont( void )
     gBitmap = NULL;
   }
 
+  clearGlyphCache(); // The cached glyphs are indexed by glyph number in this font
+
   gFont.gArray = nullptr;
 
 #ifdef FONT_FS_AVAILABLE
@@ -348,6 +350,149 @@ bool TFT_eSPI::getUnicodeIndex(uint16_t unicode, uint16_t *index)
 }
 
 
+/***************************************************************************************
+** Function name:           setGlyphCache
+** Description:             Set the size of the decoded glyph cache, 0 = no cache
+*************************************************************************************x*/
+void TFT_eSPI::setGlyphCache(uint32_t bytes, bool preBlend)
+{
+  clearGlyphCache();
+  free(gCache);
+  gCache = nullptr;
+
+  if (bytes) gCache = (glyphCacheEntry*)calloc(GLYPH_CACHE_ENTRIES, sizeof(glyphCacheEntry));
+
+  gCacheSize   = gCache ? bytes : 0;
+  gCacheBlend  = preBlend;
+  gCacheHits   = 0;
+  gCacheMisses = 0;
+}
+
+/***************************************************************************************
+** Function name:           clearGlyphCache
+** Description:             Free the cached glyph bitmaps
+*************************************************************************************x*/
+void TFT_eSPI::clearGlyphCache(void)
+{
+  if (!gCache) return;
+
+  for (uint16_t i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+  {
+    free(gCache[i].data);
+    gCache[i].data = nullptr;
+  }
+  gCacheUsed = 0;
+}
+
+/***************************************************************************************
+** Function name:           glyphCacheHits, glyphCacheMisses
+** Description:             Cache statistics since setGlyphCache()
+*************************************************************************************x*/
+uint32_t TFT_eSPI::glyphCacheHits(void)
+{
+  return gCacheHits;
+}
+
+uint32_t TFT_eSPI::glyphCacheMisses(void)
+{
+  return gCacheMisses;
+}
+
+/***************************************************************************************
+** Function name:           cachedGlyph
+** Description:             Get the decoded bitmap of a glyph, reading it if not cached
+*************************************************************************************x*/
+// Returns the gWidth x gHeight alpha values of the glyph, or its pixels blended with fg
+// and bg if the cache is pre-blended. Returns nullptr if the glyph cannot be cached.
+const uint8_t* TFT_eSPI::cachedGlyph(uint16_t gNum, uint16_t fg, uint16_t bg)
+{
+  if (!gCache) return nullptr;
+
+  uint32_t pixels = gWidth[gNum] * gHeight[gNum];
+  uint32_t bytes  = gCacheBlend ? pixels * 2 : pixels;
+  if ((bytes == 0) || (bytes > gCacheSize)) return nullptr;
+
+  gCacheTick++;
+
+  glyphCacheEntry* e = nullptr;
+  for (uint16_t i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+  {
+    if (gCache[i].data && (gCache[i].gNum == gNum)) { e = &gCache[i]; break; }
+  }
+
+  if (e && (!gCacheBlend || ((e->fg == fg) && (e->bg == bg))))
+  {
+    e->lastUse = gCacheTick;
+    gCacheHits++;
+    return e->data;
+  }
+
+  gCacheMisses++;
+
+  if (!e) // Free the least recently used glyphs until there is an entry and room for this one
+  {
+    while (1)
+    {
+      glyphCacheEntry* freeEntry = nullptr;
+      glyphCacheEntry* lru = nullptr;
+      for (uint16_t i = 0; i < GLYPH_CACHE_ENTRIES; i++)
+      {
+        if (!gCache[i].data) freeEntry = &gCache[i];
+        else if (!lru || (gCache[i].lastUse < lru->lastUse)) lru = &gCache[i];
+      }
+      if (freeEntry && (gCacheUsed + bytes <= gCacheSize)) { e = freeEntry; break; }
+
+      gCacheUsed -= gWidth[lru->gNum] * gHeight[lru->gNum] * (gCacheBlend ? 2 : 1);
+      free(lru->data);
+      lru->data = nullptr;
+    }
+
+#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
+    if ( psramFound() && _psram_enable ) e->data = (uint8_t*)ps_malloc(bytes);
+    else
+#endif
+    e->data = (uint8_t*)malloc(bytes);
+
+    if (!e->data) return nullptr;
+
+    e->gNum = gNum;
+    gCacheUsed += bytes;
+  }
+
+  e->fg = fg;
+  e->bg = bg;
+  e->lastUse = gCacheTick;
+
+  // Pre-blended pixels are computed in place from alpha values read into the top half
+  uint8_t* alpha = gCacheBlend ? e->data + pixels : e->data;
+
+#ifdef FONT_FS_AVAILABLE
+  if (fs_font)
+  {
+    fontFile.seek(gBitmap[gNum], fs::SeekSet);
+    fontFile.read(alpha, pixels);
+  }
+  else
+#endif
+  {
+    const uint8_t* gPtr = (const uint8_t*) gFont.gArray + gBitmap[gNum];
+    for (uint32_t i = 0; i < pixels; i++) alpha[i] = pgm_read_byte(gPtr + i);
+  }
+
+  if (gCacheBlend)
+  {
+    uint16_t* pix = (uint16_t*)e->data;
+    for (uint32_t i = 0; i < pixels; i++)
+    {
+      uint8_t a = alpha[i];
+      pix[i] = (a == 0xFF) ? fg : alphaBlend(a, fg, bg);
+    }
+  }
+
+  return e->data;
+}
+
+
 /***************************************************************************************
 ** Function name:           drawGlyph
 ** Description:             Write a character to the TFT cursor position
@@ -390,8 +535,24 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     uint8_t* pbuffer = nullptr;
     const uint8_t* gPtr = (const uint8_t*) gFont.gArray;
 
+    int16_t cy = cursor_y + gFont.maxAscent - gdY[gNum];
+    int16_t cx = cursor_x + gdX[gNum];
+
+    // Pre-blended pixels cannot be used if the background is read from the screen
+    const uint8_t* cached = (gCacheBlend && getColor) ? nullptr : cachedGlyph(gNum, fg, bg);
+
+    if (cached && gCacheBlend)
+    {
+      bool swap = _swapBytes;
+      _swapBytes = true; // The cached pixels are in the usual 565 colour order
+      pushImage(cx, cy, gWidth[gNum], gHeight[gNum], (uint16_t*)cached);
+      _swapBytes = swap;
+      cursor_x += gxAdvance[gNum];
+      return;
+    }
+
 #ifdef FONT_FS_AVAILABLE
-    if (fs_font)
+    if (fs_font && !cached)
     {
       fontFile.seek(gBitmap[gNum], fs::SeekSet); // This is taking >30ms for a significant position shift
       pbuffer =  (uint8_t*)malloc(gWidth[gNum]);
@@ -402,15 +563,12 @@ void TFT_eSPI::drawGlyph(uint16_t code)
     uint32_t dl = 0;
     uint8_t pixel;
 
-    int16_t cy = cursor_y + gFont.maxAscent - gdY[gNum];
-    int16_t cx = cursor_x + gdX[gNum];
-
     startWrite(); // Avoid slow ESP32 transaction overhead for every pixel
 
     for (int y = 0; y < gHeight[gNum]; y++)
     {
 #ifdef FONT_FS_AVAILABLE
-      if (fs_font) {
+      if (fs_font && !cached) {
         if (spiffs)
         {
           fontFile.read(pbuffer, gWidth[gNum]);
@@ -427,6 +585,8 @@ void TFT_eSPI::drawGlyph(uint16_t code)
 #endif
       for (int x = 0; x < gWidth[gNum]; x++)
       {
+        if (cached) pixel = cached[x + gWidth[gNum] * y];
+        else
 #ifdef FONT_FS_AVAILABLE
         if (fs_font) pixel = pbuffer[x];
         else
@@ -16,6 +16,17 @@
 
   void     showFont(uint32_t td);
 
+           // Keep up to "bytes" of decoded glyph bitmaps in RAM (PSRAM if available) so each glyph is read from
+           // the font file or array only once, 0 = no cache. With preBlend the glyphs are stored as 16 bit pixels
+           // blended with the text colours and drawn in one block with their background, this is only correct
+           // when the text is drawn on a plain area of the text background colour.
+  void     setGlyphCache(uint32_t bytes, bool preBlend = false);
+           // Free the cached glyphs (done by unloadFont)
+  void     clearGlyphCache(void);
+           // Number of glyphs found in the cache and decoded since setGlyphCache()
+  uint32_t glyphCacheHits(void),
+           glyphCacheMisses(void);
+
  // This is for the whole font
   typedef struct
   {
@@ -52,6 +63,24 @@ fontMetrics gFont = { nullptr, 0, 0, 0, 0, 0, 0, 0 };
   bool     fontFile = true;
 #endif
 
+  // Decoded glyph cache entry
+  typedef struct
+  {
+    uint16_t gNum;                   // Glyph index in the font
+    uint16_t fg, bg;                 // Colours of a pre-blended glyph
+    uint32_t lastUse;                // For least recently used replacement
+    uint8_t* data;                   // Alpha values or 16 bit pixels if pre-blended, nullptr = free entry
+  } glyphCacheEntry;
+
+  protected:
+
+  const uint8_t* cachedGlyph(uint16_t gNum, uint16_t fg, uint16_t bg); // nullptr if not cached
+
+  glyphCacheEntry* gCache = nullptr;
+  uint32_t gCacheSize = 0, gCacheUsed = 0;  // Limit and total of the glyph bitmaps in bytes
+  uint32_t gCacheTick = 0, gCacheHits = 0, gCacheMisses = 0;
+  bool     gCacheBlend = false;
+
   private:
 
   void     loadMetrics(void);
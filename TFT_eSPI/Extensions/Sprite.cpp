@@ -2254,8 +2254,23 @@ void TFT_eSprite::drawGlyph(uint16_t code)
     uint8_t* pbuffer = nullptr;
     const uint8_t* gPtr = (const uint8_t*) this->gFont.gArray;
 
+    // Pre-blended glyphs are only drawn in a created 16 or 8 bit Sprite, otherwise the alpha values are needed
+    bool blend = this->gCacheBlend && !newSprite && (_bpp == 16 || _bpp == 8);
+    const uint8_t* cached = (this->gCacheBlend && !blend) ? nullptr : this->cachedGlyph(gNum, fg, bg);
+
+    if (cached && blend)
+    {
+      bool swap = _iswapBytes;
+      _iswapBytes = false; // The cached pixels are in the usual 565 colour order
+      pushImage(this->cursor_x + this->gdX[gNum], this->cursor_y + this->gFont.maxAscent - this->gdY[gNum],
+                this->gWidth[gNum], this->gHeight[gNum], (uint16_t*)cached);
+      _iswapBytes = swap;
+      this->cursor_x += this->gxAdvance[gNum];
+      return;
+    }
+
 #ifdef FONT_FS_AVAILABLE
-    if (this->fs_font) {
+    if (this->fs_font && !cached) {
       this->fontFile.seek(this->gBitmap[gNum], fs::SeekSet); // This is slow for a significant position shift!
       pbuffer =  (uint8_t*)malloc(this->gWidth[gNum]);
     }
@@ -2268,12 +2283,14 @@ void TFT_eSprite::drawGlyph(uint16_t code)
     for (int32_t y = 0; y < this->gHeight[gNum]; y++)
     {
 #ifdef FONT_FS_AVAILABLE
-      if (this->fs_font) {
+      if (this->fs_font && !cached) {
         this->fontFile.read(pbuffer, this->gWidth[gNum]);
       }
 #endif
       for (int32_t x = 0; x < this->gWidth[gNum]; x++)
       {
+        if (cached) pixel = cached[x + this->gWidth[gNum] * y];
+        else
 #ifdef FONT_FS_AVAILABLE
         if (this->fs_font) {
           pixel = pbuffer[x];
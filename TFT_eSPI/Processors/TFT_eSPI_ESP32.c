@@ -475,3 +475,189 @@ void TFT_eSPI::pushPixels(const void* data_in, uint32_t len){
 ////////////////////////////////////////////////////////////////////////////////////////
 #endif // End of display interface specific functions
 ////////////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////////////
+#if defined (ESP32_DMA) && !defined (TFT_PARALLEL_8_BIT) //       DMA FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////////////
+
+// The DMA transfers use the ESP-IDF SPI master driver on the same SPI port as the register
+// level functions. The TFT chip select and DC lines are still driven by this library, the
+// DMA only sends the pixel data once the window has been set with setAddrWindow().
+
+spi_device_handle_t dmaHAL;
+
+#ifdef USE_HSPI_PORT
+  spi_host_device_t spi_host = HSPI_HOST;
+#else
+  spi_host_device_t spi_host = VSPI_HOST;
+#endif
+
+// A transaction descriptor must stay valid until the driver has finished with it
+static spi_transaction_t dmaTrans;
+
+/***************************************************************************************
+** Function name:           dmaBusy
+** Description:             Check if DMA is busy (usefully non-blocking!)
+***************************************************************************************/
+// Use "while(tft.dmaBusy());" in sketch for a blocking wait for DMA to complete
+bool TFT_eSPI::dmaBusy(void)
+{
+  if (!DMA_Enabled || !spiBusyCheck) return false;
+
+  spi_transaction_t *rtrans;
+  while (spiBusyCheck && (spi_device_get_trans_result(dmaHAL, &rtrans, 0) == ESP_OK)) spiBusyCheck--;
+
+  return spiBusyCheck != 0;
+}
+
+/***************************************************************************************
+** Function name:           dmaWait
+** Description:             Wait until the DMA transfers in progress are complete
+***************************************************************************************/
+void TFT_eSPI::dmaWait(void)
+{
+  if (!DMA_Enabled || !spiBusyCheck) return;
+
+  spi_transaction_t *rtrans;
+  while (spiBusyCheck) {
+    spi_device_get_trans_result(dmaHAL, &rtrans, portMAX_DELAY);
+    spiBusyCheck--;
+  }
+}
+
+/***************************************************************************************
+** Function name:           pushPixelsDMA
+** Description:             Push pixels to TFT (len must be less than 32767)
+***************************************************************************************/
+// The image buffer must be in DMA capable RAM and must not be changed until the DMA is
+// complete. If swap bytes is set the buffer content is swapped before the transfer.
+void TFT_eSPI::pushPixelsDMA(uint16_t* image, uint32_t len)
+{
+  if ((len == 0) || (!DMA_Enabled)) return;
+
+  dmaWait();
+
+  if(_swapBytes) {
+    for (uint32_t i = 0; i < len; i++) image[i] = image[i] << 8 | image[i] >> 8;
+  }
+
+  memset(&dmaTrans, 0, sizeof(spi_transaction_t));
+  dmaTrans.tx_buffer = image;
+  dmaTrans.length    = len * 16; // Data length in bits
+
+  if (spi_device_queue_trans(dmaHAL, &dmaTrans, portMAX_DELAY) == ESP_OK) spiBusyCheck++;
+}
+
+/***************************************************************************************
+** Function name:           pushImageDMA
+** Description:             Push image to a window (w*h must be less than 65536)
+***************************************************************************************/
+// If a buffer is given the image is copied to it (clipped and byte swapped if needed) and
+// the image may then be changed while the DMA sends the buffer content.
+void TFT_eSPI::pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t* image, uint16_t* buffer)
+{
+  if ((x >= _width) || (y >= _height) || (!DMA_Enabled)) return;
+
+  int32_t dx = 0;
+  int32_t dy = 0;
+  int32_t dw = w;
+  int32_t dh = h;
+
+  if (x < 0) { dw += x; dx = -x; x = 0; }
+  if (y < 0) { dh += y; dy = -y; y = 0; }
+
+  if ((x + dw) > _width ) dw = _width  - x;
+  if ((y + dh) > _height) dh = _height - y;
+
+  if (dw < 1 || dh < 1) return;
+
+  uint32_t len = dw*dh;
+
+  if (buffer == nullptr) {
+    buffer = image;
+    dmaWait(); // The image may be changed below, so the previous transfer must be over
+  }
+
+  // If the image is clipped, copy the pixels into a contiguous block
+  if ( (dw != w) || (dh != h) ) {
+    for (int32_t yb = 0; yb < dh; yb++) {
+      memmove(buffer + yb * dw, image + dx + w * (yb + dy), dw << 1);
+    }
+  }
+  // else, if a buffer pointer has been provided copy the whole image to the buffer
+  else if (buffer != image) {
+    memcpy(buffer, image, len << 1);
+  }
+
+  if(_swapBytes) {
+    for (uint32_t i = 0; i < len; i++) buffer[i] = buffer[i] << 8 | buffer[i] >> 8;
+  }
+
+  dmaWait(); // In case we did not wait earlier
+
+  setAddrWindow(x, y, dw, dh);
+
+  memset(&dmaTrans, 0, sizeof(spi_transaction_t));
+  dmaTrans.tx_buffer = buffer;
+  dmaTrans.length    = len * 16; // Data length in bits
+
+  if (spi_device_queue_trans(dmaHAL, &dmaTrans, portMAX_DELAY) == ESP_OK) spiBusyCheck++;
+}
+
+/***************************************************************************************
+** Function name:           initDMA
+** Description:             Initialise the DMA engine - returns true if init OK
+***************************************************************************************/
+bool TFT_eSPI::initDMA(void)
+{
+  if (DMA_Enabled) return false;
+
+  spi_bus_config_t buscfg;
+  memset(&buscfg, 0, sizeof(buscfg));
+  buscfg.mosi_io_num     = TFT_MOSI;
+#if defined (TFT_MISO) && !defined (TFT_SDA_READ)
+  buscfg.miso_io_num     = TFT_MISO;
+#else
+  buscfg.miso_io_num     = -1;
+#endif
+  buscfg.sclk_io_num     = TFT_SCLK;
+  buscfg.quadwp_io_num   = -1;
+  buscfg.quadhd_io_num   = -1;
+  buscfg.max_transfer_sz = TFT_WIDTH * TFT_HEIGHT * 2 + 8; // Full screen
+
+  spi_device_interface_config_t devcfg;
+  memset(&devcfg, 0, sizeof(devcfg));
+  devcfg.mode           = TFT_SPI_MODE;
+  devcfg.clock_speed_hz = SPI_FREQUENCY;
+  devcfg.spics_io_num   = -1;                  // Chip select is driven by the library
+  devcfg.flags          = SPI_DEVICE_NO_DUMMY;
+  devcfg.queue_size     = 1;
+
+  if (spi_bus_initialize(spi_host, &buscfg, 1) != ESP_OK) return false;
+
+  if (spi_bus_add_device(spi_host, &devcfg, &dmaHAL) != ESP_OK) {
+    spi_bus_free(spi_host);
+    return false;
+  }
+
+  spiBusyCheck = 0;
+  return DMA_Enabled = true;
+}
+
+/***************************************************************************************
+** Function name:           deInitDMA
+** Description:             Disconnect the DMA engine from SPI
+***************************************************************************************/
+void TFT_eSPI::deInitDMA(void)
+{
+  if (!DMA_Enabled) return;
+
+  dmaWait();
+  spi_bus_remove_device(dmaHAL);
+  spi_bus_free(spi_host);
+  DMA_Enabled = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+#endif // End of DMA FUNCTIONS
+////////////////////////////////////////////////////////////////////////////////////////
@@ -11,12 +11,32 @@
 // Include processor specific header
 #include "soc/spi_reg.h"
 
+// DMA is supported for SPI displays with 16 bit pixels, it uses the ESP-IDF SPI master driver
+#if !defined (TFT_PARALLEL_8_BIT) && !defined (ESP32_PARALLEL) && !defined (ILI9488_DRIVER) && !defined (RPI_DISPLAY_TYPE)
+  #define ESP32_DMA
+  #include "driver/spi_master.h"
+  #include "esp_heap_caps.h"
+#endif
+
 // Processor specific code used by SPI bus transaction startWrite and endWrite functions
-#define SET_BUS_WRITE_MODE // Not used
-#define SET_BUS_READ_MODE  // Not used
+#if defined (ESP32_DMA)
+  // The SPI master driver reprograms the SPI user register for each DMA transaction
+  // so the register write mode is restored when the CPU writes to the TFT again
+  // (TFT_SPI_MODE is defined after this file is included, it is only evaluated where the macros are used)
+  #define SPI_CK_OUT_MODE   (((TFT_SPI_MODE == SPI_MODE1) || (TFT_SPI_MODE == SPI_MODE2)) ? SPI_CK_OUT_EDGE : 0)
+  #define SET_BUS_WRITE_MODE WRITE_PERI_REG(SPI_USER_REG(SPI_PORT), SPI_USR_MOSI | SPI_CK_OUT_MODE)
+  #define SET_BUS_READ_MODE  WRITE_PERI_REG(SPI_USER_REG(SPI_PORT), SPI_USR_MOSI | SPI_USR_MISO | SPI_DOUTDIN | SPI_CK_OUT_MODE)
+#else
+  #define SET_BUS_WRITE_MODE // Not used
+  #define SET_BUS_READ_MODE  // Not used
+#endif
 
 // Code to check if DMA is busy, used by SPI bus transaction transaction and endWrite functions
-#define DMA_BUSY_CHECK // DMA not implemented for this processor (yet)
+#if defined (ESP32_DMA)
+  #define DMA_BUSY_CHECK dmaWait()
+#else
+  #define DMA_BUSY_CHECK
+#endif
 
 // SUPPORT_TRANSACTIONS is mandatory for ESP32 so the hal mutex is toggled
 #if !defined (SUPPORT_TRANSACTIONS)
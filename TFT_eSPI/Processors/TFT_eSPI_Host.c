@@ -0,0 +1,302 @@
+        ////////////////////////////////////////////////////
+        //      TFT_eSPI host (PC) panel emulator         //
+        ////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Global variables
+////////////////////////////////////////////////////////////////////////////////////////
+
+// The SPI port is only used for begin() and the transactions, the bytes go to tftHost
+SPIClass& spi = SPI;
+
+TFT_HostPanel tftHost;
+
+#if defined (TFT_PARALLEL_8_BIT) || defined (ILI9488_DRIVER) || defined (RPI_DISPLAY_TYPE) || defined (TFT_SDA_READ)
+  #error "The host panel emulator only supports 16 bit colour SPI displays"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////
+//                      Standard SPI 16 bit colour TFT
+////////////////////////////////////////////////////////////////////////////////////////
+
+/***************************************************************************************
+** Function name:           pushBlock - for host
+** Description:             Write a block of pixels of the same colour
+***************************************************************************************/
+void TFT_eSPI::pushBlock(uint16_t color, uint32_t len){
+  while ( len-- ) {tft_Write_16(color);}
+}
+
+/***************************************************************************************
+** Function name:           pushPixels - for host
+** Description:             Write a sequence of pixels
+***************************************************************************************/
+void TFT_eSPI::pushPixels(const void* data_in, uint32_t len){
+  uint16_t *data = (uint16_t*)data_in;
+  if (_swapBytes) while ( len-- ) {tft_Write_16(*data); data++;}
+  else while ( len-- ) {tft_Write_16S(*data); data++;}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+//                      Emulated panel
+////////////////////////////////////////////////////////////////////////////////////////
+
+// MIPI DCS commands decoded by the emulator
+#define HOST_CASET 0x2A
+#define HOST_PASET 0x2B
+#define HOST_RAMWR 0x2C
+#define HOST_RAMRD 0x2E
+
+/***************************************************************************************
+** Function name:           TFT_HostPanel
+** Description:             Class constructor
+***************************************************************************************/
+TFT_HostPanel::TFT_HostPanel(void)
+{
+  memset(ram, 0, sizeof(ram));
+  resetCounters();
+
+  _dc = true;
+  _csLow = false;
+  _cmd = 0;
+  _param = 0;
+  _xs = _xe = _ys = _ye = _x = _y = 0;
+  _hiByte = -1;
+}
+
+/***************************************************************************************
+** Function name:           resetCounters
+** Description:             Set the traffic counters to 0
+***************************************************************************************/
+void TFT_HostPanel::resetCounters(void)
+{
+  bytes = commands = windows = pixelBytes = readBytes = transactions = 0;
+}
+
+/***************************************************************************************
+** Function name:           dc, cs
+** Description:             Bus control lines
+***************************************************************************************/
+void TFT_HostPanel::dc(bool data)
+{
+  _dc = data;
+}
+
+void TFT_HostPanel::cs(bool high)
+{
+  if (!high && !_csLow) transactions++;
+  _csLow = !high;
+}
+
+/***************************************************************************************
+** Function name:           nextPixel
+** Description:             Move the RAM pointer to the next pixel of the window
+***************************************************************************************/
+void TFT_HostPanel::nextPixel(void)
+{
+  if (++_x > _xe) {
+    _x = _xs;
+    if (++_y > _ye) _y = _ys;
+  }
+}
+
+/***************************************************************************************
+** Function name:           write
+** Description:             Decode a byte sent to the TFT
+***************************************************************************************/
+void TFT_HostPanel::write(uint8_t b)
+{
+  bytes++;
+
+  if (!_dc) { // Command
+    commands++;
+    _cmd = b;
+    _param = 0;
+    _hiByte = -1;
+    if (_cmd == HOST_CASET) windows++;
+    if ((_cmd == HOST_RAMWR) || (_cmd == HOST_RAMRD)) { _x = _xs; _y = _ys; }
+    return;
+  }
+
+  switch (_cmd) {
+    case HOST_CASET:
+    case HOST_PASET:
+      if (_param < 4) _args[_param] = b;
+      if (++_param == 4) {
+        int32_t s = _args[0] << 8 | _args[1];
+        int32_t e = _args[2] << 8 | _args[3];
+        if (_cmd == HOST_CASET) { _xs = s; _xe = e; }
+        else                    { _ys = s; _ye = e; }
+      }
+      break;
+
+    case HOST_RAMWR:
+      pixelBytes++;
+      if (_hiByte < 0) { _hiByte = b; break; }
+      if ((_x < TFT_HOST_RAM_W) && (_y < TFT_HOST_RAM_H)) ram[_x + _y * TFT_HOST_RAM_W] = _hiByte << 8 | b;
+      _hiByte = -1;
+      nextPixel();
+      break;
+
+    default: // Other commands and their parameters are only counted
+      break;
+  }
+}
+
+/***************************************************************************************
+** Function name:           read
+** Description:             Byte read from the TFT, only the RAM read is emulated
+***************************************************************************************/
+// After the RAM read command a dummy byte is returned then the red, green and blue bytes
+// of each pixel, as the panel returns its 18 bit colours.
+uint8_t TFT_HostPanel::read(void)
+{
+  readBytes++;
+
+  if (_cmd != HOST_RAMRD) return 0;
+  if (_param++ == 0) return 0; // Dummy byte
+
+  uint16_t color = 0;
+  if ((_x < TFT_HOST_RAM_W) && (_y < TFT_HOST_RAM_H)) color = ram[_x + _y * TFT_HOST_RAM_W];
+
+  uint8_t rgb;
+  switch ((_param - 2) % 3) {
+    case 0:  rgb = (color & 0xF800) >> 8; break;
+    case 1:  rgb = (color & 0x07E0) >> 3; break;
+    default: rgb = (color & 0x001F) << 3; nextPixel(); break;
+  }
+  return rgb;
+}
+
+/***************************************************************************************
+** Function name:           pixel
+** Description:             Colour of the display RAM at column x, row y
+***************************************************************************************/
+uint16_t TFT_HostPanel::pixel(int32_t x, int32_t y)
+{
+  if ((x < 0) || (y < 0) || (x >= TFT_HOST_RAM_W) || (y >= TFT_HOST_RAM_H)) return 0;
+  return ram[x + y * TFT_HOST_RAM_W];
+}
+
+/***************************************************************************************
+** Function name:           rgbRow
+** Description:             Convert a row of the display RAM to 24 bit RGB
+***************************************************************************************/
+void TFT_HostPanel::rgbRow(uint8_t *rgb, int32_t x, int32_t y, int32_t w)
+{
+  for (int32_t i = 0; i < w; i++) {
+    uint16_t color = pixel(x + i, y);
+    uint8_t r = (color >> 11) & 0x1F, g = (color >> 5) & 0x3F, b = color & 0x1F;
+    *rgb++ = (r << 3) | (r >> 2);
+    *rgb++ = (g << 2) | (g >> 4);
+    *rgb++ = (b << 3) | (b >> 2);
+  }
+}
+
+/***************************************************************************************
+** Function name:           savePPM
+** Description:             Save a rectangle of the display RAM as a binary PPM file
+***************************************************************************************/
+bool TFT_HostPanel::savePPM(const char *fileName, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+  if ((w < 1) || (h < 1)) return false;
+
+  FILE *f = fopen(fileName, "wb");
+  if (!f) return false;
+
+  uint8_t *rgb = (uint8_t*)malloc(w * 3);
+  bool ok = rgb && (fprintf(f, "P6\n%d %d\n255\n", (int)w, (int)h) > 0);
+
+  for (int32_t j = 0; ok && (j < h); j++) {
+    rgbRow(rgb, x, y + j, w);
+    ok = fwrite(rgb, 3, w, f) == (size_t)w;
+  }
+
+  free(rgb);
+  return (fclose(f) == 0) && ok;
+}
+
+/***************************************************************************************
+** Function name:           savePNG
+** Description:             Save a rectangle of the display RAM as a PNG file
+***************************************************************************************/
+// The image data is stored in uncompressed deflate blocks so no zlib is needed
+static uint32_t hostCrc(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+static void hostPut32(uint8_t *p, uint32_t v)
+{
+  p[0] = v >> 24; p[1] = v >> 16; p[2] = v >> 8; p[3] = v;
+}
+
+static bool hostChunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+  uint8_t hdr[8];
+  hostPut32(hdr, len);
+  memcpy(hdr + 4, type, 4);
+  uint8_t crc[4];
+  hostPut32(crc, hostCrc(hostCrc(0, hdr + 4, 4), data, len));
+  return (fwrite(hdr, 1, 8, f) == 8) && (fwrite(data, 1, len, f) == len) && (fwrite(crc, 1, 4, f) == 4);
+}
+
+bool TFT_HostPanel::savePNG(const char *fileName, int32_t x, int32_t y, int32_t w, int32_t h)
+{
+  if ((w < 1) || (h < 1)) return false;
+
+  // Raw image: each row is a filter byte (0 = none) and the RGB pixels
+  uint32_t rowLen = 1 + w * 3;
+  uint32_t rawLen = rowLen * h;
+  uint32_t blocks = (rawLen + 65534) / 65535;
+  uint32_t zLen   = 2 + rawLen + blocks * 5 + 4;
+
+  uint8_t *raw = (uint8_t*)malloc(rawLen);
+  uint8_t *z   = (uint8_t*)malloc(zLen);
+  if (!raw || !z) { free(raw); free(z); return false; }
+
+  for (int32_t j = 0; j < h; j++) {
+    raw[j * rowLen] = 0;
+    rgbRow(raw + j * rowLen + 1, x, y + j, w);
+  }
+
+  // zlib stream of stored deflate blocks and Adler-32 checksum
+  uint8_t *p = z;
+  *p++ = 0x78; *p++ = 0x01;
+  uint32_t a = 1, b = 0;
+  for (uint32_t i = 0; i < rawLen; i++) { a = (a + raw[i]) % 65521; b = (b + a) % 65521; }
+  for (uint32_t pos = 0; pos < rawLen; pos += 65535) {
+    uint32_t n = rawLen - pos; if (n > 65535) n = 65535;
+    *p++ = (pos + n == rawLen);
+    *p++ = n; *p++ = n >> 8; *p++ = ~n; *p++ = ~n >> 8;
+    memcpy(p, raw + pos, n);
+    p += n;
+  }
+  hostPut32(p, (b << 16) | a);
+
+  uint8_t ihdr[13];
+  hostPut32(ihdr, w);
+  hostPut32(ihdr + 4, h);
+  ihdr[8] = 8;  // Bits per channel
+  ihdr[9] = 2;  // RGB
+  ihdr[10] = ihdr[11] = ihdr[12] = 0;
+
+  static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+  bool ok = false;
+  FILE *f = fopen(fileName, "wb");
+  if (f) {
+    ok = (fwrite(signature, 1, 8, f) == 8) && hostChunk(f, "IHDR", ihdr, 13) &&
+         hostChunk(f, "IDAT", z, zLen) && hostChunk(f, "IEND", nullptr, 0);
+    ok = (fclose(f) == 0) && ok;
+  }
+
+  free(raw);
+  free(z);
+  return ok;
+}
@@ -0,0 +1,144 @@
+        ////////////////////////////////////////////////////
+        //      TFT_eSPI host (PC) panel emulator         //
+        ////////////////////////////////////////////////////
+
+// This backend is selected by #define TFT_HOST in the user setup. It lets the library and
+// sketch display code run on a PC: the bytes that would be sent to the TFT are decoded into
+// a RAM framebuffer instead, and the SPI traffic is counted. The Arduino core functions and
+// classes used by the library (Arduino.h, Print, SPI.h...) must be provided by the host build.
+
+// Only 16 bit SPI displays using the MIPI DCS commands (ST7789, ILI9341...) are decoded.
+// The font tables hold 32 bit pointers read with pgm_read_dword(), so a 64 bit host build
+// can only use the GLCD, free and smooth fonts.
+
+#ifndef _TFT_eSPI_HOSTH_
+#define _TFT_eSPI_HOSTH_
+
+// Processor ID reported by getSetup()
+#define PROCESSOR_ID 0x4854
+
+// Include processor specific header
+#include <stdio.h>
+
+// Size of the emulated display RAM, the pixels are stored at the column and row addresses
+// sent by the library i.e. at the screen coordinates plus the panel offsets (colstart, rowstart)
+#ifndef TFT_HOST_RAM_W
+  #define TFT_HOST_RAM_W 320
+#endif
+#ifndef TFT_HOST_RAM_H
+  #define TFT_HOST_RAM_H 320
+#endif
+
+// Processor specific code used by SPI bus transaction startWrite and endWrite functions
+#define SET_BUS_WRITE_MODE // Not used
+#define SET_BUS_READ_MODE  // Not used
+
+// Code to check if DMA is busy, used by SPI bus transaction startWrite and endWrite functions
+#define DMA_BUSY_CHECK // Not used so leave blank
+
+// Initialise processor specific SPI functions, used by init()
+#define INIT_TFT_DATA_BUS
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Emulated TFT panel
+////////////////////////////////////////////////////////////////////////////////////////
+class TFT_HostPanel {
+
+ public:
+
+  TFT_HostPanel(void);
+
+           // Bus signals driven by the library
+  void     dc(bool data);        // DC line: false = command, true = data
+  void     cs(bool high);        // Chip select line
+  void     write(uint8_t b);     // A byte sent to the TFT
+  uint8_t  read(void);           // A byte read from the TFT
+
+           // Colour (565 format) of the display RAM at column x, row y
+  uint16_t pixel(int32_t x, int32_t y);
+
+           // Save a rectangle of the display RAM as a binary PPM or PNG image file, return false on error
+  bool     savePPM(const char *fileName, int32_t x, int32_t y, int32_t w, int32_t h);
+  bool     savePNG(const char *fileName, int32_t x, int32_t y, int32_t w, int32_t h);
+
+           // Set the traffic counters to 0
+  void     resetCounters(void);
+
+           // Traffic counters
+  uint32_t bytes,         // All the bytes written to the TFT
+           commands,      // Command bytes
+           windows,       // Address windows set (column address commands)
+           pixelBytes,    // Bytes written to the display RAM
+           readBytes,     // Bytes read from the TFT
+           transactions;  // Chip select low pulses
+
+  uint16_t ram[TFT_HOST_RAM_W * TFT_HOST_RAM_H]; // Display RAM in 565 format
+
+ private:
+
+  bool     _dc, _csLow;
+  uint8_t  _cmd;           // Last command
+  uint32_t _param;         // Number of parameter bytes received or pixels read since the command
+  uint8_t  _args[4];
+  int32_t  _xs, _xe, _ys, _ye, _x, _y;
+  int16_t  _hiByte;        // First byte of a pixel being written, -1 if none
+
+  void     nextPixel(void);
+  void     rgbRow(uint8_t *rgb, int32_t x, int32_t y, int32_t w);
+};
+
+extern TFT_HostPanel tftHost;
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Define the DC (TFT Data/Command or Register Select (RS))pin drive code
+////////////////////////////////////////////////////////////////////////////////////////
+#define DC_C tftHost.dc(false)
+#define DC_D tftHost.dc(true)
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Define the CS (TFT chip select) pin drive code
+////////////////////////////////////////////////////////////////////////////////////////
+#define CS_L tftHost.cs(false)
+#define CS_H tftHost.cs(true)
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Define the touch screen chip select pin drive code
+////////////////////////////////////////////////////////////////////////////////////////
+#define T_CS_L // No macro allocated so it generates no code
+#define T_CS_H // No macro allocated so it generates no code
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Make sure TFT_MISO is defined if not used to avoid an error message
+////////////////////////////////////////////////////////////////////////////////////////
+#ifndef TFT_MISO
+  #define TFT_MISO -1
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Macros to write commands/pixel colour data to the emulated TFT
+////////////////////////////////////////////////////////////////////////////////////////
+#define tft_Write_8(C)   tftHost.write((uint8_t)(C))
+
+#define tft_Write_16(C)  tftHost.write((uint8_t)((C)>>8)); tftHost.write((uint8_t)((C)>>0))
+
+#define tft_Write_16S(C) tftHost.write((uint8_t)((C)>>0)); tftHost.write((uint8_t)((C)>>8))
+
+#define tft_Write_32(C) \
+tft_Write_16((uint16_t) ((C)>>16)); \
+tft_Write_16((uint16_t) ((C)>>0))
+
+#define tft_Write_32C(C,D) \
+tft_Write_16((uint16_t) (C)); \
+tft_Write_16((uint16_t) (D))
+
+#define tft_Write_32D(C) \
+tft_Write_16((uint16_t) (C)); \
+tft_Write_16((uint16_t) (C))
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Macros to read from the emulated TFT
+////////////////////////////////////////////////////////////////////////////////////////
+#define tft_Read_8() tftHost.read()
+
+
+#endif // Header end
@@ -16,7 +16,9 @@
 
 #include "TFT_eSPI.h"
 
-#if defined (ESP32)
+#if defined (TFT_HOST)
+  #include "Processors/TFT_eSPI_Host.c"
+#elif defined (ESP32)
   #include "Processors/TFT_eSPI_ESP32.c"
 #elif defined (ESP8266)
   #include "Processors/TFT_eSPI_ESP8266.c"
@@ -32,6 +34,7 @@
 ** Description:             Start SPI transaction for writes and select TFT
 ***************************************************************************************/
 inline void TFT_eSPI::begin_tft_write(void){
+  DMA_BUSY_CHECK; // The CPU must not write to the SPI registers while a DMA transfer is running
 #if defined (SPI_HAS_TRANSACTION) && defined (SUPPORT_TRANSACTIONS) && !defined(TFT_PARALLEL_8_BIT)
   if (locked) {
     locked = false;
@@ -2496,6 +2499,42 @@ void TFT_eSPI::drawChar(int32_t x, int32_t y, uint16_t c, uint32_t color, uint32
 
     end_tft_write();
   }
+  else if (fillbg && (size <= GLCD_BLIT_MAX_SIZE) && (x >= 0) && (y >= 0) &&
+           ((x + 6 * size) <= _width) && ((y + 8 * size) <= _height)) {
+    // Expand the scaled glyph with its background and send it in one window,
+    // instead of one fillRect (address window) per font pixel
+    static uint32_t glyph[(6 * 8 * GLCD_BLIT_MAX_SIZE * GLCD_BLIT_MAX_SIZE + 2) / 2];
+    uint8_t  column[6];
+    uint16_t fg16 = (color >> 8) | (color << 8); // TFT byte order
+    uint16_t bg16 = (bg >> 8) | (bg << 8);
+    uint16_t *pix = (uint16_t*)glyph;
+    int32_t  w = 6 * size;
+
+    for (int8_t i = 0; i < 5; i++ ) column[i] = pgm_read_byte(font + (c * 5) + i);
+    column[5] = 0;
+
+    for (int8_t j = 0; j < 8; j++) {
+      uint16_t *line = pix;
+      for (int8_t i = 0; i < 6; i++) {
+        uint16_t pcol = (column[i] >> j) & 0x1 ? fg16 : bg16;
+        for (uint8_t k = 0; k < size; k++) *pix++ = pcol;
+      }
+      for (uint8_t k = 1; k < size; k++) {
+        memcpy(pix, line, w * 2);
+        pix += w;
+      }
+    }
+
+    bool swap = _swapBytes;
+    _swapBytes = false;
+    begin_tft_write();
+
+    setWindow(x, y, x + w - 1, y + 8 * size - 1);
+    pushPixels(glyph, w * 8 * size);
+
+    end_tft_write();
+    _swapBytes = swap;
+  }
   else {
     //begin_tft_write();          // Sprite class can use this function, avoiding begin_tft_write()
     inTransaction = true;
@@ -4228,6 +4267,8 @@ void TFT_eSPI::getSetup(setup_t &tft_settings)
 
 #include "Extensions/Sprite.cpp"
 
+#include "Extensions/DirtySprite.cpp"
+
 #ifdef SMOOTH_FONT
   #include "Extensions/Smooth_font.cpp"
 #endif
@@ -44,7 +44,9 @@
 #endif
 
 // Include the processor specific drivers
-#if defined (ESP32)
+#if defined (TFT_HOST)
+  #include "Processors/TFT_eSPI_Host.h"
+#elif defined (ESP32)
   #include "Processors/TFT_eSPI_ESP32.h"
 #elif defined (ESP8266)
   #include "Processors/TFT_eSPI_ESP8266.h"
@@ -61,6 +63,18 @@
   #define TAB_COLOUR 0
 #endif
 
+// Largest text size drawn by expanding the GLCD glyph in RAM and sending it in one window,
+// the buffer needs 96 * size * size bytes. Larger sizes use one fillRect per font pixel.
+#ifndef GLCD_BLIT_MAX_SIZE
+  #define GLCD_BLIT_MAX_SIZE 4
+#endif
+
+// Number of glyphs kept by the smooth font glyph cache (see setGlyphCache()), each entry takes 12 bytes
+// plus the glyph bitmap. The cache is only allocated when enabled by the sketch.
+#ifndef GLYPH_CACHE_ENTRIES
+  #define GLYPH_CACHE_ENTRIES 32
+#endif
+
 // If the SPI frequency is not defined, set a default
 #ifndef SPI_FREQUENCY
   #define SPI_FREQUENCY  20000000
@@ -575,7 +589,7 @@ class TFT_eSPI : public Print {
   uint32_t alphaBlend24(uint8_t alpha, uint32_t fgc, uint32_t bgc, uint8_t dither = 0);
 
 
-  // DMA support functions - these are currently just for SPI writes whe using the STM32 processors
+  // DMA support functions - these are currently just for SPI writes when using the STM32 and ESP32 processors
            // Bear in mind DMA will only be of benefit in particular circumstances and can be tricky
            // to manage by noobs. The functions have however been designed to be noob friendly and
            // avoid a few DMA behaviour "gotchas".
@@ -616,8 +630,11 @@ class TFT_eSPI : public Print {
 
            // Check if the DMA is complete - use while(tft.dmaBusy); for a blocking wait
   bool     dmaBusy(void);
+           // Wait for the DMA transfers in progress to complete (ESP32 only)
+  void     dmaWait(void);
 
   bool     DMA_Enabled = false; // Flag for DMA enabled state
+  uint8_t  spiBusyCheck = 0;   // Number of ESP32 DMA transactions queued and not yet collected
 
 
   // Bare metal functions
@@ -771,4 +788,7 @@ class TFT_eSPI : public Print {
 // Load the Sprite Class
 #include "Extensions/Sprite.h"
 
+// Load the Sprite Class that only pushes the changed tiles
+#include "Extensions/DirtySprite.h"
+
 #endif // ends #ifndef _TFT_eSPIH_
@@ -32,6 +32,10 @@
 // Tell the library to use 8 bit parallel mode (otherwise SPI is assumed)
 //#define TFT_PARALLEL_8_BIT
 
+// Host (PC) build only: decode the TFT traffic into a RAM framebuffer and count the
+// bytes sent instead of driving a display, see Processors/TFT_eSPI_Host.h
+//#define TFT_HOST
+
 // Display type -  only define if RPi display
 //#define RPI_DISPLAY_TYPE // 20MHz maximum SPI
 
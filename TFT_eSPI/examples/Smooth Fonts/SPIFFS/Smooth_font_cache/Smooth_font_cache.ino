@@ -0,0 +1,98 @@
+/*
+  Sketch to show the effect of the smooth font glyph cache on a frequently
+  redrawn readout.
+
+  The same frequency readout is drawn with no cache, with a cache of the
+  alpha values and with a cache of pixels pre-blended with the text colours.
+  Without a cache every character is read from the font file in SPIFFS,
+  with a cache it is read once and then taken from RAM. The time per readout
+  and the cache hit and miss counts are sent to the serial port.
+
+  Load the font file into SPIFFS first by using the Arduino IDE
+  Sketch Data Upload menu option. Font files must be stored in the
+  sketch data folder (Ctrl+k to view).
+  https://github.com/esp8266/arduino-esp8266fs-plugin
+  https://github.com/me-no-dev/arduino-esp32fs-plugin
+
+  Make sure all the display driver and pin connenctions are correct by
+  editting the User_Setup.h file in the TFT_eSPI library folder.
+
+  #########################################################################
+  ###### DON'T FORGET TO UPDATE THE User_Setup.h FILE IN THE LIBRARY ######
+  #########################################################################
+*/
+
+// Font file is stored in SPIFFS
+#define FS_NO_GLOBALS
+#include <FS.h>
+
+// Graphics and font library
+#include <TFT_eSPI.h>
+#include <SPI.h>
+
+TFT_eSPI tft = TFT_eSPI();  // Invoke library
+
+#define READOUTS 100
+
+// -------------------------------------------------------------------------
+// Setup
+// -------------------------------------------------------------------------
+void setup(void) {
+  Serial.begin(115200); // Used for messages
+
+  tft.init();
+  tft.setRotation(1);
+
+  if (!SPIFFS.begin()) {
+    Serial.println("SPIFFS initialisation failed!");
+    while (1) yield(); // Stay here twiddling thumbs waiting
+  }
+  Serial.println("\r\nInitialisation done.");
+}
+
+// -------------------------------------------------------------------------
+// Draw READOUTS frequencies with a glyph cache of cacheSize bytes
+// -------------------------------------------------------------------------
+void drawReadouts(uint32_t cacheSize, bool preBlend) {
+  tft.fillScreen(TFT_BLUE);
+  tft.setTextColor(TFT_WHITE, TFT_BLUE); // Background colour is used for anti-alias blending
+  tft.loadFont("NotoSansBold36");
+  tft.setGlyphCache(cacheSize, preBlend);
+
+  unsigned long drawTime = micros();
+
+  for (int i = 0; i < READOUTS; i++) {
+    char readout[16];
+    sprintf(readout, "14.%03d,%02d", 70 + i / 10, (i % 10) * 10);
+
+    tft.fillRect(0, 40, tft.width(), 40, TFT_BLUE);
+    tft.setCursor(10, 40);
+    tft.print(readout);
+    yield();
+  }
+
+  drawTime = micros() - drawTime;
+
+  Serial.print("Cache ");
+  Serial.print(cacheSize);
+  Serial.print(preBlend ? " bytes pre-blended: " : " bytes: ");
+  Serial.print(drawTime / READOUTS);
+  Serial.print(" us per readout, hits ");
+  Serial.print(tft.glyphCacheHits());
+  Serial.print(", misses ");
+  Serial.println(tft.glyphCacheMisses());
+
+  tft.setGlyphCache(0);
+  tft.unloadFont();
+}
+
+// -------------------------------------------------------------------------
+// Main loop
+// -------------------------------------------------------------------------
+void loop() {
+  drawReadouts(0, false);
+  drawReadouts(8192, false);
+  drawReadouts(16384, true);
+  Serial.println();
+  delay(4000);
+}
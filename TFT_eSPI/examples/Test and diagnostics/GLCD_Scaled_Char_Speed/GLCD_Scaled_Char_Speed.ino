@@ -0,0 +1,61 @@
+/*
+ Draw speed test of the built-in GLCD font (font 1) at text size 1 to 4.
+
+ Each size is drawn with a background colour, which uses the fast path that
+ expands the glyph in RAM and sends it in one window, and without a background
+ colour (transparent), which still draws one rectangle per font pixel.
+ The characters per second of each case are sent to the serial port.
+
+ Compare with GLCD_BLIT_MAX_SIZE set to 0 in TFT_eSPI.h to see the gain.
+
+ Make sure all the display driver and pin comnenctions are correct by
+ editting the User_Setup.h file in the TFT_eSPI library folder.
+
+ #########################################################################
+ ###### DON'T FORGET TO UPDATE THE User_Setup.h FILE IN THE LIBRARY ######
+ #########################################################################
+ */
+
+#include <TFT_eSPI.h> // Hardware-specific library
+#include <SPI.h>
+
+TFT_eSPI tft = TFT_eSPI();       // Invoke custom library
+
+#define CHARS 500
+
+void setup(void) {
+  Serial.begin(115200);
+  tft.init();
+  tft.setRotation(1);
+}
+
+void drawChars(uint8_t size, bool background) {
+  tft.fillScreen(TFT_BLUE);
+  tft.setTextSize(size);
+  if (background) tft.setTextColor(TFT_WHITE, TFT_BLUE);
+  else tft.setTextColor(TFT_WHITE);
+
+  unsigned long drawTime = micros();
+
+  for (int i = 0; i < CHARS; i++) {
+    tft.drawChar('0' + i % 10, (i % 6) * 6 * size, 0, 1);
+    if ((i & 31) == 0) yield();
+  }
+
+  drawTime = micros() - drawTime;
+
+  Serial.print("Size ");
+  Serial.print(size);
+  Serial.print(background ? " with background: " : " transparent:     ");
+  Serial.print(CHARS * 1000000.0 / drawTime, 0);
+  Serial.println(" characters per second");
+}
+
+void loop() {
+  for (uint8_t size = 1; size <= 4; size++) {
+    drawChars(size, true);
+    drawChars(size, false);
+  }
+  Serial.println();
+  delay(4000);
+}
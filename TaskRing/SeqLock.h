@@ -0,0 +1,84 @@
+/*
+  SeqLock.h		Sequence lock : one writer task publishes a structure, any number
+			of reader tasks copy a consistent snapshot of it.
+
+  The writer never waits for the readers. A reader copies the structure and
+  checks that the sequence number did not change meanwhile, otherwise (the
+  writer was writing) it copies it again. A snapshot is never torn i.e. never
+  mixes two writes, and comes with its version : the number of writes so far.
+
+  T is copied 32 bits at a time through relaxed std::atomic words, so that the
+  copy of a reader racing with the writer is defined behaviour (and clean for a
+  thread sanitizer). It must be a plain structure without constructor (no String).
+
+  On the ESP32 the scheduler of the writer's core is suspended during the write :
+  a reader task of higher priority on the same core cannot preempt the writer in
+  the middle of a write and then retry for ever. Readers on the other core retry
+  for at most the duration of a write. Do not read from an interrupt handler.
+*/
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#if defined (ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #define SEQLOCK_WRITE_BEGIN vTaskSuspendAll()
+  #define SEQLOCK_WRITE_END   xTaskResumeAll()
+#else
+  #define SEQLOCK_WRITE_BEGIN
+  #define SEQLOCK_WRITE_END
+#endif
+
+template <typename T>
+class SeqLock
+{
+  public:
+	SeqLock() : _seq(0) {
+		for (uint32_t i = 0; i < WORDS; i++) {_data[i].store(0, std::memory_order_relaxed);}
+	}
+
+	// Writer only : publishes a new value
+	void write(const T &value) {
+		uint32_t buffer[WORDS] = {0};
+		memcpy(buffer, &value, sizeof(T));
+		SEQLOCK_WRITE_BEGIN;
+		uint32_t seq = _seq.load(std::memory_order_relaxed);
+		_seq.store(seq + 1, std::memory_order_relaxed); // odd : write in progress
+		std::atomic_thread_fence(std::memory_order_release);
+		for (uint32_t i = 0; i < WORDS; i++) {_data[i].store(buffer[i], std::memory_order_relaxed);}
+		_seq.store(seq + 2, std::memory_order_release);
+		SEQLOCK_WRITE_END;
+	}
+
+	// Any task : copies the last published value, returns its version (0 if nothing was published)
+	uint32_t read(T &value) const {
+		uint32_t buffer[WORDS];
+		uint32_t seq;
+		for (;;) {
+			seq = _seq.load(std::memory_order_acquire);
+			if (seq & 1) {continue;} // being written
+			for (uint32_t i = 0; i < WORDS; i++) {buffer[i] = _data[i].load(std::memory_order_relaxed);}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_seq.load(std::memory_order_relaxed) == seq) {break;}
+		}
+		memcpy(&value, buffer, sizeof(T));
+		return seq / 2;
+	}
+
+	// Version of the last published value, without copying it
+	uint32_t version() const {
+		return _seq.load(std::memory_order_acquire) / 2;
+	}
+
+  private:
+	static const uint32_t WORDS = (sizeof(T) + 3) / 4;
+
+	std::atomic<uint32_t> _seq;         // 2 x number of writes, + 1 during a write
+	std::atomic<uint32_t> _data[WORDS];
+};
+
+#endif
@@ -0,0 +1,152 @@
+/*
+  TaskRing.h		Fixed capacity lock-free ring buffers to pass messages between
+			FreeRTOS tasks (or threads on a PC).
+
+  SpscRing<T, N> : one producer task and one consumer task.
+  MpscRing<T, N> : any number of producer tasks and one consumer task.
+
+  N is the capacity, a power of 2. T is copied in and out of the ring, it should
+  be a small structure without constructor (no String).
+
+  push() and pop() never block and never take a lock or a critical section : they
+  return false when the ring is full or empty and the caller decides what to do
+  (drop the message, retry later, notify the other task...). The indices are
+  std::atomic counters which wrap around, a slot is index & (N - 1).
+
+  The producer and consumer indices are on separate cache lines so that the two
+  cores do not invalidate each other's line at each message. The ESP32 internal
+  RAM is not cached, there the alignment only matters for PSRAM (32 bytes lines).
+  The over-aligned classes must be global or static variables : before C++17
+  new does not honour an alignment larger than the one of the heap.
+
+  MpscRing is the bounded queue of D. Vyukov with a sequence number per slot.
+  It is lock-free but not wait-free : a producer preempted between reserving a
+  slot and filling it delays the messages pushed after it (the consumer finds
+  the ring empty until the slot is filled), it never blocks the other producers.
+*/
+#ifndef TASKRING_H_
+#define TASKRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifndef TASKRING_CACHE_LINE
+  #if defined (ESP32)
+    #define TASKRING_CACHE_LINE 32
+  #else
+    #define TASKRING_CACHE_LINE 64
+  #endif
+#endif
+
+template <typename T, size_t N>
+class SpscRing
+{
+  static_assert((N >= 2) && ((N & (N - 1)) == 0), "the capacity of a ring must be a power of 2");
+
+  public:
+	SpscRing() : _head(0), _tailCache(0), _tail(0), _headCache(0) {}
+
+	// Producer only : copies item in the ring, returns false if it is full
+	bool push(const T &item) {
+		uint32_t head = _head.load(std::memory_order_relaxed);
+		if (head - _tailCache == N) {
+			_tailCache = _tail.load(std::memory_order_acquire);
+			if (head - _tailCache == N) {return false;}
+		}
+		_items[head & (N - 1)] = item;
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only : copies the oldest item out of the ring, returns false if it is empty
+	bool pop(T &item) {
+		uint32_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _headCache) {
+			_headCache = _head.load(std::memory_order_acquire);
+			if (tail == _headCache) {return false;}
+		}
+		item = _items[tail & (N - 1)];
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Number of items in the ring, already out of date when used by the other task
+	size_t size() const {
+		return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const {return N;}
+
+  private:
+	// written by the producer : its index and its copy of the consumer index
+	alignas(TASKRING_CACHE_LINE) std::atomic<uint32_t> _head;
+	uint32_t _tailCache;
+	// written by the consumer
+	alignas(TASKRING_CACHE_LINE) std::atomic<uint32_t> _tail;
+	uint32_t _headCache;
+	alignas(TASKRING_CACHE_LINE) T _items[N];
+};
+
+template <typename T, size_t N>
+class MpscRing
+{
+  static_assert((N >= 2) && ((N & (N - 1)) == 0), "the capacity of a ring must be a power of 2");
+
+  public:
+	MpscRing() : _head(0), _tail(0) {
+		for (uint32_t i = 0; i < N; i++) {_slots[i].seq.store(i, std::memory_order_relaxed);}
+	}
+
+	// Any producer : copies item in the ring, returns false if it is full. position, if given, is set to the
+	// position of the item in the ring : the items are popped in the order of their positions
+	bool push(const T &item, uint32_t *position = NULL) {
+		uint32_t head = _head.load(std::memory_order_relaxed);
+		Slot *slot;
+		for (;;) {
+			slot = &_slots[head & (N - 1)];
+			int32_t diff = (int32_t) (slot->seq.load(std::memory_order_acquire) - head);
+			if (diff == 0) { // the slot is free : reserve it
+				if (_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {break;}
+			}
+			else if (diff < 0) {return false;} // the slot still holds the item of the previous turn
+			else {head = _head.load(std::memory_order_relaxed);} // another producer took it
+		}
+		slot->item = item;
+		slot->seq.store(head + 1, std::memory_order_release);
+		if (position) {*position = head;}
+		return true;
+	}
+
+	// Consumer only : copies the oldest item out of the ring, returns false if it is empty. position, if given,
+	// is set to the position the item got when pushed
+	bool pop(T &item, uint32_t *position = NULL) {
+		uint32_t tail = _tail.load(std::memory_order_relaxed);
+		Slot *slot = &_slots[tail & (N - 1)];
+		if ((int32_t) (slot->seq.load(std::memory_order_acquire) - (tail + 1)) < 0) {return false;}
+		if (position) {*position = tail;}
+		item = slot->item;
+		slot->seq.store(tail + N, std::memory_order_release); // free for the next turn
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Number of items reserved by the producers and not popped yet, already out of date when used
+	size_t size() const {
+		return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const {return N;}
+
+  private:
+	struct Slot {
+		std::atomic<uint32_t> seq; // index + 1 when the item can be popped, index + N when the slot is free again
+		T item;
+	};
+
+	alignas(TASKRING_CACHE_LINE) std::atomic<uint32_t> _head; // shared by the producers
+	alignas(TASKRING_CACHE_LINE) std::atomic<uint32_t> _tail; // written by the consumer
+	alignas(TASKRING_CACHE_LINE) Slot _slots[N];
+};
+
+#endif
@@ -0,0 +1,142 @@
+/*
+  Stress test and throughput of the TaskRing ring buffers on an ESP32.
+
+  Producer tasks on core 0 push numbered messages, a consumer task on core 1
+  pops them and checks that none is lost, duplicated or out of order (the
+  messages of each producer must arrive in the order they were pushed). The
+  same traffic is then sent through a FreeRTOS queue, which copies the message
+  in a critical section, and through a ring protected by a mutex.
+
+  The results are sent to the serial port, e.g. the messages per second of :
+    SpscRing, 1 producer
+    MpscRing, 3 producers
+    FreeRTOS queue, 3 producers
+    mutex ring, 3 producers
+*/
+
+#include <TaskRing.h>
+
+#define MESSAGES 200000     // per test
+#define RING_SIZE 64
+#define MAX_PRODUCERS 3
+
+struct Message {
+  uint16_t producer;
+  uint32_t seq;
+};
+
+SpscRing<Message, RING_SIZE> spsc;
+MpscRing<Message, RING_SIZE> mpsc;
+QueueHandle_t rtosQueue;
+
+// Ring protected by a FreeRTOS mutex, for comparison
+SemaphoreHandle_t ringMutex;
+Message mutexItems[RING_SIZE];
+uint32_t mutexHead = 0, mutexTail = 0;
+
+enum {USE_SPSC, USE_MPSC, USE_RTOS_QUEUE, USE_MUTEX};
+const char *names[] = {"SpscRing", "MpscRing", "FreeRTOS queue", "mutex ring"};
+
+volatile int channel;
+volatile uint32_t perProducer;
+std::atomic<int> producersDone;
+
+bool pushMessage(const Message &m) {
+  switch (channel) {
+    case USE_SPSC: return spsc.push(m);
+    case USE_MPSC: return mpsc.push(m);
+    case USE_RTOS_QUEUE: return xQueueSend(rtosQueue, &m, 0) == pdTRUE;
+    default: {
+      xSemaphoreTake(ringMutex, portMAX_DELAY);
+      bool ok = (mutexHead - mutexTail) < RING_SIZE;
+      if (ok) {mutexItems[mutexHead++ % RING_SIZE] = m;}
+      xSemaphoreGive(ringMutex);
+      return ok;
+    }
+  }
+}
+
+bool popMessage(Message &m) {
+  switch (channel) {
+    case USE_SPSC: return spsc.pop(m);
+    case USE_MPSC: return mpsc.pop(m);
+    case USE_RTOS_QUEUE: return xQueueReceive(rtosQueue, &m, 0) == pdTRUE;
+    default: {
+      xSemaphoreTake(ringMutex, portMAX_DELAY);
+      bool ok = mutexHead != mutexTail;
+      if (ok) {m = mutexItems[mutexTail++ % RING_SIZE];}
+      xSemaphoreGive(ringMutex);
+      return ok;
+    }
+  }
+}
+
+void producerTask(void *param) {
+  Message m;
+  m.producer = (uintptr_t) param;
+  for (m.seq = 0; m.seq < perProducer; m.seq++) {
+    while (!pushMessage(m)) {taskYIELD();} // full : let the other producers run
+  }
+  producersDone++;
+  vTaskDelete(NULL);
+}
+
+// Runs one test from the consumer task, returns the messages per second or 0 if the check failed
+uint32_t runTest(int ch, int producers) {
+  channel = ch;
+  perProducer = MESSAGES / producers;
+  producersDone = 0;
+  uint32_t next[MAX_PRODUCERS] = {0};
+  uint32_t total = perProducer * producers, received = 0;
+  bool ok = true;
+
+  unsigned long start = micros();
+  for (int p = 0; p < producers; p++) {
+    xTaskCreatePinnedToCore(producerTask, "producer", 2048, (void*) (uintptr_t) p, 1, NULL, 0);
+  }
+  Message m;
+  while (received < total) {
+    if (!popMessage(m)) {continue;}
+    if (m.producer >= producers || m.seq != next[m.producer]) {ok = false;}
+    else {next[m.producer]++;}
+    received++;
+  }
+  unsigned long time = micros() - start;
+  while (producersDone < producers) {delay(1);}
+  if (popMessage(m)) {ok = false;} // a message too many
+
+  Serial.print(names[ch]);
+  Serial.print(", ");
+  Serial.print(producers);
+  Serial.print(producers > 1 ? " producers : " : " producer : ");
+  if (!ok) {Serial.println("ERROR, lost or misordered message"); return 0;}
+  uint32_t rate = (uint64_t) total * 1000000 / time;
+  Serial.print(rate);
+  Serial.println(" messages/s");
+  return rate;
+}
+
+void consumerTask(void *param) {
+  for (;;) {
+    runTest(USE_SPSC, 1);
+    runTest(USE_MPSC, 1);
+    runTest(USE_MPSC, MAX_PRODUCERS);
+    runTest(USE_RTOS_QUEUE, 1);
+    runTest(USE_RTOS_QUEUE, MAX_PRODUCERS);
+    runTest(USE_MUTEX, 1);
+    runTest(USE_MUTEX, MAX_PRODUCERS);
+    Serial.println();
+    delay(5000);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  rtosQueue = xQueueCreate(RING_SIZE, sizeof(Message));
+  ringMutex = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(consumerTask, "consumer", 4096, NULL, 1, NULL, 1);
+}
+
+void loop() {
+  vTaskDelete(NULL);
+}
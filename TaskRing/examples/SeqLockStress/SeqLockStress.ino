@@ -0,0 +1,69 @@
+/*
+  Stress test of SeqLock on an ESP32.
+
+  A writer task publishes as fast as it can a structure whose words all hold
+  the number of the write. Reader tasks on both cores read snapshots and check
+  that every word of a snapshot holds its version (a torn snapshot would mix
+  two writes) and that the versions never go back.
+
+  Every 5 s the numbers of writes, reads and errors are sent to the serial port.
+*/
+
+#include <SeqLock.h>
+
+#define WORDS 16
+#define READERS 2
+
+struct Sample {
+  uint32_t word[WORDS];
+};
+
+SeqLock<Sample> published;
+volatile uint32_t reads[READERS], errors[READERS];
+
+void writerTask(void *param) {
+  Sample s;
+  for (uint32_t n = 1; ; n++) {
+    for (int i = 0; i < WORDS; i++) {s.word[i] = n;}
+    published.write(s);
+    if ((n & 0xFF) == 0) {vTaskDelay(1);} // let the idle task run
+  }
+}
+
+void readerTask(void *param) {
+  int r = (uintptr_t) param;
+  uint32_t last = 0;
+  Sample s;
+  for (;;) {
+    uint32_t version = published.read(s);
+    bool ok = version >= last;
+    for (int i = 0; i < WORDS; i++) {ok = ok && (s.word[i] == version);}
+    if (!ok) {errors[r]++;}
+    last = version;
+    reads[r]++;
+    if ((reads[r] & 0xFF) == 0) {vTaskDelay(1);}
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  xTaskCreatePinnedToCore(writerTask, "writer", 2048, NULL, 1, NULL, 1);
+  for (int r = 0; r < READERS; r++) {
+    xTaskCreatePinnedToCore(readerTask, "reader", 2048, (void*) (uintptr_t) r, 1 + r, NULL, r); // one reader of higher priority than the writer, on its core
+  }
+}
+
+void loop() {
+  delay(5000);
+  Serial.print("Writes ");
+  Serial.print(published.version());
+  for (int r = 0; r < READERS; r++) {
+    Serial.print(", reader ");
+    Serial.print(r);
+    Serial.print(" reads ");
+    Serial.print(reads[r]);
+    Serial.print(" errors ");
+    Serial.print(errors[r]);
+  }
+  Serial.println();
+}
@@ -0,0 +1,136 @@
+/*
+  asset_bundle_test.cpp	AsyncBundle over the image built by tools/asset_bundle.py from
+			the assets of data/ : lookup of every url of the manifest, ETag
+			and 304, bodies sent straight from the image.
+
+  Usage : asset_bundle_test <directory of assets.bin and data/assets.txt>
+*/
+
+#include <ESPAsyncWebServer.h>
+#include <AsyncBundle.h>
+#include "esp_partition.h"
+#include "check.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+struct ManifestLine {
+	std::string logical, hashed, path, type;
+};
+
+static std::vector<ManifestLine> readManifest(const std::string &file) {
+	std::vector<ManifestLine> lines;
+	std::ifstream in(file);
+	ManifestLine l;
+	while (in >> l.logical >> l.hashed >> l.path >> l.type) {lines.push_back(l);}
+	return lines;
+}
+
+static std::string header(const std::string &response, const std::string &name) {
+	size_t start = response.find("\r\n" + name + ": ");
+	if (start == std::string::npos) {return "";}
+	start += name.size() + 4;
+	return response.substr(start, response.find("\r\n", start) - start);
+}
+
+static std::string body(const std::string &response) {
+	size_t end = response.find("\r\n\r\n");
+	return end == std::string::npos ? "" : response.substr(end + 4);
+}
+
+static std::string get(const std::string &url, const std::string &headers = "", size_t split = 1460) {
+	std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+	c->exchange("GET " + url + " HTTP/1.1\r\nHost: 192.168.4.1\r\nAccept-Encoding: gzip, deflate\r\n" + headers + "\r\n", split);
+	c->disconnect(); // Connection: close, the browser closes it
+	CHECK(c->client == NULL);
+	return c->sent;
+}
+
+int main(int argc, char **argv) {
+	std::string dir = argc > 1 ? argv[1] : "build";
+	std::ifstream in(dir + "/assets.bin", std::ios::binary);
+	std::vector<uint8_t> image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	std::vector<ManifestLine> manifest = readManifest(dir + "/data/assets.txt");
+	CHECK(image.size() > sizeof(AsyncBundleHeader));
+	CHECK(!manifest.empty());
+
+	// An image with a flipped bit is refused
+	std::vector<uint8_t> corrupt(image);
+	corrupt[corrupt.size() - 1] ^= 0x01;
+	AsyncBundle bundle;
+	CHECK(!bundle.begin(corrupt.data(), corrupt.size()));
+	CHECK(!bundle.valid());
+	CHECK(!bundle.begin("nothing"));
+
+	// Lookup : the logical and the hashed url of every asset, one blob for both
+	hostAddPartition(ASYNC_BUNDLE_PARTITION, image.data(), image.size());
+	CHECK(bundle.begin());
+	CHECK_EQUAL(bundle.count(), 2 * manifest.size());
+	for (const ManifestLine &l : manifest) {
+		const AsyncBundleEntry *logical = bundle.find(l.logical.c_str());
+		const AsyncBundleEntry *hashed = bundle.find(l.hashed.c_str());
+		CHECK(logical != NULL && hashed != NULL);
+		if (!logical || !hashed) {continue;}
+		CHECK_EQUAL(logical->offset, hashed->offset);
+		CHECK_EQUAL(std::string(hashed->type), l.type);
+		CHECK(hashed->flags & ASYNC_BUNDLE_IMMUTABLE);
+		CHECK(!(logical->flags & ASYNC_BUNDLE_IMMUTABLE));
+		CHECK_EQUAL((bool) (hashed->flags & ASYNC_BUNDLE_GZIP), l.path.size() > 3 && l.path.compare(l.path.size() - 3, 3, ".gz") == 0);
+		CHECK_EQUAL(AsyncBundle::crc32(bundle.data(hashed), hashed->length), hashed->crc);
+	}
+	CHECK(bundle.find("/nothing.js") == NULL);
+	CHECK(bundle.find("") == NULL);
+
+	AsyncWebServer server(80);
+	server.addHandler(new AsyncBundleWebHandler(bundle));
+	server.onNotFound([](AsyncWebServerRequest *request) {request->send(404);});
+	server.begin();
+
+	// Bodies : every byte added without copy from the blob in the image, through a small send window
+	AsyncClient::window = 1460;
+	for (const ManifestLine &l : manifest) {
+		const AsyncBundleEntry *e = bundle.find(l.hashed.c_str());
+		if (!e) {continue;}
+		std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+		c->exchange("GET " + l.hashed + " HTTP/1.1\r\nHost: 192.168.4.1\r\n\r\n", 13);
+		c->disconnect();
+		CHECK_EQUAL(c->sent.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+		CHECK_EQUAL(header(c->sent, "ETag"), String(e->crc, HEX).c_str());
+		CHECK_EQUAL(header(c->sent, "Content-Type"), l.type);
+		CHECK_EQUAL(header(c->sent, "Content-Length"), std::to_string(e->length));
+		CHECK_EQUAL(header(c->sent, "Cache-Control"), ASYNC_BUNDLE_CACHE_IMMUTABLE);
+		CHECK_EQUAL(header(c->sent, "Content-Encoding"), (e->flags & ASYNC_BUNDLE_GZIP) ? "gzip" : "");
+		CHECK(body(c->sent) == std::string((const char *) bundle.data(e), e->length));
+		size_t fromImage = 0;
+		for (const HostConnection::Segment &s : c->segments) {
+			if ((const uint8_t *) s.data >= image.data() && (const uint8_t *) s.data + s.len <= image.data() + image.size()) {
+				CHECK_EQUAL(s.flags, 0);
+				fromImage += s.len;
+			}
+		}
+		CHECK_EQUAL(fromImage, e->length);
+	}
+	AsyncClient::window = 5744;
+
+	// The logical url is revalidated
+	const ManifestLine &first = manifest.front();
+	std::string response = get(first.logical);
+	CHECK_EQUAL(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+	CHECK_EQUAL(header(response, "Cache-Control"), ASYNC_BUNDLE_CACHE_REVALIDATE);
+	std::string etag = header(response, "ETag");
+	CHECK(!etag.empty());
+
+	// ETag : 304 without body when it matches, the whole asset otherwise
+	response = get(first.logical, "If-None-Match: " + etag + "\r\n", 5);
+	CHECK_EQUAL(response.compare(0, 12, "HTTP/1.1 304"), 0);
+	CHECK_EQUAL(header(response, "ETag"), etag);
+	CHECK(body(response).empty());
+	response = get(first.logical, "If-None-Match: 0123abcd\r\n");
+	CHECK_EQUAL(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+	CHECK_EQUAL(body(response).size(), bundle.find(first.logical.c_str())->length);
+
+	// Not in the bundle
+	CHECK_EQUAL(get("/nothing.js").compare(0, 12, "HTTP/1.1 404"), 0);
+
+	return checkResult("asset_bundle_test");
+}
@@ -0,0 +1,172 @@
+/*
+  bench.cpp		Host benchmark of the hot paths of the sketch, built with the
+			compiler of the PC over the stubs : each path runs in timed loops
+			and its time per operation is written as JSON, to compare two
+			versions of the libraries.
+
+			request parsing      _parseReqHead / _parseReqHeader, a GET with the headers of a browser
+			template processing  _fillBufferAndProcessTemplates over data/index.html, as served by the sketch
+			WebSocket frames     AsyncWebSocketClient::_onData, masked text frames
+			CAT frames           FT857D::from_bcd_be / to_bcd_be, freqDigits() and formatFreq() (bench_cat.cpp)
+			screen               TFT_eSPI fillRect, drawChar and pushImage on the host panel (bench_tft.cpp)
+
+  The web paths go through the scripted TCP connections of the tests, a run includes
+  the connection and the response.
+
+  Usage : bench <output json> <data directory> [baseline json]
+	  with a baseline, the change of the best run of each path (less noisy than the median)
+	  is printed and the exit status is 1 if one is more than BENCH_THRESHOLD % slower
+
+	  make -C test bench [BASELINE=old.json]
+*/
+
+#include <ESPAsyncWebServer.h>
+#include <SPIFFS.h>
+#include "bench.h"
+#include <map>
+
+#define BENCH_THRESHOLD 10
+
+volatile uint32_t benchSink = 0;
+
+static const char *BROWSER_HEADERS =
+	"Host: 192.168.4.1\r\n"
+	"Connection: keep-alive\r\n"
+	"Cache-Control: max-age=0\r\n"
+	"Upgrade-Insecure-Requests: 1\r\n"
+	"User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+	"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+	"Referer: http://192.168.4.1/\r\n"
+	"Accept-Encoding: gzip, deflate\r\n"
+	"Accept-Language: fr-FR,fr;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+	"If-None-Match: \"5f3a1c2b\"\r\n";
+
+// Values of the placeholders of index.html, as the processor of the sketch gives them
+static String processor(const String &var) {
+	static const std::map<std::string, const char *> values = {
+		{"FREQ", "14.074,00 "}, {"MODE", "USB"}, {"VFO", "A"}, {"SMETER", "S9+10"}, {"RXTX", "RX"},
+		{"SPLIT", "   "}, {"CLAR", " "}, {"DBF", "DBF"}, {"DNF", "   "}, {"DNR", "DNR"}, {"KYR", "KYR"}, {"BK", "BK"}
+	};
+	std::map<std::string, const char *>::const_iterator v = values.find(var.c_str());
+	return v != values.end() ? String(v->second) : String();
+}
+
+static std::string get(const std::string &url, const std::string &headers) {
+	std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+	c->exchange("GET " + url + " HTTP/1.1\r\n" + headers + "\r\n");
+	c->disconnect();
+	return c->sent;
+}
+
+// Masked text frame of a client, len < 126
+static std::string wsFrame(const std::string &text) {
+	const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+	std::string frame;
+	frame += (char) 0x81;
+	frame += (char) (0x80 | text.size());
+	frame.append((const char *) mask, 4);
+	for (size_t i = 0; i < text.size(); i++) {frame += (char) (text[i] ^ mask[i & 3]);}
+	return frame;
+}
+
+static void writeJson(const Bench &bench, const std::string &file) {
+	FILE *f = fopen(file.c_str(), "w");
+	if (!f) {perror(file.c_str()); exit(1);}
+	fprintf(f, "{\n  \"unit\": \"ns\",\n  \"paths\": [\n");
+	for (size_t i = 0; i < bench.results.size(); i++) {
+		const BenchResult &r = bench.results[i];
+		fprintf(f, "    {\"path\": \"%s\", \"ops\": %llu, \"ns_per_op\": %.1f, \"min_ns_per_op\": %.1f}%s\n", r.path.c_str(),
+		        (unsigned long long) r.ops, r.nsPerOp, r.minNsPerOp, i + 1 < bench.results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	fclose(f);
+}
+
+// Best time of each path of a JSON file written by writeJson()
+static std::map<std::string, double> readJson(const std::string &file) {
+	std::map<std::string, double> paths;
+	FILE *f = fopen(file.c_str(), "r");
+	if (!f) {perror(file.c_str()); exit(1);}
+	char line[512], path[256];
+	double ns;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, " {\"path\": \"%255[^\"]\", \"ops\": %*u, \"ns_per_op\": %*f, \"min_ns_per_op\": %lf", path, &ns) == 2) {
+			paths[path] = ns;
+		}
+	}
+	fclose(f);
+	return paths;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3) {
+		fprintf(stderr, "Usage : bench <output json> <data directory> [baseline json]\n");
+		return 2;
+	}
+	Bench bench;
+	benchCat(bench);
+	benchTft(bench);
+
+	// Web server with the routes of the sketch which are benchmarked
+	SPIFFS.setRoot(argv[2]);
+	AsyncWebServer server(80);
+	AsyncWebSocket *ws = new AsyncWebSocket("/ws"); // deleted by the server
+	uint32_t wsFrames = 0;
+	ws->onEvent([&wsFrames](AsyncWebSocket *, AsyncWebSocketClient *, AwsEventType type, void *, uint8_t *data, size_t len) {
+		if (type == WS_EVT_DATA) {wsFrames++; benchSink += data[len - 1];}
+	});
+	server.addHandler(ws);
+	server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+		AsyncWebServerResponse *response = request->beginResponse(SPIFFS, "/index.html", String(), false, processor);
+		response->addHeader("Cache-Control", "no-cache");
+		request->send(response);
+	});
+	server.on("/link", HTTP_GET, [](AsyncWebServerRequest *request) {
+		request->send(200, "text/plain", "1");
+	});
+	server.begin();
+
+	// Each path is checked once before it is timed
+	std::string response = get("/link", BROWSER_HEADERS);
+	if (response.compare(0, 15, "HTTP/1.1 200 OK") != 0) {fprintf(stderr, "GET /link : %s\n", response.c_str()); return 1;}
+	response = get("/", BROWSER_HEADERS);
+	if (response.compare(0, 15, "HTTP/1.1 200 OK") != 0 || response.find("14.074,00 ") == std::string::npos) {
+		fprintf(stderr, "GET / : the page is not processed\n");
+		return 1;
+	}
+	bench.run("request GET /link, browser headers", [] {
+		benchSink += get("/link", BROWSER_HEADERS).size();
+	});
+	bench.run("template index.html", [] {
+		benchSink += get("/", BROWSER_HEADERS).size();
+	});
+
+	std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+	c->exchange("GET /ws HTTP/1.1\r\nHost: 192.168.4.1\r\nConnection: Upgrade\r\nUpgrade: websocket\r\n"
+	            "Sec-WebSocket-Version: 13\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n");
+	if (c->sent.compare(0, 12, "HTTP/1.1 101") != 0) {fprintf(stderr, "GET /ws : %s\n", c->sent.c_str()); return 1;}
+	std::string frames = wsFrame("{\"freq\":\"14.074,00 \",\"mode\":\"USB\"}") + wsFrame("updatefrequency?delta=-10")
+	                     + wsFrame(std::string(120, 'x')) + wsFrame("1");
+	c->receive(frames);
+	if (wsFrames != 4) {fprintf(stderr, "WebSocket : %u frames received of 4\n", wsFrames); return 1;}
+	bench.run("WebSocket 4 masked text frames", [&] {
+		c->receive(frames);
+	});
+	if (wsFrames % 4 != 0 || c->closed) {fprintf(stderr, "WebSocket : frames lost\n"); return 1;}
+	c->disconnect();
+
+	writeJson(bench, argv[1]);
+	printf("%s written\n", argv[1]);
+
+	if (argc < 4) {return 0;}
+	std::map<std::string, double> baseline = readJson(argv[3]);
+	int slower = 0;
+	for (const BenchResult &r : bench.results) {
+		std::map<std::string, double>::const_iterator b = baseline.find(r.path);
+		if (b == baseline.end() || b->second <= 0) {continue;}
+		double change = (r.minNsPerOp - b->second) * 100 / b->second;
+		printf("%-40s %+7.1f %%%s\n", r.path.c_str(), change, change > BENCH_THRESHOLD ? "  slower" : "");
+		if (change > BENCH_THRESHOLD) {slower++;}
+	}
+	return slower ? 1 : 0;
+}
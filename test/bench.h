@@ -0,0 +1,60 @@
+/*
+  bench.h		Timed loops of the host benchmark (bench.cpp) : each path is run in
+			batches long enough to be timed, BENCH_RUNS times, and its median
+			time per operation is kept.
+*/
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define BENCH_RUNS 7
+#define BENCH_RUN_NS 50000000ULL    // 50 ms, at least, per run
+
+struct BenchResult {
+	std::string path;
+	uint64_t ops;       // operations of a run
+	double nsPerOp;     // median of the runs
+	double minNsPerOp;
+};
+
+// Keeps a result alive so that the compiler does not remove the work of a loop
+extern volatile uint32_t benchSink;
+
+class Bench
+{
+  public:
+	// Runs op() in timed loops and records its time per call under the name of the path
+	template <typename Op>
+	void run(const char *path, Op op) {
+		uint64_t ops = 1;
+		while (time(op, ops) < BENCH_RUN_NS / 10 && ops < (1ULL << 40)) {ops *= 2;} // warm up and calibrate
+		uint64_t t = time(op, ops);
+		ops = std::max<uint64_t>(ops, ops * BENCH_RUN_NS / std::max<uint64_t>(t, 1));
+		std::vector<double> runs;
+		for (int r = 0; r < BENCH_RUNS; r++) {runs.push_back((double) time(op, ops) / ops);}
+		std::sort(runs.begin(), runs.end());
+		results.push_back({path, ops, runs[BENCH_RUNS / 2], runs[0]});
+		printf("%-40s %12.1f ns/op\n", path, runs[BENCH_RUNS / 2]);
+	}
+
+	std::vector<BenchResult> results;
+
+  private:
+	template <typename Op>
+	static uint64_t time(Op &op, uint64_t ops) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < ops; i++) {op();}
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	}
+};
+
+// Paths of the libraries built with their own flags
+void benchCat(Bench &bench);     // bench_cat.cpp : FT857D BCD conversions, frequency formatting
+void benchTft(Bench &bench);     // bench_tft.cpp : TFT_eSPI on the host panel emulator
+
+#endif
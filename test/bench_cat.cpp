@@ -0,0 +1,32 @@
+/*
+  bench_cat.cpp		Host benchmark of the CAT frames and of the frequency readout :
+			FT857D::from_bcd_be / to_bcd_be, freqDigits() and formatFreq().
+*/
+
+#include <FT857D-ESP32.h>
+#include <FreqFormat.h>
+#include "bench.h"
+
+void benchCat(Bench &bench) {
+	// frequencies of the bands, 160 m to 70 cm, in 10 Hz
+	static const unsigned long freqs[8] = {183000, 707400, 1407400, 2107400, 2807400, 5031300, 14480000, 43250000};
+	byte frames[8][4];
+	for (int i = 0; i < 8; i++) {FT857D::to_bcd_be(frames[i], freqs[i], 8);}
+	uint32_t i = 0;
+
+	bench.run("FT857D::from_bcd_be", [&] {
+		benchSink += FT857D::from_bcd_be(frames[i++ & 7], 8);
+	});
+	bench.run("FT857D::to_bcd_be", [&] {
+		byte bcd[4];
+		FT857D::to_bcd_be(bcd, freqs[i++ & 7], 8);
+		benchSink += bcd[3];
+	});
+	bench.run("freqDigits", [&] {
+		char digits[12];
+		benchSink += freqDigits(freqs[i++ & 7], digits) + digits[7];
+	});
+	bench.run("formatFreq", [&] {
+		benchSink += formatFreq(freqs[i++ & 7]).length();
+	});
+}
@@ -0,0 +1,34 @@
+/*
+  bench_tft.cpp		Host benchmark of the drawing of the TTGO screen : TFT_eSPI fillRect,
+			drawChar and the image blit of a digit of the frequency readout on
+			the host panel emulator (TFT_HOST), which counts the bytes sent.
+*/
+
+#include <TFT_eSPI.h>
+#include "bench.h"
+
+void benchTft(Bench &bench) {
+	static TFT_eSPI tft = TFT_eSPI(135, 240);
+	tft.init();
+	tft.setRotation(1);
+	tft.fillScreen(TFT_BLUE);
+	static uint16_t glyph[17 * 25];
+	for (int p = 0; p < 17 * 25; p++) {glyph[p] = p & 1 ? TFT_WHITE : TFT_BLUE;}
+	uint32_t i = 0;
+
+	bench.run("TFT_eSPI::fillRect 55x25", [&] {
+		tft.fillRect(100 + (i++ & 7), 35, 55, 25, TFT_BLUE);
+	});
+	bench.run("TFT_eSPI::drawChar size 3", [&] {
+		tft.drawChar(5 + 17 * (i & 7), 75, '0' + (i % 10), TFT_WHITE, TFT_BLUE, 3);
+		i++;
+	});
+	bench.run("TFT_eSPI::drawChar size 2 transparent", [&] {
+		tft.drawChar(5 + 12 * (i & 7), 110, 'A' + (i % 26), TFT_YELLOW, TFT_YELLOW, 2);
+		i++;
+	});
+	bench.run("TFT_eSPI::pushImage 17x25 glyph", [&] {
+		tft.pushImage(5 + 17 * (i++ & 7), 75, 17, 25, glyph);
+	});
+	benchSink += tftHost.bytes;
+}
@@ -0,0 +1,29 @@
+/*
+  check.h		Checks of the host tests : a failed check prints its line and the
+			test goes on, the exit status is the number of failed checks.
+*/
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+		if (!(condition)) {fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); checkFailures++;} \
+	} while (0)
+
+#define CHECK_EQUAL(actual, expected) do { \
+		if (!((actual) == (expected))) { \
+			fprintf(stderr, "%s:%d: check failed: %s == %s\n", __FILE__, __LINE__, #actual, #expected); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+// Last line of main()
+inline int checkResult(const char *test) {
+	printf("%s: %s\n", test, checkFailures ? "FAILED" : "passed");
+	return checkFailures > 255 ? 255 : checkFailures;
+}
+
+#endif
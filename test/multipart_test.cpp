@@ -0,0 +1,160 @@
+/*
+  multipart_test.cpp	Multipart POST bodies received in TCP segments of random sizes,
+			the closing delimiter of the file cut at every position : the
+			file passed to the upload handler is the file sent, in order,
+			then the request handler runs once with the text fields.
+*/
+
+#include <ESPAsyncWebServer.h>
+#include "check.h"
+#include <random>
+#include <string>
+#include <vector>
+
+static const char *BOUNDARY = "----WebKitFormBoundaryq8Ba7cZ2xR1mE0pQ";
+
+struct Call {
+	bool upload;        // handleUpload, else the request handler
+	std::string filename;
+	size_t index, len;
+	bool final;
+};
+
+static std::vector<Call> calls;
+static std::string received;
+static std::string fieldBefore, fieldAfter;
+
+// Bytes which look like the start of the delimiter, up to the boundary less its last character
+static std::string trickyFile(std::mt19937 &random, size_t size) {
+	std::string delimiter = std::string("\r\n--") + BOUNDARY;
+	std::string file;
+	while (file.size() < size) {
+		switch (random() % 6) {
+		case 0: file += delimiter.substr(0, 1 + random() % (delimiter.size() - 1)); break;
+		case 1: file += "\r\n-"; break;
+		case 2: file += '\r'; break;
+		default: file += (char) random(); break;
+		}
+	}
+	file.resize(size);
+	size_t at;
+	while ((at = file.find(delimiter)) != std::string::npos) {file[at + delimiter.size() - 1] ^= 0x20;} // not in a valid body
+	return file;
+}
+
+static std::string multipartBody(const std::string &file) {
+	std::string b = BOUNDARY;
+	return "--" + b + "\r\n"
+	       "Content-Disposition: form-data; name=\"before\"\r\n\r\n"
+	       "73 de F6CZV\r\n"
+	       "--" + b + "\r\n"
+	       "Content-Disposition: form-data; name=\"data\"; filename=\"memories.bin\"\r\n"
+	       "Content-Type: application/octet-stream\r\n\r\n" + file + "\r\n"
+	       "--" + b + "\r\n"
+	       "Content-Disposition: form-data; name=\"after\"\r\n\r\n"
+	       "FT-857D\r\n"
+	       "--" + b + "--\r\n";
+}
+
+static std::string request(const std::string &body) {
+	return "POST /upload HTTP/1.1\r\n"
+	       "Host: 192.168.4.1\r\n"
+	       "Content-Type: multipart/form-data; boundary=" + std::string(BOUNDARY) + "\r\n"
+	       "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+// Sends data cut at the given positions and checks what the handlers got
+static void upload(const std::string &file, const std::string &data, const std::vector<size_t> &cuts, const char *what) {
+	calls.clear();
+	received.clear();
+	fieldBefore = fieldAfter = "";
+	std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+	size_t from = 0;
+	for (size_t cut : cuts) {
+		if (cut > from && cut < data.size()) {
+			c->receive(data.substr(from, cut - from));
+			from = cut;
+		}
+	}
+	c->receive(data.substr(from));
+	c->exchange("");
+	c->disconnect();
+
+	int failures = checkFailures;
+	CHECK(received == file);
+	CHECK(!calls.empty() && !calls.back().upload);
+	size_t next = 0, finals = 0, requests = 0;
+	for (size_t i = 0; i < calls.size(); i++) {
+		const Call &call = calls[i];
+		if (!call.upload) {requests++; continue;}
+		CHECK(requests == 0); // every part of the file before the request handler
+		CHECK_EQUAL(call.filename, "memories.bin");
+		CHECK_EQUAL(call.index, next);
+		CHECK(call.len > 0 || call.final);
+		next += call.len;
+		if (call.final) {
+			finals++;
+			CHECK(i + 1 < calls.size() && !calls[i + 1].upload); // the last part
+		}
+	}
+	CHECK_EQUAL(finals, 1u);
+	CHECK_EQUAL(requests, 1u);
+	CHECK_EQUAL(fieldBefore, "73 de F6CZV");
+	CHECK_EQUAL(fieldAfter, "FT-857D");
+	CHECK_EQUAL(c->sent.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+	if (checkFailures != failures) {fprintf(stderr, "  in %s, %u segments\n", what, (unsigned) cuts.size() + 1);}
+}
+
+int main() {
+	AsyncWebServer server(80);
+	server.on("/upload", HTTP_POST, [](AsyncWebServerRequest *request) {
+		calls.push_back({false, "", 0, 0, false});
+		if (request->hasParam("before", true)) {fieldBefore = request->getParam("before", true)->value().c_str();}
+		if (request->hasParam("after", true)) {fieldAfter = request->getParam("after", true)->value().c_str();}
+		request->send(200, "text/plain", "OK");
+	}, [](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
+		(void) request;
+		calls.push_back({true, filename.c_str(), index, len, final});
+		received.append((const char *) data, len);
+	});
+	server.begin();
+
+	std::mt19937 random(1);
+	for (size_t size : {1, 2, 37, 1459, 1460, 1461, 4096, 20000}) {
+		std::string file = trickyFile(random, size);
+		std::string data = request(multipartBody(file));
+
+		// one segment, then segments of random sizes, from one byte to a full TCP segment
+		upload(file, data, {}, "one segment");
+		for (int run = 0; run < 40; run++) {
+			std::vector<size_t> cuts;
+			size_t max = run % 4 == 0 ? 8 : 1460;
+			for (size_t at = 1 + random() % max; at < data.size(); at += 1 + random() % max) {cuts.push_back(at);}
+			upload(file, data, cuts, "random segments");
+		}
+
+		// the delimiter after the file ("\r\n--" boundary "\r\n") cut at each of its bytes, and byte by byte
+		size_t end = data.find(std::string("\r\n--") + BOUNDARY + "\r\nContent-Disposition: form-data; name=\"after\"");
+		CHECK(end != std::string::npos);
+		for (size_t at = end; at <= end + 6 + strlen(BOUNDARY); at++) {
+			upload(file, data, {at}, "delimiter cut");
+			upload(file, data, {end - 1, at}, "delimiter cut after the file");
+		}
+		std::vector<size_t> bytes;
+		for (size_t at = end - 8; at < end + 48; at++) {bytes.push_back(at);}
+		upload(file, data, bytes, "delimiter byte by byte");
+	}
+
+	// A boundary inside the file followed by other bytes than "--" or CRLF, a malformed body : the file ends at
+	// the boundary and the rest of the body is ignored
+	std::string file = "abc\r\n--" + std::string(BOUNDARY) + "xyz";
+	calls.clear();
+	received.clear();
+	std::shared_ptr<HostConnection> c = AsyncServer::running->connect();
+	c->exchange(request(multipartBody(file)), 16);
+	c->disconnect();
+	CHECK(received == "abc");
+	CHECK(calls.size() >= 2 && !calls.back().upload && calls[calls.size() - 2].final);
+
+	return checkResult("multipart_test");
+}
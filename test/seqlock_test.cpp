@@ -0,0 +1,85 @@
+/*
+  seqlock_test.cpp	SeqLock between threads : one writer publishes structures whose
+			words all hold the number of the write, the readers never get a
+			torn snapshot (two different words) and its version is the
+			number of the write, never going back.
+
+  Built without ESP32 : the write does not suspend a scheduler. The structure is
+  large so that the threads are preempted in the middle of a copy, even on a
+  single core.
+*/
+
+#include <SeqLock.h>
+#include "check.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define WORDS 1024
+#define READERS 3
+
+struct Snapshot {
+	uint32_t words[WORDS];
+};
+
+static SeqLock<Snapshot> lock;
+static std::atomic<bool> done(false);
+
+struct ReaderResult {
+	uint32_t reads = 0, torn = 0, wrongVersion = 0, backwards = 0, changed = 0;
+};
+
+static void reader(ReaderResult &r) {
+	Snapshot *snapshot = new Snapshot;
+	uint32_t last = 0;
+	while (!done) {
+		uint32_t version = lock.read(*snapshot);
+		r.reads++;
+		uint32_t first = snapshot->words[0];
+		for (uint32_t i = 1; i < WORDS; i++) {
+			if (snapshot->words[i] != first) {r.torn++; break;}
+		}
+		if (first != version) {r.wrongVersion++;}
+		if (version < last) {r.backwards++;}
+		if (version != last) {r.changed++;}
+		last = version;
+	}
+	delete snapshot;
+}
+
+int main() {
+	Snapshot value;
+	CHECK_EQUAL(lock.read(value), 0u);
+	CHECK_EQUAL(value.words[0], 0u);
+
+	std::vector<ReaderResult> results(READERS);
+	std::vector<std::thread> readers;
+	for (uint32_t i = 0; i < READERS; i++) {readers.emplace_back(reader, std::ref(results[i]));}
+
+	// The writer never waits : it writes version n with every word equal to n, for a second
+	uint32_t writes = 0;
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (std::chrono::steady_clock::now() < end) {
+		writes++;
+		for (uint32_t i = 0; i < WORDS; i++) {value.words[i] = writes;}
+		lock.write(value);
+		if (writes % 64 == 0) {std::this_thread::yield();}
+	}
+	done = true;
+	for (std::thread &t : readers) {t.join();}
+
+	CHECK_EQUAL(lock.version(), writes);
+	CHECK_EQUAL(lock.read(value), writes);
+	CHECK_EQUAL(value.words[WORDS - 1], writes);
+	for (const ReaderResult &r : results) {
+		CHECK(r.reads > 0);
+		CHECK(r.changed > 1); // the readers ran during the writes
+		CHECK_EQUAL(r.torn, 0u);
+		CHECK_EQUAL(r.wrongVersion, 0u);
+		CHECK_EQUAL(r.backwards, 0u);
+	}
+	printf("seqlock_test: %u writes, %u reads\n", writes, results[0].reads);
+
+	return checkResult("seqlock_test");
+}
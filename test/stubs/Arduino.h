@@ -0,0 +1,107 @@
+/*
+  Arduino.h		Minimal Arduino API to build the libraries of the sketch on a PC
+			for the host tests and benchmarks (see test/Makefile).
+
+  Only what the libraries use is provided. The time functions run on the
+  steady clock of the PC, the FreeRTOS primitives on std::mutex.
+*/
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+#include <functional>
+#include <algorithm>
+
+#include "WString.h"
+#include "Stream.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+#define pgm_read_word(addr) (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t *) (addr))
+#define pgm_read_float(addr) (*(const float *) (addr))
+#define pgm_read_pointer(addr) (*(void * const *) (addr))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+#define vsnprintf_P vsnprintf
+#define ets_printf printf
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define INPUT_PULLUP 0x05
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+template <typename A, typename B> inline auto min(const A &a, const B &b) -> decltype(a < b ? a : b) {return b < a ? b : a;}
+template <typename A, typename B> inline auto max(const A &a, const B &b) -> decltype(a < b ? a : b) {return a < b ? b : a;}
+#define _min(a, b) ((a) < (b) ? (a) : (b))
+#define _max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+// Host : moves the clock of millis() and micros() forward, for the timeouts
+void hostAdvanceMillis(uint32_t ms);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) {return 0;}
+inline uint32_t digitalPinToBitMask(uint8_t pin) {return 1UL << (pin & 31);}
+
+char *ltoa(long value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+char *itoa(int value, char *str, int base);
+
+long random(long max);
+long random(long min, long max);
+extern "C" uint32_t esp_random();
+
+// Serial port : what is printed goes to stdout when hostSerialEcho is true. The other ports (the CAT link) are
+// not connected : nothing is received.
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8N2 0x800003c
+
+class HardwareSerial: public Stream
+{
+  public:
+	HardwareSerial() {}
+	explicit HardwareSerial(int) {}
+	void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+	size_t write(uint8_t c) override;
+	using Print::write;
+	int available() override {return 0;}
+	int read() override {return -1;}
+	int peek() override {return -1;}
+};
+extern HardwareSerial Serial;
+extern bool hostSerialEcho;
+
+#endif
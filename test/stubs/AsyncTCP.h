@@ -0,0 +1,145 @@
+/*
+  AsyncTCP.h		Scripted TCP connections for the host tests of ESPAsyncWebServer.
+
+  There is no socket : a test opens a connection on the server started last
+  (AsyncServer::running), gives it the bytes of the browser with receive() and
+  acknowledges what the server sent with acknowledge(). The bytes sent by the
+  server and the state of the connection are kept in a HostConnection owned by
+  the test, which outlives the AsyncClient deleted by the server on disconnect.
+
+  add() copies nothing : the pointers given by the server are kept with their
+  length until send(), so that a test can check a zero-copy body (flag 0).
+*/
+#ifndef ASYNCTCP_H_
+#define ASYNCTCP_H_
+
+#include <Arduino.h>
+#include <IPAddress.h>
+#include "freertos/semphr.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+#define ASYNC_WRITE_FLAG_COPY 0x01
+#define ASYNC_WRITE_FLAG_MORE 0x02
+
+class AsyncClient;
+
+typedef std::function<void(void *, AsyncClient *)> AcConnectHandler;
+typedef std::function<void(void *, AsyncClient *, size_t len, uint32_t time)> AcAckHandler;
+typedef std::function<void(void *, AsyncClient *, int8_t error)> AcErrorHandler;
+typedef std::function<void(void *, AsyncClient *, void *data, size_t len)> AcDataHandler;
+typedef std::function<void(void *, AsyncClient *, uint32_t time)> AcTimeoutHandler;
+
+// Test side of a connection
+struct HostConnection {
+	struct Segment {
+		const char *data;   // pointer given to add()
+		size_t len;
+		uint8_t flags;
+	};
+	std::string sent;               // bytes sent by the server, in order
+	std::vector<Segment> segments;  // every add() of the server
+	size_t unacked = 0;             // bytes sent and not acknowledged yet
+	bool closed = false;
+	AsyncClient *client = NULL;     // NULL once the server deleted it
+
+	// Gives data to the server, as one TCP segment
+	void receive(const char *data, size_t len);
+	void receive(const std::string &data) {receive(data.data(), data.size());}
+	// Acknowledges all the bytes sent, returns false if there was nothing to acknowledge
+	bool acknowledge();
+	// Sends the data in segments of split bytes, then acknowledges until the server sends nothing more. The
+	// server does not close after a response with Connection: close, the browser does : disconnect()
+	void exchange(const std::string &data, size_t split = 1460);
+	// The browser closes the connection
+	void disconnect();
+};
+
+class AsyncClient
+{
+  public:
+	static size_t window;   // send window of every connection
+
+	explicit AsyncClient(std::shared_ptr<HostConnection> peer);
+	~AsyncClient();
+
+	bool connected() {return !_peer->closed;}
+	bool disconnecting() {return false;}
+	bool freeable() {return _peer->closed;}
+	bool canSend() {return space() > 0;}
+	size_t space() {return connected() && _peer->unacked + _pending < window ? window - _peer->unacked - _pending : 0;}
+	size_t add(const char *data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+	bool send();
+	size_t write(const char *data) {return data ? write(data, strlen(data)) : 0;}
+	size_t write(const char *data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY) {
+		size_t n = add(data, size, apiflags);
+		return n && send() ? n : 0;
+	}
+	void close(bool now = false);
+	void stop() {close(false);}
+	int8_t abort() {close(true); return -13;}
+	bool free() {return _peer->closed;}
+	void ackLater() {}
+	size_t ack(size_t len) {return len;}
+	void setRxTimeout(uint32_t timeout) {_rxTimeout = timeout;}
+	uint32_t getRxTimeout() {return _rxTimeout;}
+	void setAckTimeout(uint32_t) {}
+	void setNoDelay(bool) {}
+	bool getNoDelay() {return true;}
+	uint8_t state() {return connected() ? 4 : 0;}
+	const char *stateToString() {return connected() ? "Established" : "Closed";}
+	const char *errorToString(int8_t) {return "Unknown error";}
+	IPAddress remoteIP() {return IPAddress(192, 168, 4, 2);}
+	uint16_t remotePort() {return 50000;}
+	IPAddress localIP() {return IPAddress(192, 168, 4, 1);}
+	uint16_t localPort() {return 80;}
+
+	void onConnect(AcConnectHandler cb, void *arg = 0) {_connect = cb; _connectArg = arg;}
+	void onDisconnect(AcConnectHandler cb, void *arg = 0) {_discard = cb; _discardArg = arg;}
+	void onAck(AcAckHandler cb, void *arg = 0) {_ack = cb; _ackArg = arg;}
+	void onError(AcErrorHandler cb, void *arg = 0) {_error = cb; _errorArg = arg;}
+	void onData(AcDataHandler cb, void *arg = 0) {_data = cb; _dataArg = arg;}
+	void onTimeout(AcTimeoutHandler cb, void *arg = 0) {_timeout = cb; _timeoutArg = arg;}
+	void onPoll(AcConnectHandler cb, void *arg = 0) {_poll = cb; _pollArg = arg;}
+
+  private:
+	friend struct HostConnection;
+
+	std::shared_ptr<HostConnection> _peer;
+	size_t _pending;        // added and not sent yet
+	size_t _firstPending;   // index of the first segment not sent yet
+	uint32_t _rxTimeout;
+	AcConnectHandler _connect, _discard, _poll;
+	AcAckHandler _ack;
+	AcErrorHandler _error;
+	AcDataHandler _data;
+	AcTimeoutHandler _timeout;
+	void *_connectArg = NULL, *_discardArg = NULL, *_pollArg = NULL, *_ackArg = NULL, *_errorArg = NULL;
+	void *_dataArg = NULL, *_timeoutArg = NULL;
+};
+
+class AsyncServer
+{
+  public:
+	static AsyncServer *running;    // server of the last begin()
+
+	explicit AsyncServer(uint16_t port) : _port(port), _client(NULL), _clientArg(NULL) {}
+	~AsyncServer() {end();}
+	void onClient(AcConnectHandler cb, void *arg) {_client = cb; _clientArg = arg;}
+	void begin() {running = this;}
+	void end() {if (running == this) {running = NULL;}}
+	void setNoDelay(bool) {}
+	bool getNoDelay() {return true;}
+	uint8_t status() {return running == this ? 1 : 0;}
+
+	// A browser opens a connection
+	std::shared_ptr<HostConnection> connect();
+
+  private:
+	uint16_t _port;
+	AcConnectHandler _client;
+	void *_clientArg;
+};
+
+#endif
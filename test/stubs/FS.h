@@ -0,0 +1,92 @@
+/*
+  FS.h			Arduino file system for the host tests : a directory of the PC.
+			A File is shared by its copies, as on the ESP32.
+*/
+#ifndef FS_H_
+#define FS_H_
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode {SeekSet = 0, SeekCur = 1, SeekEnd = 2};
+
+class File: public Stream
+{
+  public:
+	File() {}
+	File(FILE *f, const String &name) : _f(f, fclose), _name(name) {}
+
+	size_t write(uint8_t c) override {return _f ? fwrite(&c, 1, 1, _f.get()) : 0;}
+	size_t write(const uint8_t *buf, size_t size) override {return _f ? fwrite(buf, 1, size, _f.get()) : 0;}
+	using Print::write;
+	int available() override {return _f ? size() - position() : 0;}
+	int read() override {return _f ? fgetc(_f.get()) : -1;}
+	int peek() override {
+		if (!_f) {return -1;}
+		int c = fgetc(_f.get());
+		if (c >= 0) {ungetc(c, _f.get());}
+		return c;
+	}
+	void flush() override {if (_f) {fflush(_f.get());}}
+	size_t read(uint8_t *buf, size_t size) {return _f ? fread(buf, 1, size, _f.get()) : 0;}
+	bool seek(uint32_t pos, SeekMode mode = SeekSet) {return _f && fseek(_f.get(), pos, mode) == 0;}
+	size_t position() const {return _f ? ftell(_f.get()) : 0;}
+	size_t size() const {
+		if (!_f) {return 0;}
+		long pos = ftell(_f.get());
+		fseek(_f.get(), 0, SEEK_END);
+		long end = ftell(_f.get());
+		fseek(_f.get(), pos, SEEK_SET);
+		return end;
+	}
+	void close() {_f.reset();}
+	operator bool() const {return (bool) _f;}
+	const char *name() const {return _name.c_str();}
+	bool isDirectory() {return false;}
+	File openNextFile(const char * = FILE_READ) {return File();}
+	void rewindDirectory() {}
+
+  private:
+	std::shared_ptr<FILE> _f;
+	String _name;
+};
+
+class FS
+{
+  public:
+	explicit FS(const String &root) : _root(root) {}
+	bool begin(bool = false) {return true;}
+	File open(const String &path, const char *mode = FILE_READ) {
+		FILE *f = fopen((_root + path).c_str(), strcmp(mode, "r") == 0 ? "rb" : strcmp(mode, "w") == 0 ? "wb" : "ab");
+		return f ? File(f, path) : File();
+	}
+	File open(const char *path, const char *mode = FILE_READ) {return open(String(path), mode);}
+	bool exists(const String &path) {
+		FILE *f = fopen((_root + path).c_str(), "rb");
+		if (f) {fclose(f);}
+		return f != NULL;
+	}
+	bool exists(const char *path) {return exists(String(path));}
+	bool remove(const String &path) {return ::remove((_root + path).c_str()) == 0;}
+	void setRoot(const String &root) {_root = root;}
+
+  private:
+	String _root;
+};
+
+}
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+
+#endif
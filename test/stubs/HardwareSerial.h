@@ -0,0 +1,4 @@
+/*
+  HardwareSerial.h	Serial ports of the host tests, in Arduino.h.
+*/
+#include <Arduino.h>
@@ -0,0 +1,29 @@
+/*
+  IPAddress.h		Arduino IPv4 address for the host tests.
+*/
+#ifndef IPADDRESS_H_
+#define IPADDRESS_H_
+
+#include "Print.h"
+
+class IPAddress
+{
+  public:
+	IPAddress() : _address(0) {}
+	IPAddress(uint32_t address) : _address(address) {}
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | b << 8 | c << 16 | (uint32_t) d << 24) {}
+	operator uint32_t() const {return _address;}
+	bool operator==(const IPAddress &rhs) const {return _address == rhs._address;}
+	bool operator!=(const IPAddress &rhs) const {return _address != rhs._address;}
+	uint8_t operator[](int index) const {return (_address >> (8 * index)) & 0xFF;}
+	String toString() const {
+		char b[16];
+		snprintf(b, sizeof(b), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+		return String(b);
+	}
+
+  private:
+	uint32_t _address;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+  Print.h		Arduino Print for the host tests.
+*/
+#ifndef PRINT_H_
+#define PRINT_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print
+{
+  public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size) {
+		size_t n = 0;
+		while (size--) {n += write(*buffer++);}
+		return n;
+	}
+	size_t write(const char *str) {return str ? write((const uint8_t *) str, strlen(str)) : 0;}
+	size_t write(const char *buffer, size_t size) {return write((const uint8_t *) buffer, size);}
+
+	size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+		char small[64];
+		va_list args;
+		va_start(args, format);
+		int len = vsnprintf(small, sizeof(small), format, args);
+		va_end(args);
+		if (len < 0) {return 0;}
+		if (len < (int) sizeof(small)) {return write((const uint8_t *) small, len);}
+		char *big = new char[len + 1];
+		va_start(args, format);
+		vsnprintf(big, len + 1, format, args);
+		va_end(args);
+		size_t n = write((const uint8_t *) big, len);
+		delete[] big;
+		return n;
+	}
+
+	size_t print(const String &s) {return write((const uint8_t *) s.c_str(), s.length());}
+	size_t print(const char *s) {return write(s);}
+	size_t print(const __FlashStringHelper *s) {return write((const char *) s);}
+	size_t print(char c) {return write((uint8_t) c);}
+	size_t print(unsigned char v, int base = DEC) {return print(String(v, base));}
+	size_t print(int v, int base = DEC) {return print(String(v, base));}
+	size_t print(unsigned int v, int base = DEC) {return print(String(v, base));}
+	size_t print(long v, int base = DEC) {return print(String(v, base));}
+	size_t print(unsigned long v, int base = DEC) {return print(String(v, base));}
+	size_t print(long long v, int base = DEC) {return print(String(v, base));}
+	size_t print(unsigned long long v, int base = DEC) {return print(String(v, base));}
+	size_t print(double v, int digits = 2) {return print(String(v, digits));}
+
+	size_t println() {return write("\r\n");}
+	template <typename T> size_t println(const T &v) {size_t n = print(v); return n + println();}
+	template <typename T> size_t println(const T &v, int format) {size_t n = print(v, format); return n + println();}
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+  SPI.h			Arduino SPI bus of the host tests : nothing is sent, the TFT_eSPI host
+			backend decodes the bytes itself.
+*/
+#ifndef SPI_H_
+#define SPI_H_
+
+#include <Arduino.h>
+
+#define SPI_HAS_TRANSACTION
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+#define SPI_MSBFIRST 1
+
+class SPISettings
+{
+  public:
+	SPISettings() {}
+	SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass
+{
+  public:
+	void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+	void end() {}
+	void beginTransaction(SPISettings) {}
+	void endTransaction() {}
+	void setFrequency(uint32_t) {}
+	void setDataMode(uint8_t) {}
+	void setBitOrder(uint8_t) {}
+	uint8_t transfer(uint8_t) {return 0;}
+	uint16_t transfer16(uint16_t) {return 0;}
+	void write(uint8_t) {}
+	void write16(uint16_t) {}
+	void write32(uint32_t) {}
+	void writeBytes(const uint8_t *, uint32_t) {}
+};
+extern SPIClass SPI;
+
+#endif
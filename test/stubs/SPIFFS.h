@@ -0,0 +1,12 @@
+/*
+  SPIFFS.h		SPIFFS of the host tests, rooted at the directory given to
+			SPIFFS.setRoot() (the current directory by default).
+*/
+#ifndef SPIFFS_H_
+#define SPIFFS_H_
+
+#include <FS.h>
+
+extern fs::FS SPIFFS;
+
+#endif
@@ -0,0 +1,32 @@
+/*
+  Stream.h		Arduino Stream for the host tests.
+*/
+#ifndef STREAM_H_
+#define STREAM_H_
+
+#include "Print.h"
+
+class Stream: public Print
+{
+  public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	virtual void flush() {}
+
+	size_t readBytes(uint8_t *buffer, size_t length) {
+		size_t n = 0;
+		int c;
+		while (n < length && (c = read()) >= 0) {buffer[n++] = c;}
+		return n;
+	}
+	size_t readBytes(char *buffer, size_t length) {return readBytes((uint8_t *) buffer, length);}
+	String readStringUntil(char terminator) {
+		String s;
+		int c;
+		while ((c = read()) >= 0 && c != terminator) {s += (char) c;}
+		return s;
+	}
+};
+
+#endif
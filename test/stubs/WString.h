@@ -0,0 +1,180 @@
+/*
+  WString.h		Arduino String for the host tests, on top of std::string.
+			Same semantics as the ESP32 core for the members the libraries use.
+*/
+#ifndef WSTRING_H_
+#define WSTRING_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <string>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+
+class String
+{
+  public:
+	String(const char *cstr = "") : _s(cstr ? cstr : "") {}
+	String(const char *cstr, unsigned int length) : _s(cstr ? cstr : "", cstr ? length : 0) {}
+	String(const __FlashStringHelper *str) : _s(str ? (const char *) str : "") {}
+	String(const String &str) = default;
+	String(String &&str) = default;
+	explicit String(char c) : _s(1, c) {}
+	explicit String(unsigned char value, unsigned char base = 10) {fromUnsigned(value, base);}
+	explicit String(int value, unsigned char base = 10) {fromSigned(value, base);}
+	explicit String(unsigned int value, unsigned char base = 10) {fromUnsigned(value, base);}
+	explicit String(long value, unsigned char base = 10) {fromSigned(value, base);}
+	explicit String(unsigned long value, unsigned char base = 10) {fromUnsigned(value, base);}
+	explicit String(long long value, unsigned char base = 10) {fromSigned(value, base);}
+	explicit String(unsigned long long value, unsigned char base = 10) {fromUnsigned(value, base);}
+	explicit String(float value, unsigned char decimals = 2) {fromDouble(value, decimals);}
+	explicit String(double value, unsigned char decimals = 2) {fromDouble(value, decimals);}
+
+	String &operator=(const String &rhs) = default;
+	String &operator=(String &&rhs) = default;
+	String &operator=(const char *cstr) {_s = cstr ? cstr : ""; return *this;}
+	String &operator=(const __FlashStringHelper *str) {_s = str ? (const char *) str : ""; return *this;}
+	String &operator=(char c) {_s.assign(1, c); return *this;}
+
+	explicit operator bool() const {return true;}
+
+	bool reserve(unsigned int size) {_s.reserve(size); return true;}
+	unsigned int length() const {return _s.size();}
+	bool isEmpty() const {return _s.empty();}
+	const char *c_str() const {return _s.c_str();}
+	char *begin() {return &_s[0];}
+	char *end() {return &_s[0] + _s.size();}
+	const char *begin() const {return c_str();}
+	const char *end() const {return c_str() + _s.size();}
+
+	bool concat(const String &str) {_s += str._s; return true;}
+	bool concat(const char *cstr) {if (!cstr) {return false;} _s += cstr; return true;}
+	bool concat(const char *cstr, unsigned int length) {if (!cstr) {return false;} _s.append(cstr, length); return true;}
+	bool concat(const __FlashStringHelper *str) {return concat((const char *) str);}
+	bool concat(char c) {_s += c; return true;}
+	bool concat(unsigned char value) {return concat(String(value));}
+	bool concat(int value) {return concat(String(value));}
+	bool concat(unsigned int value) {return concat(String(value));}
+	bool concat(long value) {return concat(String(value));}
+	bool concat(unsigned long value) {return concat(String(value));}
+	bool concat(long long value) {return concat(String(value));}
+	bool concat(unsigned long long value) {return concat(String(value));}
+	bool concat(float value) {return concat(String(value));}
+	bool concat(double value) {return concat(String(value));}
+
+	template <typename T> String &operator+=(const T &value) {concat(value); return *this;}
+
+	int compareTo(const String &s) const {return strcmp(c_str(), s.c_str());}
+	bool equals(const String &s) const {return _s == s._s;}
+	bool equals(const char *cstr) const {return _s == (cstr ? cstr : "");}
+	bool equalsIgnoreCase(const String &s) const {return _s.size() == s._s.size() && strcasecmp(c_str(), s.c_str()) == 0;}
+	bool equalsConstantTime(const String &s) const {
+		if (_s.size() != s._s.size()) {return false;}
+		unsigned char diff = 0;
+		for (size_t i = 0; i < _s.size(); i++) {diff |= _s[i] ^ s._s[i];}
+		return diff == 0;
+	}
+	bool operator==(const String &rhs) const {return equals(rhs);}
+	bool operator==(const char *cstr) const {return equals(cstr);}
+	bool operator!=(const String &rhs) const {return !equals(rhs);}
+	bool operator!=(const char *cstr) const {return !equals(cstr);}
+	bool operator<(const String &rhs) const {return compareTo(rhs) < 0;}
+	bool operator>(const String &rhs) const {return compareTo(rhs) > 0;}
+	bool operator<=(const String &rhs) const {return compareTo(rhs) <= 0;}
+	bool operator>=(const String &rhs) const {return compareTo(rhs) >= 0;}
+
+	bool startsWith(const String &prefix, unsigned int offset = 0) const {
+		return offset + prefix._s.size() <= _s.size() && _s.compare(offset, prefix._s.size(), prefix._s) == 0;
+	}
+	bool endsWith(const String &suffix) const {
+		return suffix._s.size() <= _s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+	}
+
+	char charAt(unsigned int index) const {return index < _s.size() ? _s[index] : 0;}
+	void setCharAt(unsigned int index, char c) {if (index < _s.size()) {_s[index] = c;}}
+	char operator[](unsigned int index) const {return charAt(index);}
+	char &operator[](unsigned int index) {static char dummy; if (index >= _s.size()) {dummy = 0; return dummy;} return _s[index];}
+	void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const {
+		if (!bufsize || !buf) {return;}
+		if (index >= _s.size()) {buf[0] = 0; return;}
+		unsigned int n = _s.size() - index;
+		if (n > bufsize - 1) {n = bufsize - 1;}
+		memcpy(buf, _s.c_str() + index, n);
+		buf[n] = 0;
+	}
+	void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const {getBytes((unsigned char *) buf, bufsize, index);}
+
+	int indexOf(char ch, unsigned int fromIndex = 0) const {return found(_s.find(ch, fromIndex));}
+	int indexOf(const String &str, unsigned int fromIndex = 0) const {return found(_s.find(str._s, fromIndex));}
+	int lastIndexOf(char ch) const {return found(_s.rfind(ch));}
+	int lastIndexOf(char ch, unsigned int fromIndex) const {return found(_s.rfind(ch, fromIndex));}
+	int lastIndexOf(const String &str) const {return found(_s.rfind(str._s));}
+	int lastIndexOf(const String &str, unsigned int fromIndex) const {return found(_s.rfind(str._s, fromIndex));}
+
+	String substring(unsigned int beginIndex) const {return substring(beginIndex, _s.size());}
+	String substring(unsigned int beginIndex, unsigned int endIndex) const {
+		if (beginIndex > endIndex) {unsigned int t = beginIndex; beginIndex = endIndex; endIndex = t;}
+		if (beginIndex >= _s.size()) {return String();}
+		if (endIndex > _s.size()) {endIndex = _s.size();}
+		return String(_s.substr(beginIndex, endIndex - beginIndex).c_str(), endIndex - beginIndex);
+	}
+
+	void replace(char find, char replace) {for (char &c : _s) {if (c == find) {c = replace;}}}
+	void replace(const String &find, const String &replace) {
+		if (find._s.empty()) {return;}
+		std::string out;
+		size_t pos = 0, hit;
+		while ((hit = _s.find(find._s, pos)) != std::string::npos) {
+			out.append(_s, pos, hit - pos);
+			out += replace._s;
+			pos = hit + find._s.size();
+		}
+		out.append(_s, pos, std::string::npos);
+		_s = out;
+	}
+	void remove(unsigned int index) {if (index < _s.size()) {_s.erase(index);}}
+	void remove(unsigned int index, unsigned int count) {if (index < _s.size()) {_s.erase(index, count);}}
+	void toLowerCase() {for (char &c : _s) {c = tolower((unsigned char) c);}}
+	void toUpperCase() {for (char &c : _s) {c = toupper((unsigned char) c);}}
+	void trim() {
+		size_t b = 0, e = _s.size();
+		while (b < e && isspace((unsigned char) _s[b])) {b++;}
+		while (e > b && isspace((unsigned char) _s[e - 1])) {e--;}
+		_s = _s.substr(b, e - b);
+	}
+
+	long toInt() const {return atol(c_str());}
+	float toFloat() const {return atof(c_str());}
+	double toDouble() const {return atof(c_str());}
+
+  private:
+	static int found(size_t pos) {return pos == std::string::npos ? -1 : (int) pos;}
+	void fromSigned(long long value, unsigned char base) {
+		if (base == 10) {char b[24]; snprintf(b, sizeof(b), "%lld", value); _s = b;}
+		else {fromUnsigned((unsigned long long) value, base);}
+	}
+	void fromUnsigned(unsigned long long value, unsigned char base) {
+		char b[66];
+		int i = sizeof(b) - 1;
+		b[i] = 0;
+		do {int d = value % base; b[--i] = d < 10 ? '0' + d : 'a' + d - 10; value /= base;} while (value);
+		_s = b + i;
+	}
+	void fromDouble(double value, unsigned char decimals) {char b[64]; snprintf(b, sizeof(b), "%.*f", decimals, value); _s = b;}
+
+	std::string _s;
+};
+
+template <typename T> inline String operator+(const String &lhs, const T &rhs) {String s(lhs); s.concat(rhs); return s;}
+inline String operator+(const char *lhs, const String &rhs) {String s(lhs); s.concat(rhs); return s;}
+inline String operator+(char lhs, const String &rhs) {String s(lhs); s.concat(rhs); return s;}
+inline bool operator==(const char *lhs, const String &rhs) {return rhs.equals(lhs);}
+inline bool operator!=(const char *lhs, const String &rhs) {return !rhs.equals(lhs);}
+
+#endif
@@ -0,0 +1,22 @@
+/*
+  WiFi.h		Access point of the host tests : the station at 192.168.4.1.
+*/
+#ifndef WIFI_H_
+#define WIFI_H_
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+typedef enum {WL_IDLE_STATUS = 0, WL_CONNECTED = 3, WL_DISCONNECTED = 6} wl_status_t;
+
+class WiFiClass
+{
+  public:
+	wl_status_t status() {return WL_DISCONNECTED;}
+	IPAddress localIP() {return IPAddress(192, 168, 4, 1);}
+	IPAddress softAPIP() {return IPAddress(192, 168, 4, 1);}
+	int8_t RSSI() {return 0;}
+};
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  cbuf.h		Circular buffer of the ESP32 core (AsyncResponseStream), for the host tests.
+*/
+#ifndef CBUF_H_
+#define CBUF_H_
+
+#include <stddef.h>
+#include <deque>
+
+class cbuf
+{
+  public:
+	explicit cbuf(size_t size) : _size(size) {}
+	size_t resizeAdd(size_t addSize) {_size += addSize; return _size;}
+	size_t size() const {return _size;}
+	size_t available() const {return _data.size();}
+	size_t room() const {return _size - _data.size();}
+	bool empty() const {return _data.empty();}
+	bool full() const {return room() == 0;}
+	int peek() {return _data.empty() ? -1 : (unsigned char) _data.front();}
+	int read() {
+		if (_data.empty()) {return -1;}
+		int c = (unsigned char) _data.front();
+		_data.pop_front();
+		return c;
+	}
+	size_t read(char *dst, size_t size) {
+		size_t n = 0;
+		while (n < size && !_data.empty()) {dst[n++] = _data.front(); _data.pop_front();}
+		return n;
+	}
+	size_t write(char c) {if (full()) {return 0;} _data.push_back(c); return 1;}
+	size_t write(const char *src, size_t size) {
+		size_t n = 0;
+		while (n < size && !full()) {_data.push_back(src[n++]);}
+		return n;
+	}
+	void flush() {_data.clear();}
+
+  private:
+	size_t _size;
+	std::deque<char> _data;
+};
+
+#endif
@@ -0,0 +1,11 @@
+/*
+  esp_system.h		Random numbers of the ESP-IDF for the host tests.
+*/
+#ifndef ESP_SYSTEM_H_
+#define ESP_SYSTEM_H_
+
+#include <stdint.h>
+
+extern "C" uint32_t esp_random();
+
+#endif
@@ -0,0 +1,20 @@
+/*
+  FreeRTOS.h		The FreeRTOS types used by the libraries, for the host tests.
+*/
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+
+#endif
@@ -0,0 +1,16 @@
+/*
+  semphr.h		FreeRTOS binary semaphores of the host tests, on std::mutex.
+*/
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "FreeRTOS.h"
+
+typedef struct HostSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif
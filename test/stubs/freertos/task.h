@@ -0,0 +1,18 @@
+/*
+  task.h		FreeRTOS tasks of the host tests : the scheduler calls do nothing.
+*/
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+inline void vTaskSuspendAll() {}
+inline BaseType_t xTaskResumeAll() {return pdFALSE;}
+inline TaskHandle_t xTaskGetCurrentTaskHandle() {return NULL;}
+inline BaseType_t xPortGetCoreID() {return 0;}
+TickType_t xTaskGetTickCount();
+void vTaskDelay(TickType_t ticks);
+
+#endif
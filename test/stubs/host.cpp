@@ -0,0 +1,443 @@
+/*
+  host.cpp		The functions of the ESP32 core, of the ESP-IDF and of AsyncTCP
+			behind the shims of test/stubs.
+*/
+
+#include <Arduino.h>
+#include <AsyncTCP.h>
+#include <SPI.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "freertos/task.h"
+#include "libb64/cencode.h"
+#include "mbedtls/md5.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/*
+  Time
+*/
+static std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+unsigned long micros() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStart).count();
+}
+
+void hostAdvanceMillis(uint32_t ms) {hostStart -= std::chrono::milliseconds(ms);}
+
+void delay(uint32_t ms) {std::this_thread::sleep_for(std::chrono::milliseconds(ms));}
+void delayMicroseconds(uint32_t us) {std::this_thread::sleep_for(std::chrono::microseconds(us));}
+TickType_t xTaskGetTickCount() {return millis();}
+void vTaskDelay(TickType_t ticks) {delay(ticks);}
+
+/*
+  Random numbers, repeatable from one run to the next
+*/
+static std::mt19937 hostRandom(857);
+
+extern "C" uint32_t esp_random() {return hostRandom();}
+long random(long max) {return max > 0 ? hostRandom() % max : 0;}
+long random(long min, long max) {return max > min ? min + random(max - min) : min;}
+
+/*
+  Number conversions of the AVR libc
+*/
+char *ultoa(unsigned long value, char *str, int base) {
+	char b[8 * sizeof(long) + 1];
+	int i = sizeof(b) - 1;
+	b[i] = 0;
+	do {int d = value % base; b[--i] = d < 10 ? '0' + d : 'a' + d - 10; value /= base;} while (value);
+	return strcpy(str, b + i);
+}
+
+char *ltoa(long value, char *str, int base) {
+	if (value < 0 && base == 10) {
+		str[0] = '-';
+		ultoa(-(unsigned long) value, str + 1, base);
+		return str;
+	}
+	return ultoa((unsigned long) value, str, base);
+}
+
+char *itoa(int value, char *str, int base) {
+	return base == 10 ? ltoa(value, str, base) : ultoa((unsigned int) value, str, base);
+}
+
+/*
+  Serial, WiFi, SPI, SPIFFS
+*/
+HardwareSerial Serial;
+bool hostSerialEcho = false;
+
+size_t HardwareSerial::write(uint8_t c) {
+	if (hostSerialEcho) {putchar(c);}
+	return 1;
+}
+
+WiFiClass WiFi;
+SPIClass SPI;
+fs::FS SPIFFS("");
+
+/*
+  FreeRTOS semaphores
+*/
+struct HostSemaphore {
+	std::mutex mutex;
+	std::condition_variable given;
+	bool full = false;
+};
+
+void *pxCurrentTCB = &pxCurrentTCB; // a single task
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {return new HostSemaphore;}
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {delete semaphore;}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+	std::lock_guard<std::mutex> lock(semaphore->mutex);
+	if (semaphore->full) {return pdFALSE;}
+	semaphore->full = true;
+	semaphore->given.notify_one();
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+	std::unique_lock<std::mutex> lock(semaphore->mutex);
+	if (ticks == portMAX_DELAY) {semaphore->given.wait(lock, [semaphore] {return semaphore->full;});}
+	else if (!semaphore->given.wait_for(lock, std::chrono::milliseconds(ticks), [semaphore] {return semaphore->full;})) {return pdFALSE;}
+	semaphore->full = false;
+	return pdTRUE;
+}
+
+/*
+  Partitions
+*/
+static std::vector<esp_partition_t> hostPartitions;
+
+void hostAddPartition(const char *label, const uint8_t *image, size_t size) {
+	esp_partition_t p = {};
+	p.type = ESP_PARTITION_TYPE_DATA;
+	p.subtype = ESP_PARTITION_SUBTYPE_ANY;
+	p.size = size;
+	strncpy(p.label, label, sizeof(p.label) - 1);
+	p.data = image;
+	hostPartitions.push_back(p);
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+	for (const esp_partition_t &p : hostPartitions) {
+		if ((p.type == type) && ((subtype == ESP_PARTITION_SUBTYPE_ANY) || (p.subtype == subtype)) && (!label || strcmp(p.label, label) == 0)) {
+			return &p;
+		}
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size, spi_flash_mmap_memory_t,
+                             const void **out_ptr, spi_flash_mmap_handle_t *out_handle) {
+	if (offset + size > partition->size) {return ESP_FAIL;}
+	*out_ptr = partition->data + offset;
+	*out_handle = 1;
+	return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t) {}
+
+/*
+  AsyncTCP
+*/
+size_t AsyncClient::window = 5744;
+AsyncServer *AsyncServer::running = NULL;
+
+AsyncClient::AsyncClient(std::shared_ptr<HostConnection> peer) : _peer(peer), _pending(0), _firstPending(0), _rxTimeout(0) {
+	_peer->client = this;
+}
+
+AsyncClient::~AsyncClient() {
+	_peer->closed = true;
+	_peer->client = NULL;
+}
+
+size_t AsyncClient::add(const char *data, size_t size, uint8_t apiflags) {
+	size_t room = space();
+	if (!data || !size || !room) {return 0;}
+	if (size > room) {size = room;}
+	_peer->segments.push_back({data, size, apiflags});
+	_peer->sent.append(data, size);
+	_pending += size;
+	return size;
+}
+
+bool AsyncClient::send() {
+	if (!connected()) {return false;}
+	_peer->unacked += _pending;
+	_pending = 0;
+	return true;
+}
+
+void AsyncClient::close(bool) {
+	if (_peer->closed) {return;}
+	_peer->closed = true;
+	if (_discard) {_discard(_discardArg, this);} // the server deletes the client
+}
+
+std::shared_ptr<HostConnection> AsyncServer::connect() {
+	std::shared_ptr<HostConnection> connection = std::make_shared<HostConnection>();
+	AsyncClient *client = new AsyncClient(connection);
+	if (_client) {_client(_clientArg, client);}
+	return connection;
+}
+
+void HostConnection::receive(const char *data, size_t len) {
+	if (!client || closed || !client->_data) {return;}
+	std::vector<char> segment(data, data + len); // the server writes in the buffer it is given
+	client->_data(client->_dataArg, client, segment.data(), len);
+}
+
+bool HostConnection::acknowledge() {
+	if (!client || !unacked) {return false;}
+	size_t len = unacked;
+	unacked = 0;
+	if (client->_ack) {client->_ack(client->_ackArg, client, len, 1);}
+	return true;
+}
+
+void HostConnection::exchange(const std::string &data, size_t split) {
+	if (split == 0) {split = data.size();}
+	for (size_t i = 0; i < data.size(); i += split) {
+		receive(data.data() + i, std::min(split, data.size() - i));
+	}
+	for (;;) {
+		if (acknowledge()) {continue;}
+		if (!client || closed || !client->_poll) {break;}
+		size_t before = sent.size();
+		client->_poll(client->_pollArg, client); // the responses waiting for room in the window
+		if (sent.size() == before && !unacked) {break;}
+	}
+}
+
+void HostConnection::disconnect() {
+	if (client) {client->close(true);}
+}
+
+/*
+  Base64 (libb64)
+*/
+static const char base64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+extern "C" void base64_init_encodestate(base64_encodestate *state_in) {
+	state_in->step = step_A;
+	state_in->result = 0;
+	state_in->stepcount = 0;
+}
+
+extern "C" char base64_encode_value(char value_in) {
+	return (unsigned char) value_in > 63 ? '=' : base64Chars[(int) value_in];
+}
+
+extern "C" int base64_encode_block(const char *plaintext_in, int length_in, char *code_out, base64_encodestate *state_in) {
+	const unsigned char *in = (const unsigned char *) plaintext_in;
+	const unsigned char *end = in + length_in;
+	char *out = code_out;
+	char result = state_in->result;
+	switch (state_in->step) {
+		for (;;) {
+	case step_A:
+			if (in == end) {state_in->result = result; state_in->step = step_A; return out - code_out;}
+			result = (*in >> 2) & 0x3f;
+			*out++ = base64_encode_value(result);
+			result = (*in++ & 0x03) << 4;
+	case step_B:
+			if (in == end) {state_in->result = result; state_in->step = step_B; return out - code_out;}
+			result |= (*in >> 4) & 0x0f;
+			*out++ = base64_encode_value(result);
+			result = (*in++ & 0x0f) << 2;
+	case step_C:
+			if (in == end) {state_in->result = result; state_in->step = step_C; return out - code_out;}
+			result |= (*in >> 6) & 0x03;
+			*out++ = base64_encode_value(result);
+			*out++ = base64_encode_value(*in++ & 0x3f);
+		}
+	}
+	return out - code_out;
+}
+
+extern "C" int base64_encode_blockend(char *code_out, base64_encodestate *state_in) {
+	char *out = code_out;
+	switch (state_in->step) {
+	case step_B:
+		*out++ = base64_encode_value(state_in->result);
+		*out++ = '=';
+		*out++ = '=';
+		break;
+	case step_C:
+		*out++ = base64_encode_value(state_in->result);
+		*out++ = '=';
+		break;
+	case step_A:
+		break;
+	}
+	*out = 0;
+	return out - code_out;
+}
+
+extern "C" int base64_encode_chars(const char *plaintext_in, int length_in, char *code_out) {
+	base64_encodestate state;
+	base64_init_encodestate(&state);
+	int len = base64_encode_block(plaintext_in, length_in, code_out, &state);
+	return len + base64_encode_blockend(code_out + len, &state);
+}
+
+/*
+  MD5 (RFC 1321)
+*/
+static inline uint32_t rol(uint32_t x, int n) {return (x << n) | (x >> (32 - n));}
+
+static void md5Block(uint32_t state[4], const unsigned char block[64]) {
+	static const uint32_t K[64] = {
+		0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+		0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+		0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+		0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+		0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+		0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+		0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+		0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+	static const int R[16] = {7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21};
+	uint32_t m[16];
+	for (int i = 0; i < 16; i++) {
+		m[i] = block[4 * i] | block[4 * i + 1] << 8 | block[4 * i + 2] << 16 | (uint32_t) block[4 * i + 3] << 24;
+	}
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	for (int i = 0; i < 64; i++) {
+		uint32_t f;
+		int g;
+		if (i < 16) {f = (b & c) | (~b & d); g = i;}
+		else if (i < 32) {f = (d & b) | (~d & c); g = (5 * i + 1) % 16;}
+		else if (i < 48) {f = b ^ c ^ d; g = (3 * i + 5) % 16;}
+		else {f = c ^ (b | ~d); g = (7 * i) % 16;}
+		uint32_t t = d;
+		d = c;
+		c = b;
+		b = b + rol(a + f + K[i] + m[g], R[(i / 16) * 4 + i % 4]);
+		a = t;
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+}
+
+extern "C" void mbedtls_md5_init(mbedtls_md5_context *ctx) {memset(ctx, 0, sizeof(*ctx));}
+extern "C" void mbedtls_md5_free(mbedtls_md5_context *ctx) {memset(ctx, 0, sizeof(*ctx));}
+
+unsigned long hostMd5Runs = 0;
+
+extern "C" int mbedtls_md5_starts_ret(mbedtls_md5_context *ctx) {
+	hostMd5Runs++;
+	ctx->total[0] = ctx->total[1] = 0;
+	ctx->state[0] = 0x67452301;
+	ctx->state[1] = 0xefcdab89;
+	ctx->state[2] = 0x98badcfe;
+	ctx->state[3] = 0x10325476;
+	return 0;
+}
+
+extern "C" int mbedtls_md5_update_ret(mbedtls_md5_context *ctx, const unsigned char *input, size_t ilen) {
+	while (ilen--) {
+		ctx->buffer[ctx->total[0]++ % 64] = *input++;
+		if (ctx->total[0] % 64 == 0) {md5Block(ctx->state, ctx->buffer);}
+	}
+	return 0;
+}
+
+extern "C" int mbedtls_md5_finish_ret(mbedtls_md5_context *ctx, unsigned char output[16]) {
+	uint64_t bits = (uint64_t) ctx->total[0] * 8;
+	unsigned char pad = 0x80;
+	mbedtls_md5_update_ret(ctx, &pad, 1);
+	pad = 0;
+	while (ctx->total[0] % 64 != 56) {mbedtls_md5_update_ret(ctx, &pad, 1);}
+	for (int i = 0; i < 8; i++) {
+		unsigned char b = bits >> (8 * i);
+		mbedtls_md5_update_ret(ctx, &b, 1);
+	}
+	for (int i = 0; i < 16; i++) {output[i] = ctx->state[i / 4] >> (8 * (i % 4));}
+	return 0;
+}
+
+/*
+  SHA-1 (RFC 3174), with the interface of the ESP32 core used by AsyncWebSocket
+*/
+extern "C" {
+typedef struct {
+	uint32_t state[5];
+	uint32_t count[2];
+	unsigned char buffer[64];
+} SHA1_CTX;
+
+void SHA1Transform(uint32_t state[5], const unsigned char buffer[64]) {
+	uint32_t w[80];
+	for (int i = 0; i < 16; i++) {
+		w[i] = (uint32_t) buffer[4 * i] << 24 | buffer[4 * i + 1] << 16 | buffer[4 * i + 2] << 8 | buffer[4 * i + 3];
+	}
+	for (int i = 16; i < 80; i++) {w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);}
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+	for (int i = 0; i < 80; i++) {
+		uint32_t f, k;
+		if (i < 20) {f = (b & c) | (~b & d); k = 0x5a827999;}
+		else if (i < 40) {f = b ^ c ^ d; k = 0x6ed9eba1;}
+		else if (i < 60) {f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc;}
+		else {f = b ^ c ^ d; k = 0xca62c1d6;}
+		uint32_t t = rol(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rol(b, 30);
+		b = a;
+		a = t;
+	}
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+void SHA1Init(SHA1_CTX *context) {
+	context->state[0] = 0x67452301;
+	context->state[1] = 0xefcdab89;
+	context->state[2] = 0x98badcfe;
+	context->state[3] = 0x10325476;
+	context->state[4] = 0xc3d2e1f0;
+	context->count[0] = context->count[1] = 0;
+}
+
+void SHA1Update(SHA1_CTX *context, const unsigned char *data, uint32_t len) {
+	while (len--) {
+		context->buffer[context->count[0]++ % 64] = *data++;
+		if (context->count[0] == 0) {context->count[1]++;}
+		if (context->count[0] % 64 == 0) {SHA1Transform(context->state, context->buffer);}
+	}
+}
+
+void SHA1Final(unsigned char digest[20], SHA1_CTX *context) {
+	uint64_t bits = ((uint64_t) context->count[1] << 32 | context->count[0]) * 8;
+	unsigned char pad = 0x80;
+	SHA1Update(context, &pad, 1);
+	pad = 0;
+	while (context->count[0] % 64 != 56) {SHA1Update(context, &pad, 1);}
+	for (int i = 7; i >= 0; i--) {
+		unsigned char b = bits >> (8 * i);
+		SHA1Update(context, &b, 1);
+	}
+	for (int i = 0; i < 20; i++) {digest[i] = context->state[i / 4] >> (8 * (3 - i % 4));}
+}
+}
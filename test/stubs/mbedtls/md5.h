@@ -0,0 +1,33 @@
+/*
+  md5.h			MD5 of mbed TLS for the host tests.
+*/
+#ifndef MBEDTLS_MD5_H
+#define MBEDTLS_MD5_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+	uint32_t total[2];
+	uint32_t state[4];
+	unsigned char buffer[64];
+} mbedtls_md5_context;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void mbedtls_md5_init(mbedtls_md5_context *ctx);
+void mbedtls_md5_free(mbedtls_md5_context *ctx);
+int mbedtls_md5_starts_ret(mbedtls_md5_context *ctx);
+int mbedtls_md5_update_ret(mbedtls_md5_context *ctx, const unsigned char *input, size_t ilen);
+int mbedtls_md5_finish_ret(mbedtls_md5_context *ctx, unsigned char output[16]);
+#define mbedtls_md5_starts(ctx) mbedtls_md5_starts_ret(ctx)
+#define mbedtls_md5_update(ctx, input, ilen) mbedtls_md5_update_ret(ctx, input, ilen)
+#define mbedtls_md5_finish(ctx, output) mbedtls_md5_finish_ret(ctx, output)
+// Host : number of MD5 started, for the tests of the code which must not hash
+extern unsigned long hostMd5Runs;
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,9 @@
+/*
+  pgmspace.h		Flash constants are plain constants on a PC (see Arduino.h).
+*/
+#ifndef PGMSPACE_H_
+#define PGMSPACE_H_
+
+#include <Arduino.h>
+
+#endif
@@ -0,0 +1,160 @@
+/*
+  task_ring_test.cpp	SpscRing and MpscRing between threads : N producers push numbered
+			items through a small ring, the consumer gets every item exactly
+			once and the items of a producer in the order it pushed them,
+			MpscRing pops them in the order of the positions given by push.
+
+  Built without ESP32, the rings are plain std::atomic code. A thread sanitizer
+  run : make BUILD=/tmp/tsan CXXFLAGS="-std=gnu++14 -O1 -g -fsanitize=thread" LDLIBS="-lpthread -fsanitize=thread"
+*/
+
+#include <TaskRing.h>
+#include "check.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#define ITEMS 50000
+
+static thread_local bool producing = false;
+static std::atomic<bool> stalled(false); // a broken ring lost an item or a slot : the producers give up
+
+// A producer lets the other threads run in the middle of its copy into a slot : a consumer reading a slot
+// reserved or published before it is filled gets a torn item, even on a single core
+struct Item {
+	uint32_t producer;
+	uint32_t seq;
+	uint32_t check; // seq ^ producer ^ 0x5A5A5A5A, a torn copy does not match
+
+	Item &operator=(const Item &other) {
+		producer = other.producer;
+		seq = other.seq;
+		if (producing) {std::this_thread::yield();}
+		check = other.check;
+		return *this;
+	}
+};
+
+static Item item(uint32_t producer, uint32_t seq) {
+	return {producer, seq, seq ^ producer ^ 0x5A5A5A5A};
+}
+
+// Pops until every producer pushed ITEMS items, checks the order per producer
+template <typename Ring>
+static void consume(Ring &ring, uint32_t producers, const char *what) {
+	std::vector<uint32_t> next(producers, 0);
+	uint32_t received = 0, bad = 0;
+	Item it;
+	std::chrono::steady_clock::time_point progress = std::chrono::steady_clock::now();
+	while (received < producers * ITEMS) {
+		if (!ring.pop(it)) {
+			if (std::chrono::steady_clock::now() - progress > std::chrono::seconds(5)) {stalled = true; break;}
+			std::this_thread::yield();
+			continue;
+		}
+		progress = std::chrono::steady_clock::now();
+		received++;
+		if (it.producer >= producers || it.check != (it.seq ^ it.producer ^ 0x5A5A5A5A)) {bad++; continue;}
+		if (it.seq != next[it.producer]) {bad++;}
+		next[it.producer] = it.seq + 1;
+	}
+	int failures = checkFailures;
+	CHECK(!stalled);
+	CHECK_EQUAL(bad, 0u);
+	for (uint32_t p = 0; p < producers; p++) {CHECK_EQUAL(next[p], (uint32_t) ITEMS);}
+	CHECK(!ring.pop(it)); // nothing more than what was pushed
+	CHECK_EQUAL(ring.size(), 0u);
+	if (checkFailures != failures) {fprintf(stderr, "  in %s, %u producers\n", what, producers);}
+}
+
+template <typename Ring>
+static void produce(Ring &ring, uint32_t producer) {
+	producing = true;
+	for (uint32_t seq = 0; seq < ITEMS; seq++) {
+		while (!ring.push(item(producer, seq))) { // full
+			if (stalled) {return;}
+			std::this_thread::yield();
+		}
+	}
+}
+
+// Small rings so that the producers find them full and the consumer finds them empty, the indices wrap
+// around the slots thousands of times
+static SpscRing<Item, 16> spsc;
+static MpscRing<Item, 16> mpsc;
+static MpscRing<Item, 256> mpscLarge;
+
+int main() {
+	// Single thread : capacity, full, empty, FIFO
+	Item it;
+	CHECK(!spsc.pop(it));
+	for (uint32_t i = 0; i < 16; i++) {CHECK(spsc.push(item(0, i)));}
+	CHECK(!spsc.push(item(0, 16)));
+	CHECK_EQUAL(spsc.size(), 16u);
+	for (uint32_t i = 0; i < 16; i++) {CHECK(spsc.pop(it) && it.seq == i);}
+	CHECK(!spsc.pop(it));
+	CHECK(!mpsc.pop(it));
+	for (uint32_t i = 0; i < 16; i++) {CHECK(mpsc.push(item(1, i)));}
+	CHECK(!mpsc.push(item(1, 16)));
+	for (uint32_t i = 0; i < 16; i++) {CHECK(mpsc.pop(it) && it.seq == i && it.producer == 1);}
+	CHECK(!mpsc.pop(it));
+	// positions : consecutive, a push into a full ring takes none, pop gives the position of the push
+	uint32_t position = 0, popped = 0;
+	for (uint32_t i = 0; i < 16; i++) {CHECK(mpsc.push(item(1, i), &position) && position == 16 + i);}
+	CHECK(!mpsc.push(item(1, 16), &position));
+	for (uint32_t i = 0; i < 8; i++) {CHECK(mpsc.pop(it, &popped) && popped == 16 + i);}
+	CHECK(mpsc.push(item(1, 16), &position) && position == 32);
+	for (uint32_t i = 8; i < 17; i++) {CHECK(mpsc.pop(it, &popped) && popped == 16 + i && it.seq == i);}
+	CHECK(!mpsc.pop(it, &popped));
+
+	std::thread one([] {produce(spsc, 0);});
+	consume(spsc, 1, "SpscRing");
+	one.join();
+
+	for (uint32_t producers : {1, 2, 4, 8}) {
+		std::vector<std::thread> threads;
+		for (uint32_t p = 0; p < producers; p++) {threads.emplace_back([p] {produce(mpsc, p);});}
+		consume(mpsc, producers, "MpscRing<16>");
+		for (std::thread &t : threads) {t.join();}
+	}
+	std::vector<std::thread> threads;
+	for (uint32_t p = 0; p < 4; p++) {threads.emplace_back([p] {produce(mpscLarge, p);});}
+	consume(mpscLarge, 4, "MpscRing<256>");
+	for (std::thread &t : threads) {t.join();}
+	threads.clear();
+
+	// Between threads, the items are popped in the order of the positions given to their producers
+	std::vector<uint32_t> pushedAt(4 * ITEMS), poppedAt(4 * ITEMS);
+	for (uint32_t p = 0; p < 4; p++) {
+		threads.emplace_back([p, &pushedAt] {
+			producing = true;
+			for (uint32_t seq = 0; seq < ITEMS; seq++) {
+				while (!mpsc.push(item(p, seq), &pushedAt[p * ITEMS + seq])) {
+					if (stalled) {return;}
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+	uint32_t first = 0, expected = 0, disorder = 0;
+	std::chrono::steady_clock::time_point progress = std::chrono::steady_clock::now();
+	for (uint32_t received = 0; received < 4 * ITEMS; ) {
+		if (!mpsc.pop(it, &popped)) {
+			if (std::chrono::steady_clock::now() - progress > std::chrono::seconds(5)) {stalled = true; break;}
+			std::this_thread::yield();
+			continue;
+		}
+		progress = std::chrono::steady_clock::now();
+		if (received == 0) {first = expected = popped;}
+		if (popped != expected++ || it.producer >= 4 || it.seq >= ITEMS) {disorder++;}
+		else {poppedAt[it.producer * ITEMS + it.seq] = popped;}
+		received++;
+	}
+	for (std::thread &t : threads) {t.join();}
+	CHECK(!stalled);
+	CHECK_EQUAL(disorder, 0u);
+	CHECK(pushedAt == poppedAt);
+	CHECK_EQUAL(expected - first, (uint32_t) (4 * ITEMS));
+
+	return checkResult("task_ring_test");
+}
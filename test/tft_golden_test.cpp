@@ -0,0 +1,220 @@
+/*
+  tft_golden_test.cpp	TFT_eSPI on the host panel emulator (TFT_HOST) with the TTGO
+			setup : fillRect and drawChar give the image stored in
+			golden/tft_golden.ppm and send the expected bytes to the TFT.
+			A smooth font drawn through the glyph cache gives the pixels
+			drawn without it, on the TFT and in a sprite.
+
+  Usage : tft_golden_test <build directory> [--update]
+	  --update writes the golden image again, after a deliberate change of the drawing
+*/
+
+#include <TFT_eSPI.h>
+#include "check.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define GOLDEN "golden/tft_golden.ppm"
+#define AREA_W 100
+#define AREA_H 32
+
+// Smooth font of the glyph cache example, drawn below the golden area
+#define FONT_FILE "../TFT_eSPI/examples/Smooth Fonts/SPIFFS/Smooth_font_cache/data/NotoSansBold36.vlw"
+#define TEXT "14.195.000"
+#define TEXT_Y 48
+#define TEXT_H 48
+
+// Address window (CASET, PASET and RAMWR with their 8 parameter bytes) then the pixels, in one transaction
+static void checkTraffic(uint32_t pixels, const char *what) {
+	int failures = checkFailures;
+	CHECK_EQUAL(tftHost.commands, 3u);
+	CHECK_EQUAL(tftHost.windows, 1u);
+	CHECK_EQUAL(tftHost.pixelBytes, 2 * pixels);
+	CHECK_EQUAL(tftHost.bytes, 3 + 8 + 2 * pixels);
+	CHECK_EQUAL(tftHost.transactions, 1u);
+	CHECK_EQUAL(tftHost.readBytes, 0u);
+	if (checkFailures != failures) {fprintf(stderr, "  in %s\n", what);}
+}
+
+static std::string readFile(const std::string &name) {
+	std::string data;
+	FILE *f = fopen(name.c_str(), "rb");
+	if (!f) {return data;}
+	char b[4096];
+	size_t n;
+	while ((n = fread(b, 1, sizeof(b), f)) > 0) {data.append(b, n);}
+	fclose(f);
+	return data;
+}
+
+// The text on a plain background, then the pixels of its band of the screen
+static std::vector<uint16_t> drawText(TFT_eSPI &tft, int32_t x0, int32_t y0, uint16_t fg, uint16_t bg) {
+	tft.fillRect(0, TEXT_Y, tft.width(), TEXT_H, bg);
+	tft.setTextColor(fg, bg);
+	tft.drawString(TEXT, 2, TEXT_Y);
+	std::vector<uint16_t> pixels;
+	for (int32_t y = 0; y < TEXT_H; y++) {
+		for (int32_t x = 0; x < tft.width(); x++) {pixels.push_back(tftHost.pixel(x0 + x, y0 + TEXT_Y + y));}
+	}
+	return pixels;
+}
+
+static std::vector<uint16_t> drawText(TFT_eSprite &sprite, uint16_t fg, uint16_t bg) {
+	sprite.fillSprite(bg);
+	sprite.setTextColor(fg, bg);
+	sprite.drawString(TEXT, 2, 0);
+	std::vector<uint16_t> pixels;
+	for (int32_t y = 0; y < TEXT_H; y++) {
+		for (int32_t x = 0; x < sprite.width(); x++) {pixels.push_back(sprite.readPixel(x, y));}
+	}
+	return pixels;
+}
+
+// Pixels of the glyph of a character in a .vlw font : a 24 bytes header then 28 bytes per glyph, big endian
+static uint32_t glyphPixels(const std::string &font, char c) {
+	auto word = [&font](size_t at) {
+		const uint8_t *b = (const uint8_t *) font.data() + at;
+		return (uint32_t) b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3];
+	};
+	for (uint32_t i = 0; i < word(0); i++) {
+		if (word(24 + 28 * i) == (uint8_t) c) {return word(24 + 28 * i + 4) * word(24 + 28 * i + 8);}
+	}
+	return 0;
+}
+
+// Smooth font glyph cache : the TFT and a sprite give the pixels drawn without cache, with the alpha and the
+// pre-blended caches, with caches small enough to evict glyphs, after a change of colours and with the bytes
+// of pushImage() swapped
+static void checkGlyphCache(TFT_eSPI &tft, int32_t x0, int32_t y0) {
+	std::string font = readFile(FONT_FILE);
+	CHECK(!font.empty());
+	if (font.empty()) {return;}
+	tft.loadFont((const uint8_t *) font.data());
+	TFT_eSprite sprite(&tft);
+	CHECK(sprite.createSprite(tft.width(), TEXT_H) != nullptr);
+	sprite.loadFont((const uint8_t *) font.data());
+
+	std::vector<uint16_t> plain = drawText(tft, x0, y0, TFT_WHITE, TFT_BLUE);
+	std::vector<uint16_t> other = drawText(tft, x0, y0, TFT_YELLOW, TFT_BLACK);
+	CHECK(plain != other);
+	CHECK(drawText(sprite, TFT_WHITE, TFT_BLUE) == plain);
+	CHECK(drawText(sprite, TFT_YELLOW, TFT_BLACK) == other);
+
+	const uint32_t glyphs = 6; // 1 4 . 9 5 0
+	const uint32_t chars = strlen(TEXT);
+	struct {const char *what; uint32_t bytes; bool preBlend;} modes[] = {
+		{"alpha cache", 16384, false},
+		{"pre-blended cache", 16384, true},
+		{"small alpha cache", 800, false},
+		{"small pre-blended cache", 1600, true},
+	};
+	for (auto &mode : modes) {
+		int failures = checkFailures;
+		bool large = mode.bytes > 2000;
+		for (TFT_eSPI *t : {&tft, (TFT_eSPI *) &sprite}) {
+			auto draw = [&](uint16_t fg, uint16_t bg) {return t == &tft ? drawText(tft, x0, y0, fg, bg) : drawText(sprite, fg, bg);};
+			// not virtual : the swap of a sprite is its own
+			auto setSwap = [&](bool swap) {if (t == &tft) {tft.setSwapBytes(swap);} else {sprite.setSwapBytes(swap);}};
+			auto getSwap = [&]() {return t == &tft ? tft.getSwapBytes() : sprite.getSwapBytes();};
+			t->setGlyphCache(mode.bytes, mode.preBlend);
+			CHECK(draw(TFT_WHITE, TFT_BLUE) == plain);
+			CHECK(draw(TFT_WHITE, TFT_BLUE) == plain);
+			// twice the text : a large cache misses each glyph once, a small one evicts glyphs drawn again
+			uint32_t misses = t->glyphCacheMisses();
+			CHECK(large ? misses == glyphs : misses > glyphs);
+			CHECK_EQUAL(t->glyphCacheHits() + misses, 2 * chars);
+			CHECK(!getSwap());
+
+			// other colours : the pre-blended glyphs are blended again, the alpha values are kept
+			CHECK(draw(TFT_YELLOW, TFT_BLACK) == other);
+			if (large) {CHECK_EQUAL(t->glyphCacheMisses() - misses, mode.preBlend ? glyphs : 0u);}
+
+			// swapped bytes for pushImage() : the pre-blended glyphs are pushed in the 565 order and the setting
+			// is given back
+			setSwap(true);
+			CHECK(draw(TFT_WHITE, TFT_BLUE) == plain);
+			CHECK(getSwap());
+			setSwap(false);
+		}
+		if (checkFailures != failures) {fprintf(stderr, "  with the %s\n", mode.what);}
+	}
+
+	// Eviction of the least recently used glyph : room for two of the glyphs 1, 4 and 9, not for the three
+	uint32_t g1 = glyphPixels(font, '1'), g4 = glyphPixels(font, '4'), g9 = glyphPixels(font, '9');
+	CHECK(g1 && g4 && g9);
+	for (bool preBlend : {false, true}) {
+		int failures = checkFailures;
+		uint32_t scale = preBlend ? 2 : 1;
+		tft.setGlyphCache(scale * std::max({g1 + g4, g1 + g9, g4 + g9}), preBlend);
+		tft.setTextColor(TFT_WHITE, TFT_BLUE);
+		for (const char *text : {"1", "4", "1", "9", "1"}) {tft.drawString(text, 2, TEXT_Y);}
+		// 4 is evicted by 9 as 1 was used after it : 1 is still cached
+		CHECK_EQUAL(tft.glyphCacheMisses(), 3u);
+		CHECK_EQUAL(tft.glyphCacheHits(), 2u);
+		if (checkFailures != failures) {fprintf(stderr, "  LRU eviction, %s\n", preBlend ? "pre-blended" : "alpha");}
+	}
+
+	tft.setGlyphCache(0);
+	tft.unloadFont();
+	sprite.setGlyphCache(0);
+	sprite.unloadFont();
+	sprite.deleteSprite();
+}
+
+int main(int argc, char **argv) {
+	std::string dir = argc > 1 ? argv[1] : "build";
+	bool update = argc > 2 && strcmp(argv[2], "--update") == 0;
+
+	TFT_eSPI tft = TFT_eSPI(135, 240);
+	tft.init();
+	tft.setRotation(1);
+	setup_t setup;
+	tft.getSetup(setup);
+	int32_t x0 = setup.r0_x_offset, y0 = setup.r0_y_offset; // screen (0, 0) in the display RAM
+	CHECK_EQUAL(tft.width(), 240);
+	CHECK_EQUAL(tft.height(), 135);
+	tft.fillScreen(TFT_BLUE);
+
+	tftHost.resetCounters();
+	tft.fillRect(4, 6, 30, 20, TFT_RED);
+	checkTraffic(30 * 20, "fillRect");
+	CHECK_EQUAL(tftHost.pixel(x0 + 4, y0 + 6), TFT_RED);
+	CHECK_EQUAL(tftHost.pixel(x0 + 33, y0 + 25), TFT_RED);
+	CHECK_EQUAL(tftHost.pixel(x0 + 34, y0 + 25), TFT_BLUE);
+	CHECK_EQUAL(tftHost.pixel(x0 + 33, y0 + 26), TFT_BLUE);
+	CHECK_EQUAL(tft.readPixel(4, 6), TFT_RED);
+
+	// A character of the frequency readout : text size 3, white on blue, one window of 18 x 24 pixels
+	tftHost.resetCounters();
+	tft.drawChar(40, 4, '7', TFT_WHITE, TFT_BLUE, 3);
+	checkTraffic(18 * 24, "drawChar");
+	uint32_t white = 0;
+	for (int32_t y = 0; y < 24; y++) {
+		for (int32_t x = 0; x < 18; x++) {white += tftHost.pixel(x0 + 40 + x, y0 + 4 + y) == TFT_WHITE;}
+	}
+	uint32_t dots = 0;
+	for (int i = 0; i < 5; i++) {dots += __builtin_popcount(pgm_read_byte(font + '7' * 5 + i));}
+	CHECK_EQUAL(white, dots * 9);
+
+	tftHost.resetCounters();
+	tft.drawChar(62, 4, '4', TFT_YELLOW, TFT_BLACK, 2);
+	checkTraffic(12 * 16, "drawChar size 2");
+
+	std::string image = dir + "/tft_golden.ppm";
+	CHECK(tftHost.savePPM(image.c_str(), x0, y0, AREA_W, AREA_H));
+	if (update) {
+		CHECK(tftHost.savePPM(GOLDEN, x0, y0, AREA_W, AREA_H));
+		printf("%s written\n", GOLDEN);
+	}
+	std::string golden = readFile(GOLDEN);
+	CHECK(!golden.empty());
+	if (readFile(image) != golden) {
+		fprintf(stderr, "%s differs from %s\n", image.c_str(), GOLDEN);
+		checkFailures++;
+	}
+
+	checkGlyphCache(tft, x0, y0);
+
+	return checkResult("tft_golden_test");
+}
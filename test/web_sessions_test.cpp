@@ -0,0 +1,78 @@
+/*
+  web_sessions_test.cpp	AsyncWebSessions : tokens checked by their MAC without hashing,
+			bound to the identity and to the expiry, eviction of the oldest
+			session.
+*/
+
+#include <ESPAsyncWebServer.h>
+#include "mbedtls/md5.h"
+#include "check.h"
+
+int main() {
+	AsyncWebSessions sessions;
+	CHECK(sessions.issue("alice").length() == 0); // not begun
+	sessions.begin(60);
+
+	String token = sessions.issue("alice");
+	CHECK_EQUAL(token.length(), WEB_SESSION_TOKEN_LENGTH);
+	CHECK(sessions.check(token, "alice"));
+	CHECK(!sessions.check(token, "bob"));
+	CHECK(!sessions.check("", "alice"));
+	CHECK(!sessions.check(token.substring(1), "alice"));
+
+	// Any change of the MAC or of the id is refused, by a compare with the MAC stored by issue() : no MD5 run
+	unsigned long md5Runs = hostMd5Runs;
+	for (unsigned int i = 0; i < token.length(); i++) {
+		String forged = token;
+		forged.setCharAt(i, token[i] == '0' ? '1' : '0');
+		CHECK(!sessions.check(forged, "alice"));
+	}
+	String upper = token;
+	upper.toUpperCase();
+	CHECK(upper == token || !sessions.check(upper, "alice"));
+	CHECK(sessions.check(token, "alice"));
+	CHECK_EQUAL(hostMd5Runs, md5Runs);
+
+	// Forged revocations are ignored, a real one ends the session
+	String forged = token;
+	forged.setCharAt(WEB_SESSION_TOKEN_LENGTH - 1, token[WEB_SESSION_TOKEN_LENGTH - 1] == 'a' ? 'b' : 'a');
+	sessions.revoke(forged);
+	CHECK(sessions.check(token, "alice"));
+	sessions.revoke(token);
+	CHECK(!sessions.check(token, "alice"));
+	CHECK_EQUAL(sessions.count(), 0u);
+	CHECK_EQUAL(hostMd5Runs, md5Runs);
+
+	// Expiry
+	token = sessions.issue("alice");
+	hostAdvanceMillis(59 * 1000);
+	CHECK(sessions.check(token, "alice"));
+	hostAdvanceMillis(1000);
+	CHECK(!sessions.check(token, "alice"));
+	CHECK_EQUAL(sessions.count(), 0u);
+
+	// A new key invalidates every token
+	token = sessions.issue("alice");
+	sessions.begin(60);
+	CHECK(!sessions.check(token, "alice"));
+
+	// Full table : the oldest session is evicted, the others stay
+	String tokens[WEB_SESSION_SLOTS];
+	for (int i = 0; i < WEB_SESSION_SLOTS; i++) {
+		tokens[i] = sessions.issue("alice");
+		hostAdvanceMillis(10);
+	}
+	CHECK_EQUAL(sessions.count(), (size_t) WEB_SESSION_SLOTS);
+	String late = sessions.issue("bob");
+	CHECK(sessions.check(late, "bob"));
+	CHECK(!sessions.check(tokens[0], "alice"));
+	for (int i = 1; i < WEB_SESSION_SLOTS; i++) {CHECK(sessions.check(tokens[i], "alice"));}
+	// an expired slot is taken before a live one
+	sessions.revoke(tokens[3]);
+	String next = sessions.issue("carol");
+	CHECK(sessions.check(next, "carol"));
+	for (int i = 1; i < WEB_SESSION_SLOTS; i++) {CHECK(i == 3 || sessions.check(tokens[i], "alice"));}
+	CHECK(sessions.check(late, "bob"));
+
+	return checkResult("web_sessions_test");
+}
@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+  asset_bundle.py	Packs the web client assets into a single read-only bundle image
+			flashed in its own data partition ("assets", see partitions.csv).
+
+  The bundle is built from the output of tools/build_assets.py : every entry of
+  the manifest assets.txt becomes an index entry pointing to the (pre-gzipped)
+  blob. The hashed url and the logical url share the same blob.
+  The ESP32 memory-maps the partition and streams the blobs straight from flash
+  (AsyncBundle / AsyncBundleResponse in ESPAsyncWebServer/src/AsyncBundle.h).
+
+  Image layout (little endian, see AsyncBundle.h) :
+
+    header, 16 bytes
+      0   char[4]   magic "AWSB"
+      4   uint16    version (1)
+      6   uint16    number of index entries
+      8   uint32    image size in bytes
+      12  uint32    crc32 of the bytes [16, image size)
+    index, 96 bytes per entry
+      0   char[48]  url, NUL terminated
+      48  char[32]  content type, NUL terminated
+      80  uint32    blob offset from the start of the image (4 bytes aligned)
+      84  uint32    blob length
+      88  uint32    flags : bit 0 gzip encoded, bit 1 immutable (fingerprinted url)
+      92  uint32    crc32 of the blob
+    blobs
+
+  Usage :
+
+    python3 tools/asset_bundle.py build  [--src build/data] [--out build/assets.bin]
+    python3 tools/asset_bundle.py verify [--image build/assets.bin]
+
+  Flash the image at the offset of the assets partition, e.g. :
+
+    esptool.py --chip esp32 write_flash 0x340000 build/assets.bin
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b"AWSB"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<48s32sIIII")
+URL_MAX = 48
+TYPE_MAX = 32
+ALIGN = 4
+
+FLAG_GZIP = 0x01
+FLAG_IMMUTABLE = 0x02
+
+MANIFEST = "assets.txt"
+
+# size of the assets partition in partitions.csv
+PARTITION_SIZE = 0xC0000
+
+
+def read_manifest(src):
+    entries = []
+    with open(os.path.join(src, MANIFEST), "r", encoding="ascii") as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) != 4:
+                continue
+            entries.append(tuple(fields))
+    return entries
+
+
+def c_string(text, size, what):
+    raw = text.encode("ascii")
+    if len(raw) >= size:
+        sys.exit("%s too long for the bundle index (%d >= %d): %s" % (what, len(raw), size, text))
+    return raw
+
+
+def build(src, out):
+    blobs = []           # (spiffs file, data)
+    blob_index = {}      # spiffs file -> blob number
+    index = []           # (url, type, blob number, flags)
+
+    for logical, hashed, path, ctype in read_manifest(src):
+        if path not in blob_index:
+            with open(os.path.join(src, path.lstrip("/")), "rb") as f:
+                blob_index[path] = len(blobs)
+                blobs.append((path, f.read()))
+        flags = FLAG_GZIP if path.endswith(".gz") else 0
+        index.append((hashed, ctype, blob_index[path], flags | FLAG_IMMUTABLE))
+        index.append((logical, ctype, blob_index[path], flags))
+
+    # hashed and logical urls are listed once each
+    seen = set()
+    index = [e for e in index if not (e[0] in seen or seen.add(e[0]))]
+
+    offset = HEADER.size + ENTRY.size * len(index)
+    offsets = []
+    body = bytearray()
+    for path, data in blobs:
+        pad = (-offset) % ALIGN
+        body += b"\0" * pad
+        offset += pad
+        offsets.append(offset)
+        body += data
+        offset += len(data)
+
+    table = bytearray()
+    for url, ctype, blob, flags in index:
+        data = blobs[blob][1]
+        table += ENTRY.pack(c_string(url, URL_MAX, "url"), c_string(ctype, TYPE_MAX, "content type"),
+                            offsets[blob], len(data), flags, zlib.crc32(data))
+
+    payload = bytes(table + body)
+    size = HEADER.size + len(payload)
+    if size > PARTITION_SIZE:
+        sys.exit("bundle is %d bytes, the assets partition is only %d bytes" % (size, PARTITION_SIZE))
+
+    image = HEADER.pack(MAGIC, VERSION, len(index), size, zlib.crc32(payload)) + payload
+    os.makedirs(os.path.dirname(os.path.abspath(out)), exist_ok=True)
+    with open(out, "wb") as f:
+        f.write(image)
+    print("%s : %d entries, %d blobs, %d bytes" % (out, len(index), len(blobs), size))
+    return image
+
+
+def verify(image):
+    """Checks an image the same way AsyncBundle::begin() does, plus the blob checksums."""
+    errors = []
+    if len(image) < HEADER.size:
+        return ["image shorter than the header"]
+    magic, version, count, size, crc = HEADER.unpack_from(image, 0)
+    if magic != MAGIC:
+        return ["bad magic %r" % magic]
+    if version != VERSION:
+        return ["unsupported version %d" % version]
+    if size > len(image) or size > PARTITION_SIZE:
+        return ["image size %d out of bounds" % size]
+    if HEADER.size + count * ENTRY.size > size:
+        return ["index does not fit in the image"]
+    if zlib.crc32(image[HEADER.size:size]) != crc:
+        errors.append("image crc mismatch")
+
+    urls = set()
+    for i in range(count):
+        raw_url, raw_type, offset, length, flags, blob_crc = ENTRY.unpack_from(image, HEADER.size + i * ENTRY.size)
+        if b"\0" not in raw_url or b"\0" not in raw_type:
+            errors.append("entry %d: url or content type not NUL terminated" % i)
+            continue
+        url = raw_url.split(b"\0", 1)[0].decode("ascii", "replace")
+        if not url.startswith("/"):
+            errors.append("entry %d: url %r does not start with '/'" % (i, url))
+        if url in urls:
+            errors.append("entry %d: duplicate url %s" % (i, url))
+        urls.add(url)
+        if offset % ALIGN or offset < HEADER.size + count * ENTRY.size or offset + length > size:
+            errors.append("%s: blob [%d, %d) out of bounds" % (url, offset, offset + length))
+            continue
+        blob = image[offset:offset + length]
+        if zlib.crc32(blob) != blob_crc:
+            errors.append("%s: blob crc mismatch" % url)
+        if flags & FLAG_GZIP:
+            try:
+                zlib.decompress(blob, 16 + zlib.MAX_WBITS)
+            except zlib.error as e:
+                errors.append("%s: invalid gzip data (%s)" % (url, e))
+    return errors
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description="Build or verify a web client asset bundle")
+    sub = parser.add_subparsers(dest="command", required=True)
+    p_build = sub.add_parser("build", help="pack the output of build_assets.py")
+    p_build.add_argument("--src", default=os.path.join(root, "build", "data"))
+    p_build.add_argument("--out", default=os.path.join(root, "build", "assets.bin"))
+    p_verify = sub.add_parser("verify", help="check a bundle image")
+    p_verify.add_argument("--image", default=os.path.join(root, "build", "assets.bin"))
+    args = parser.parse_args()
+
+    if args.command == "build":
+        image = build(args.src, args.out)
+    else:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    errors = verify(image)
+    for e in errors:
+        print("error: " + e)
+    if errors:
+        sys.exit(1)
+    print("bundle OK")
+
+
+if __name__ == "__main__":
+    main()
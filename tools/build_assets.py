@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+  build_assets.py	Asset pipeline for the FT857-Web-browser-CAT-ESP32 web client.
+
+  Takes the web client sources from data/ and writes an upload-ready SPIFFS
+  image directory (default build/data) where :
+  - style.css and jogDial.js are minified and gzipped,
+  - every asset except index.html is renamed with a content hash
+    (name.<hash>.ext, plus .gz when compressed),
+  - the references to the assets inside index.html and style.css are rewritten
+    to the hashed names,
+  - index.html is minified but left uncompressed because the ESP32 still runs
+    the %VAR% template processor on it,
+  - a manifest /assets.txt is written. The sketch reads it at boot and serves
+    every hashed asset with "Content-Encoding: gzip" (when compressed) and
+    "Cache-Control: public, max-age=31536000, immutable".
+    Only the HTML shell is revalidated by the browser.
+
+  Manifest format (one asset per line, fields separated by a single space) :
+
+    <logical url> <hashed url> <SPIFFS file> <content type>
+
+  Usage :
+
+    python3 tools/build_assets.py [--src data] [--out build/data]
+
+  The content of the --out directory is then uploaded to the ESP32 flash
+  (mkspiffs + esptool, or copy it over data/ before using the
+  "ESP32 Sketch Data Upload" utility of the Arduino IDE).
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import re
+import shutil
+import sys
+
+MANIFEST = "assets.txt"
+HASH_LEN = 8
+
+# SPIFFS object names are limited to 31 characters including the leading '/'
+SPIFFS_NAME_MAX = 31
+
+# source file, logical urls used by the web client, content type, minify+gzip
+ASSETS = [
+    ("style.css",   ["/style.css"],  "text/css",               True),
+    ("jogDial.js",  ["/jogDial.js"], "application/javascript", True),
+    ("dial.png",    ["/dial.png"],   "image/png",              False),
+    ("knob.png",    ["/knob.png"],   "image/png",              False),
+    ("FT857D2.jpg", ["/FT857D2"],    "image/jpeg",             False),
+    ("redLED.jpg",  ["/redLED"],     "image/jpeg",             False),
+    ("run.gif",     ["/run"],        "image/gif",              False),
+]
+
+SHELL = "index.html"
+
+
+def strip_js_comments(text):
+    """Remove // and /* */ comments outside of string literals."""
+    out = []
+    i = 0
+    n = len(text)
+    quote = None
+    while i < n:
+        c = text[i]
+        if quote:
+            out.append(c)
+            if c == "\\" and i + 1 < n:
+                out.append(text[i + 1])
+                i += 2
+                continue
+            if c == quote:
+                quote = None
+            i += 1
+            continue
+        if c in "\"'`":
+            quote = c
+            out.append(c)
+            i += 1
+            continue
+        if text.startswith("/*", i):
+            end = text.find("*/", i + 2)
+            i = n if end < 0 else end + 2
+            continue
+        if text.startswith("//", i):
+            end = text.find("\n", i)
+            i = n if end < 0 else end
+            continue
+        out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def strip_lines(text):
+    """Drop indentation, trailing blanks and empty lines."""
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def minify_js(text):
+    return strip_lines(strip_js_comments(text))
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip() + "\n"
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    # comments inside the inline scripts, the placeholders are never inside them
+    text = re.sub(r"(<script[^>]*>)(.*?)(</script>)",
+                  lambda m: m.group(1) + strip_js_comments(m.group(2)) + m.group(3),
+                  text, flags=re.S)
+    return strip_lines(text)
+
+
+def gzip_bytes(data):
+    # mtime=0 and no file name so that the output (and its hash) is reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:HASH_LEN]
+
+
+def hashed_name(name, digest):
+    base, ext = os.path.splitext(name)
+    return "%s.%s%s" % (base, digest, ext)
+
+
+def rewrite_refs(text, urls):
+    """Replace every quoted reference to a logical url by its hashed url.
+
+    The web client refers to its assets either with or without the leading
+    '/', inside quotes (HTML attributes, escaped quotes in inline scripts)
+    or inside CSS url('...').
+    """
+    for logical, hashed in urls.items():
+        pattern = r"(?<=[\"'(])/?%s(?=\\?[\"')])" % re.escape(logical.lstrip("/"))
+        text = re.sub(pattern, hashed, text)
+    return text
+
+
+def build(src, out):
+    if os.path.isdir(out):
+        shutil.rmtree(out)
+    os.makedirs(out)
+
+    urls = {}
+    entries = []
+
+    # images first : style.css refers to them, so their hashes must be known
+    # before the css content (and therefore its own hash) is final
+    for name, logical, ctype, compress in sorted(ASSETS, key=lambda a: a[3]):
+        with open(os.path.join(src, name), "rb") as f:
+            data = f.read()
+
+        if compress:
+            text = rewrite_refs(data.decode("utf-8"), urls)
+            text = minify_css(text) if name.endswith(".css") else minify_js(text)
+            data = text.encode("utf-8")
+
+        url = "/" + hashed_name(name, content_hash(data))
+        path = url
+        if compress:
+            data = gzip_bytes(data)
+            path += ".gz"
+
+        if len(path) > SPIFFS_NAME_MAX:
+            sys.exit("%s: SPIFFS name too long (%d > %d)" % (path, len(path), SPIFFS_NAME_MAX))
+
+        with open(os.path.join(out, path.lstrip("/")), "wb") as f:
+            f.write(data)
+
+        for l in logical:
+            urls[l] = url
+            entries.append((l, url, path, ctype))
+        print("%-12s -> %-26s %7d bytes" % (name, path, len(data)))
+
+    with open(os.path.join(src, SHELL), "r", encoding="utf-8") as f:
+        shell = minify_html(rewrite_refs(f.read(), urls))
+    with open(os.path.join(out, SHELL), "w", encoding="utf-8") as f:
+        f.write(shell)
+    print("%-12s -> %-26s %7d bytes" % (SHELL, "/" + SHELL, len(shell.encode("utf-8"))))
+
+    with open(os.path.join(out, MANIFEST), "w", encoding="ascii") as f:
+        for entry in entries:
+            f.write(" ".join(entry) + "\n")
+    print("manifest     -> /%s (%d entries)" % (MANIFEST, len(entries)))
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description="Build the hashed and gzipped web client assets")
+    parser.add_argument("--src", default=os.path.join(root, "data"), help="web client sources")
+    parser.add_argument("--out", default=os.path.join(root, "build", "data"), help="SPIFFS image directory")
+    args = parser.parse_args()
+    build(args.src, args.out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+  screen_capture.py	Saves the TTGO screen of a running station as a PNG image.
+
+  The sketch streams its RAM copy of the screen run-length encoded on /screen.rle
+  (about 3 to 10 kB for the status screen instead of 97 kB for /screen.bmp).
+
+  RLE format (little endian) :
+
+    header, 8 bytes
+      0   char[4]   magic "R565"
+      4   uint16    width
+      6   uint16    height
+    runs of 3 bytes, the pixels from the top left corner, row after row
+      0   uint8     number of pixels - 1 (1 to 256 pixels, a run may continue on the next row)
+      1   uint16    RGB565 colour
+
+  Usage :
+
+    python3 tools/screen_capture.py [--host 192.168.4.1] [--out screen.png]
+    python3 tools/screen_capture.py --rle screen.rle [--out screen.png]
+"""
+
+import argparse
+import struct
+import sys
+import urllib.request
+import zlib
+
+MAGIC = b"R565"
+HEADER = struct.Struct("<4sHH")
+
+
+def decode(data):
+    if len(data) < HEADER.size:
+        sys.exit("capture too short")
+    magic, width, height = HEADER.unpack_from(data)
+    if magic != MAGIC:
+        sys.exit("not a screen capture (magic %r)" % magic)
+    pixels = []
+    for pos in range(HEADER.size, len(data) - 2, 3):
+        count = data[pos] + 1
+        colour = data[pos + 1] | data[pos + 2] << 8
+        pixels.extend([colour] * count)
+    if len(pixels) != width * height:
+        sys.exit("capture has %d pixels instead of %d" % (len(pixels), width * height))
+    return width, height, pixels
+
+
+def rgb888(colour):
+    r, g, b = colour >> 11, (colour >> 5) & 0x3F, colour & 0x1F
+    return bytes(((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)))
+
+
+def png_chunk(kind, body):
+    return struct.pack(">I", len(body)) + kind + body + struct.pack(">I", zlib.crc32(kind + body))
+
+
+def write_png(path, width, height, pixels):
+    raw = bytearray()
+    for y in range(height):
+        raw.append(0)  # no filter
+        for colour in pixels[y * width:(y + 1) * width]:
+            raw += rgb888(colour)
+    with open(path, "wb") as f:
+        f.write(b"\x89PNG\r\n\x1a\n")
+        f.write(png_chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)))
+        f.write(png_chunk(b"IDAT", zlib.compress(bytes(raw), 9)))
+        f.write(png_chunk(b"IEND", b""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Saves the TTGO screen as a PNG image")
+    parser.add_argument("--host", default="192.168.4.1", help="address of the ESP32")
+    parser.add_argument("--rle", help="decode this file instead of downloading the capture")
+    parser.add_argument("--out", default="screen.png")
+    args = parser.parse_args()
+
+    if args.rle:
+        with open(args.rle, "rb") as f:
+            data = f.read()
+    else:
+        with urllib.request.urlopen("http://%s/screen.rle" % args.host, timeout=10) as response:
+            data = response.read()
+
+    width, height, pixels = decode(data)
+    write_png(args.out, width, height, pixels)
+    print("%s : %d x %d pixels, %d bytes captured" % (args.out, width, height, len(data)))
+
+
+if __name__ == "__main__":
+    main()